@@ -14,238 +14,443 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <math.h>
+#include <limits.h>
 #include <libgen.h>
+#include <getopt.h>
+#include "AnalyzeProtein.h"
+#include "coordStore.h"
+#include "coordKernels.h"
+#include "threadPool.h"
+#include "batchAnalysis.h"
+#include "pdbReader.h"
+#include "streamStats.h"
+#include "coordCache.h"
+#include "trajectory.h"
+#include "contacts.h"
+#include "rmsdMatrix.h"
+#include "atomSelection.h"
+#include "profiler.h"
 
 
 /* -- Constants --- */
 
-/** Maximum number of rows in the pdb file. */
-#define MAX_ROWS 20000
+/** Dmax engine - compare every pair of atoms, used as a reference. */
+#define DMAX_BRUTE "brute"
 
-/** Maximum number of characters in a line. */
-#define MAX_LINE_SIZE 200
+/** Dmax engine - compare only the atoms on the convex hull. */
+#define DMAX_HULL "hull"
 
-/** How many coordinates are there (x, y, z). */
-#define COORD_NUM 3
+/** Maximum number of threads. */
+#define MAX_THREADS 1024
 
-/** X coordinate position. */
-#define X_POS 0
+/** Default number of reader threads in batch mode. */
+#define DEFAULT_READERS 2
 
-/** Y coordinate position. */
-#define Y_POS 1
+/** The path that means the standard input in stream mode. */
+#define STDIN_PATH "-"
 
-/** Z coordinate position. */
-#define Z_POS 2
 
-/** How every row that matters for calculations should start. */
-#define ROW_START "ATOM  "
-
-/** Where the x value starts in the line. */
-#define X_VALUE_START 30
+/* --- Functions --- */
 
-/** Where the y value starts in the line. */
-#define Y_VALUE_START 38
+int loadFile(const struct AnalysisOptions* options, const char* path, struct CoordStore* store, FILE* errors,
+             struct FileProfile* profile)
+{
+	FILE* file;
+	struct CacheKey key;
+	struct PhaseClock clock;
+	int isCacheable = 0;
+	int ret;
 
-/** Where the z value starts in the line. */
-#define Z_VALUE_START 46
+	startPhase(profile, NULL, &clock);
+	file = fopen(path, "r");
+	if(!file)
+	{
+		ret = errno;
+		fprintf(errors, "Error opening file: %s\n", path);
+		return -ret;
+	}
 
-/** Where the values end. */
-#define VALUES_END 53
+	if (options->useCache && getCacheKey(file, &key) == 0)
+	{
+		isCacheable = 1;
+		ret = readCache(path, &key, store);
+		if (ret != 0)
+		{
+			fclose(file);
+			stopPhase(profile, &clock, PHASE_READ);
+			return ret;
+		}
+	}
+	stopPhase(profile, &clock, PHASE_READ);
 
-/** Minimum line length. */
-#define MINIMUM_LINE_LENGTH 61
+	startPhase(profile, NULL, &clock);
+	ret = readMappedValues(file, store, errors);
+	stopPhase(profile, &clock, PHASE_PARSE);
+	countProfiledFile(profile, file, ret);
 
-/** The number of characters in each value. */
-#define VALUE_LENGTH 8
+	fclose(file);
 
-/** An error number if the line is too short. */
-#define ERRSHORT -1;
+	if (ret > 0 && isCacheable)
+	{
+		// the cache only saves time, the results are fine without it
+		writeCache(path, &key, store);
+	}
 
+	if (ret == 0)
+	{
+		fprintf(errors, "Error - 0 atoms were found in the file %s\n", path);
+	}
+	return ret;
+}
 
-/* --- Functions --- */
+/**
+ * Prints a 3x3 matrix in one line, row after row.
+ *
+ * @param name the name of the matrix.
+ * @param matrix the matrix, row major.
+ */
+void printMatrix(const char* name, const float matrix[COORD_NUM * COORD_NUM])
+{
+	printf("%s = %.3f %.3f %.3f, %.3f %.3f %.3f, %.3f %.3f %.3f\n", name, matrix[0], matrix[1], matrix[2],
+	       matrix[3], matrix[4], matrix[5], matrix[6], matrix[7], matrix[8]);
+}
 
 /**
- * Parses a value of VALUE_LENGTH from given line.
- * 
- * @param line the line to parse from.
- * @param valueStart the position of the value.
- * @return The parsed value. In case of error, returns 0 and sets errno.
+ * Prints the shape of a file.
+ *
+ * @param shape the shape to print.
  */
-float parseValue(char* line, int valueStart)
+void printShape(const struct ShapeStats* shape)
 {
-	char* endPtr;
-	char tempString[VALUE_LENGTH + 1];
-	float value;
-	memset(tempString, '\0', VALUE_LENGTH);
-	strncpy(tempString, line + valueStart, VALUE_LENGTH);
-	value = strtof(tempString, &endPtr);
-	if (endPtr == tempString)
+	printf("Box = %.3f %.3f %.3f to %.3f %.3f %.3f\n", shape->boxMinimum[X_POS], shape->boxMinimum[Y_POS],
+	       shape->boxMinimum[Z_POS], shape->boxMaximum[X_POS], shape->boxMaximum[Y_POS], shape->boxMaximum[Z_POS]);
+	printf("Oriented box = %.3f x %.3f x %.3f\n",
+	       shape->orientedBoxMaximum[X_POS] - shape->orientedBoxMinimum[X_POS],
+	       shape->orientedBoxMaximum[Y_POS] - shape->orientedBoxMinimum[Y_POS],
+	       shape->orientedBoxMaximum[Z_POS] - shape->orientedBoxMinimum[Z_POS]);
+	printMatrix("Gyration tensor", shape->gyrationTensor);
+	printMatrix("Inertia tensor", shape->inertiaTensor);
+	printf("Principal moments = %.3f %.3f %.3f\n", shape->principalMoments[X_POS], shape->principalMoments[Y_POS],
+	       shape->principalMoments[Z_POS]);
+	printMatrix("Principal axes", shape->principalAxes);
+	printf("Asphericity = %.3f\n", shape->asphericity);
+}
+
+void printStats(const char* path, const struct ProteinStats* stats)
+{
+	printf("PDB file %s, %d atoms were read\n", path, stats->numOfAtoms);
+	printf("Cg = %.3f %.3f %.3f\n", stats->centerOfGravity[X_POS], stats->centerOfGravity[Y_POS],
+	       stats->centerOfGravity[Z_POS]);
+	printf("Rg = %.3f\n", stats->turnRadius);
+	if (stats->maxDistanceBound > stats->maxDistance)
 	{
-		errno = EINVAL; 
-		fprintf(stderr, "Error in coordinate conversion %s!\n", tempString);
+		printf("Dmax = %.3f (approximate, at most %.3f)\n", stats->maxDistance, stats->maxDistanceBound);
+	}
+	else
+	{
+		printf("Dmax = %.3f\n", stats->maxDistance);
+	}
+	if (stats->hasShape)
+	{
+		printShape(&stats->shape);
 	}
-	return value;
 }
 
 /**
- * Reads the values from the given file into the given array.
- * 
- * @param file the file to read from.
- * @param dataArray the output array.
- * @param maxLines the maximum number of lines to read.
- * @return positive integer - how many lines were read.
- *         negative integer - an error code.
+ * Reads a file into the store, analyzes it and prints the statistics.
+ *
+ * @param options how to calculate.
+ * @param path the path of the file.
+ * @param store a scratch store for the atoms.
+ * @param hullStore a scratch store for the hull points.
+ * @param profiler receives the profile of the file, NULL to not profile it.
+ * @return 0 on success, the exit code otherwise.
  */
-int readValues(FILE* file, float dataArray[][COORD_NUM], int maxLines)
+int analyzeFile(const struct AnalysisOptions* options, const char* path, struct CoordStore* store,
+                struct CoordStore* hullStore, struct Profiler* profiler)
 {
-	char line[MAX_LINE_SIZE];
-	float xValue, yValue, zValue;
-	int curLine = 0;
+	struct ProteinStats stats;
+	struct FileProfile* profile = NULL;
+	int ret;
 
-	while(fgets(line, MAX_LINE_SIZE, file) != NULL && curLine < maxLines)
+	if (profiler)
 	{
-
-		if(strncmp(line, ROW_START, sizeof(ROW_START) - 1) != 0)
-		{
-			// Row doesn't start with the right word
-			continue;
-		}
-		if(strlen(line) < MINIMUM_LINE_LENGTH)
+		profile = addProfile(profiler, path);
+		if (!profile)
 		{
-			fprintf(stderr, "ATOM line is too short %ld characters\n", strlen(line));
-			return ERRSHORT;
+			fprintf(stderr, "Not enough memory for the profile of %s\n", path);
+			return ENOMEM;
 		}
-		xValue = parseValue(line, X_VALUE_START);
-		if (xValue == 0 && errno != 0)
-		{
-			return -errno;
-		}
-		yValue = parseValue(line, Y_VALUE_START);
-		if (yValue == 0 && errno != 0)
+	}
+	ret = loadFile(options, path, store, stderr, profile);
+	if (ret <= 0)
+	{
+		return ret < 0 ? -ret : 1;
+	}
+	if (profile)
+	{
+		profileStore(options, store, hullStore, &stats, profile);
+	}
+	else
+	{
+		analyzeStore(options, store, hullStore, &stats);
+	}
+	printStats(path, &stats);
+	return 0;
+}
+
+/**
+ * Analyzes a file in a single pass, without keeping the atoms.
+ * Dmax is estimated from the sampled atoms, so it is a lower bound.
+ *
+ * @param options how to calculate.
+ * @param path the path of the file, STDIN_PATH for the standard input.
+ * @param stats the stream statistics, reset before reading.
+ * @param sampleStore a scratch store for the sampled atoms.
+ * @param hullStore a scratch store for the hull points.
+ * @return 0 on success, the exit code otherwise.
+ */
+int analyzeStream(const struct AnalysisOptions* options, const char* path, struct StreamStats* stats,
+                  struct CoordStore* sampleStore, struct CoordStore* hullStore)
+{
+	FILE* file;
+	struct AtomSink sink;
+	float centerOfGravity[COORD_NUM];
+	float maxDistance;
+	long ret;
+
+	if (strcmp(path, STDIN_PATH) == 0)
+	{
+		file = stdin;
+	}
+	else
+	{
+		file = fopen(path, "r");
+		if(!file)
 		{
-			return -errno;
+			ret = errno;
+			fprintf(stderr, "Error opening file: %s\n", path);
+			return (int) ret;
 		}
-		zValue = parseValue(line, Z_VALUE_START);
-		if (zValue == 0 && errno != 0)
+	}
+
+	resetStreamStats(stats);
+	sink.addAtom = addStreamAtom;
+	sink.endModel = NULL;
+	sink.context = stats;
+	sink.includeHetatm = 0;
+	ret = streamValues(file, &sink, stderr);
+	if (file != stdin)
+	{
+		fclose(file);
+	}
+	if (ret < 0)
+	{
+		return (int) -ret;
+	}
+	if (ret == 0)
+	{
+		fprintf(stderr, "Error - 0 atoms were found in the file %s\n", path);
+		return 1;
+	}
+
+	streamCenterOfGravity(stats, centerOfGravity);
+	printf("PDB file %s, %ld atoms were read\n", path, stats->numOfAtoms);
+	printf("Cg = %.3f %.3f %.3f\n", centerOfGravity[X_POS], centerOfGravity[Y_POS], centerOfGravity[Z_POS]);
+	printf("Rg = %.3f\n", streamTurnRadius(stats));
+	if (stats->sampleSize > 0)
+	{
+		ret = copyStreamSample(stats, sampleStore);
+		if (ret < 0)
 		{
-			return -errno;
+			fprintf(stderr, "Not enough memory for %d atoms\n", stats->sampleSize);
+			return (int) -ret;
 		}
-		dataArray[curLine][X_POS] = xValue;
-		dataArray[curLine][Y_POS] = yValue;
-		dataArray[curLine][Z_POS] = zValue;
-		curLine++;
+		maxDistance = calculateMaxDistanceHull(options->pool, options->kernels, sampleStore, hullStore);
+		printf("Dmax >= %.3f (sample of %ld atoms)\n", maxDistance, ret);
 	}
+	return 0;
+}
 
-	return curLine;
-	
+/**
+ * Parses a pdb file and writes its cache, without analyzing it.
+ *
+ * @param path the path of the file.
+ * @param store a scratch store for the atoms.
+ * @return 0 on success, the exit code otherwise.
+ */
+int buildCache(const char* path, struct CoordStore* store)
+{
+	FILE* file;
+	struct CacheKey key;
+	int ret;
+
+	file = fopen(path, "r");
+	if(!file)
+	{
+		ret = errno;
+		fprintf(stderr, "Error opening file: %s\n", path);
+		return ret;
+	}
+	ret = getCacheKey(file, &key);
+	if (ret == 0)
+	{
+		ret = readMappedValues(file, store, stderr);
+	}
+	else
+	{
+		fprintf(stderr, "Error - %s is not a regular file\n", path);
+	}
+	fclose(file);
+	if (ret < 0)
+	{
+		return -ret;
+	}
+	if (ret == 0)
+	{
+		fprintf(stderr, "Error - 0 atoms were found in the file %s\n", path);
+		return 1;
+	}
+
+	ret = writeCache(path, &key, store);
+	if (ret < 0)
+	{
+		fprintf(stderr, "Error writing the cache file: %s%s\n", path, CACHE_EXTENSION);
+		return -ret;
+	}
+	printf("PDB file %s, %d atoms were cached\n", path, store->size);
+	return 0;
 }
 
 /**
- * Calculates the distance between two give points.
- * 
- * @param point1 the first point.
- * @param point2 the second point.
- * @return The distance between the points.
+ * Prints the usage message and exits.
+ *
+ * @param programPath the path of the program, argv[0].
  */
-float calculateDistance(float point1[COORD_NUM], float point2[COORD_NUM])
+void printUsage(char* programPath)
 {
-	float distance;
-	float xDistance, yDistance, zDistance;
-	xDistance = powf(point1[X_POS] - point2[X_POS], 2);
-	yDistance = powf(point1[Y_POS] - point2[Y_POS], 2);
-	zDistance = powf(point1[Z_POS] - point2[Z_POS], 2);
-	distance = sqrtf(xDistance + yDistance + zDistance);
-	return distance;
+	fprintf(stderr, "Usage: %s [-j threads] [--dmax=%s|%s] [--dmax-eps=e] [--kernels=%s|%s|%s] [--cache] [--profile] [--shape] [mode] <pdb1> <pdb2> ...\n"
+	        "Modes:\n"
+	        "  --batch [--readers=threads]\n"
+	        "  --stream [--sample=atoms]\n"
+	        "  --build-cache\n"
+	        "  --models\n"
+	        "  --contacts=cutoff [--contact-map]\n"
+	        "  --rmsd [--rmsd-reference=pdb] [--rmsd-binary=file]\n"
+	        "  [--chain=ids] [--residues=first-last] [--atom=name,...] [--hetatm] [--group=%s|%s]\n",
+	        basename(programPath), DMAX_HULL, DMAX_BRUTE, KERNELS_AVX2, KERNELS_SSE, KERNELS_SCALAR,
+	        GROUP_BY_CHAIN, GROUP_BY_RESIDUE);
+	exit(1);
 }
 
 /**
- * Calcualtes the center of gravity of the given points.
+ * Parses a sample size argument.
  *
- * @param dataArray an array of points, each represented as (x, y, z).
- * @param numOfPoints how many points are in the given array.
- * @param centerOfGravity the output array, representing (x, y, z).
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The sample size. Exits on invalid arguments.
  */
-void calculateCenterOfGravity(float dataArray[][COORD_NUM], int numOfPoints, float centerOfGravity[3])
+int parseSampleSize(char* arg, char* programPath)
 {
-	float xSum, ySum, zSum;
-	int i;
+	char* endPtr;
+	long sampleSize;
 
-	if (numOfPoints == 0)
+	sampleSize = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || sampleSize < 0 || sampleSize > INT_MAX / 2)
 	{
-		centerOfGravity[X_POS] = 0.0f;
-		centerOfGravity[Y_POS] = 0.0f;
-		centerOfGravity[Z_POS] = 0.0f;
-		return;
+		printUsage(programPath);
 	}
+	return (int) sampleSize;
+}
 
-	xSum = 0.0f;
-	ySum = 0.0f;
-	zSum = 0.0f;
+/**
+ * Parses a cutoff distance argument.
+ *
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The cutoff. Exits on invalid arguments.
+ */
+float parseCutoff(char* arg, char* programPath)
+{
+	char* endPtr;
+	float cutoff;
 
-	for(i = 0; i < numOfPoints; i++)
+	cutoff = strtof(arg, &endPtr);
+	if (endPtr == arg || *endPtr != '\0' || !(cutoff > 0) || isinf(cutoff))
 	{
-		xSum += dataArray[i][X_POS];
-		ySum += dataArray[i][Y_POS];
-		zSum += dataArray[i][Z_POS];
+		printUsage(programPath);
 	}
+	return cutoff;
+}
+
+/**
+ * Parses a relative error argument.
+ *
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The relative error, between 0 and 1. Exits on invalid arguments.
+ */
+float parseEpsilon(char* arg, char* programPath)
+{
+	char* endPtr;
+	float epsilon;
 
-	centerOfGravity[X_POS] = xSum / numOfPoints;
-	centerOfGravity[Y_POS] = ySum / numOfPoints;
-	centerOfGravity[Z_POS] = zSum / numOfPoints;
+	epsilon = strtof(arg, &endPtr);
+	if (endPtr == arg || *endPtr != '\0' || !(epsilon > 0) || !(epsilon < 1))
+	{
+		printUsage(programPath);
+	}
+	return epsilon;
 }
 
 /**
- * Calcualtes the turn radius of the given points.
+ * Parses a residue range argument, first-last or a single residue number.
  *
- * @param dataArray an array of points, each represented as (x, y, z).
- * @param numOfPoints how many points are in the given array.
- * @param centerOfGravity the center of gravity of the points.
- * @return The turn radius.
+ * @param arg the argument.
+ * @param filter the output filter.
+ * @param programPath the path of the program, for the usage message.
  */
-float calculateTurnRadius(float dataArray[][COORD_NUM], int numOfPoints, float centerOfGravity[COORD_NUM])
+void parseResidueRange(char* arg, struct AtomFilter* filter, char* programPath)
 {
-	float sum = 0;
-	float distance;
-	int i;
+	char* endPtr;
+	char* last;
 
-	if (numOfPoints == 0)
+	filter->hasResidueRange = 1;
+	filter->firstResidue = (int) strtol(arg, &endPtr, 10);
+	filter->lastResidue = filter->firstResidue;
+	if (endPtr != arg && *endPtr == '-')
 	{
-		return 0;
+		last = endPtr + 1;
+		filter->lastResidue = (int) strtol(last, &endPtr, 10);
+		if (endPtr == last)
+		{
+			printUsage(programPath);
+		}
 	}
-	for(i = 0; i < numOfPoints; i++)
+	if (endPtr == arg || *endPtr != '\0' || filter->firstResidue > filter->lastResidue)
 	{
-		distance = calculateDistance(dataArray[i], centerOfGravity);
-		sum += pow(distance, 2);
+		printUsage(programPath);
 	}
-	return sqrtf(sum / numOfPoints);
 }
 
 /**
- * Calcualtes the maximum distance between all given points.
+ * Parses a number of threads argument.
  *
- * @param dataArray an array of points, each represented as (x, y, z).
- * @param numOfPoints how many points are in the given array.
- * @return The maxium distance between the points.
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The number of threads. Exits on invalid arguments.
  */
-float calculateMaxDistance(float dataArray[][COORD_NUM], int numOfRows)
+int parseThreads(char* arg, char* programPath)
 {
-	int i;
-	int j;
-	float distance;
-	float maxDistance = 0;
+	char* endPtr;
+	long numOfThreads;
 
-	for(i = 0; i < numOfRows; i++)
+	numOfThreads = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || numOfThreads < 1 || numOfThreads > MAX_THREADS)
 	{
-		for(j = i + 1; j < numOfRows; j++)
-		{
-			distance = calculateDistance(dataArray[i], dataArray[j]);
-			if (distance > maxDistance)
-			{
-				maxDistance = distance;
-			}
-		}
+		printUsage(programPath);
 	}
-	return maxDistance;
+	return (int) numOfThreads;
 }
 
 
@@ -262,58 +467,295 @@ float calculateMaxDistance(float dataArray[][COORD_NUM], int numOfRows)
 int main(int argc, char *argv[])
 {
 	int i;
-	float dataArray[MAX_ROWS][COORD_NUM];
-	char* dataFilePath;
-	FILE* file;
-	int ret;
-	int numOfRows;
-	float centerOfGravity[3];
-	float turnRadius;
-	float maxDistance;
+	struct CoordStore* store = NULL;
+	struct CoordStore* hullStore = NULL;
+	struct AnalysisOptions options;
+	struct StreamStats streamStats;
+	int hasStreamStats = 0;
+	int sampleSize = DEFAULT_SAMPLE_SIZE;
+	int numOfThreads = 1;
+	int numOfReaders = DEFAULT_READERS;
+	int isBatch = 0;
+	int isStream = 0;
+	int isBuildCache = 0;
+	int isModels = 0;
+	int isContacts = 0;
+	int isResidueMap = 0;
+	float cutoff = 0;
+	int isRmsd = 0;
+	char* referencePath = NULL;
+	char* binaryPath = NULL;
+	struct AtomFilter filter;
+	int grouping = GROUP_NONE;
+	int isSelection = 0;
+	struct Profiler profiler;
+	int isProfile = 0;
+	int ret = 0;
+	int option;
+	static struct option longOptions[] = {
+		{"dmax", required_argument, NULL, 'd'},
+		{"dmax-eps", required_argument, NULL, 'e'},
+		{"kernels", required_argument, NULL, 'k'},
+		{"threads", required_argument, NULL, 'j'},
+		{"batch", no_argument, NULL, 'b'},
+		{"readers", required_argument, NULL, 'r'},
+		{"stream", no_argument, NULL, 's'},
+		{"sample", required_argument, NULL, 'n'},
+		{"cache", no_argument, NULL, 'c'},
+		{"build-cache", no_argument, NULL, 'C'},
+		{"models", no_argument, NULL, 'm'},
+		{"contacts", required_argument, NULL, 't'},
+		{"contact-map", no_argument, NULL, 'M'},
+		{"rmsd", no_argument, NULL, 'R'},
+		{"rmsd-reference", required_argument, NULL, 'f'},
+		{"rmsd-binary", required_argument, NULL, 'o'},
+		{"chain", required_argument, NULL, 'A'},
+		{"residues", required_argument, NULL, 'N'},
+		{"atom", required_argument, NULL, 'a'},
+		{"hetatm", no_argument, NULL, 'H'},
+		{"group", required_argument, NULL, 'g'},
+		{"profile", no_argument, NULL, 'P'},
+		{"shape", no_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+
+	options.kernels = selectKernels();
+	options.pool = NULL;
+	options.useHull = 1;
+	options.dmaxEpsilon = 0;
+	options.useCache = 0;
+	options.useShape = 0;
+	memset(&filter, 0, sizeof(filter));
+	initProfiler(&profiler);
+
+	while ((option = getopt_long(argc, argv, "j:", longOptions, NULL)) != -1)
+	{
+		if (option == 'd' && strcmp(optarg, DMAX_HULL) == 0)
+		{
+			options.useHull = 1;
+		}
+		else if (option == 'd' && strcmp(optarg, DMAX_BRUTE) == 0)
+		{
+			options.useHull = 0;
+		}
+		else if (option == 'e')
+		{
+			options.dmaxEpsilon = parseEpsilon(optarg, argv[0]);
+		}
+		else if (option == 'k' && findKernels(optarg) != NULL)
+		{
+			options.kernels = findKernels(optarg);
+		}
+		else if (option == 'j')
+		{
+			numOfThreads = parseThreads(optarg, argv[0]);
+		}
+		else if (option == 'b')
+		{
+			isBatch = 1;
+		}
+		else if (option == 'r')
+		{
+			numOfReaders = parseThreads(optarg, argv[0]);
+		}
+		else if (option == 's')
+		{
+			isStream = 1;
+		}
+		else if (option == 'n')
+		{
+			sampleSize = parseSampleSize(optarg, argv[0]);
+		}
+		else if (option == 'c')
+		{
+			options.useCache = 1;
+		}
+		else if (option == 'C')
+		{
+			isBuildCache = 1;
+		}
+		else if (option == 'm')
+		{
+			isModels = 1;
+		}
+		else if (option == 't')
+		{
+			isContacts = 1;
+			cutoff = parseCutoff(optarg, argv[0]);
+		}
+		else if (option == 'M')
+		{
+			isResidueMap = 1;
+		}
+		else if (option == 'R')
+		{
+			isRmsd = 1;
+		}
+		else if (option == 'f')
+		{
+			isRmsd = 1;
+			referencePath = optarg;
+		}
+		else if (option == 'o')
+		{
+			isRmsd = 1;
+			binaryPath = optarg;
+		}
+		else if (option == 'A')
+		{
+			isSelection = 1;
+			filter.chains = optarg;
+		}
+		else if (option == 'N')
+		{
+			isSelection = 1;
+			parseResidueRange(optarg, &filter, argv[0]);
+		}
+		else if (option == 'a')
+		{
+			isSelection = 1;
+			filter.atomNames = optarg;
+		}
+		else if (option == 'H')
+		{
+			isSelection = 1;
+			filter.includeHetatm = 1;
+		}
+		else if (option == 'g' && strcmp(optarg, GROUP_BY_CHAIN) == 0)
+		{
+			isSelection = 1;
+			grouping = GROUP_CHAIN;
+		}
+		else if (option == 'g' && strcmp(optarg, GROUP_BY_RESIDUE) == 0)
+		{
+			isSelection = 1;
+			grouping = GROUP_RESIDUE;
+		}
+		else if (option == 'P')
+		{
+			isProfile = 1;
+		}
+		else if (option == 'S')
+		{
+			options.useShape = 1;
+		}
+		else
+		{
+			printUsage(argv[0]);
+		}
+	}
 
-	if (argc < 2)
+	if (optind >= argc)
 	{
-		fprintf(stderr, "Usage: %s <pdb1> <pdb2> ...\n", basename(argv[0]));
-		exit(1);
+		printUsage(argv[0]);
 	}
 
-	for(i = 1; i < argc; i++)
+	if (isBatch + isStream + isBuildCache + isModels + isContacts + isRmsd + isSelection > 1 ||
+	    (isResidueMap && !isContacts))
 	{
-		dataFilePath = argv[i];
-		file = fopen(dataFilePath, "r");
-		if(!file)
+		printUsage(argv[0]);
+	}
+
+	// the phases are timed where whole files are loaded and analyzed, one file after another or in a batch
+	if (isProfile && (isStream || isBuildCache || isModels || isContacts || isRmsd || isSelection))
+	{
+		printUsage(argv[0]);
+	}
+
+	// the shape is printed with the statistics of whole files only
+	if (options.useShape && (isStream || isBuildCache || isModels || isContacts || isRmsd || grouping != GROUP_NONE))
+	{
+		printUsage(argv[0]);
+	}
+
+	if (isBatch)
+	{
+		// the files are spread over the threads, each file is analyzed on a single thread
+		ret = analyzeBatch(argv + optind, argc - optind, &options, numOfReaders, numOfThreads,
+		                   isProfile ? &profiler : NULL);
+		if (isProfile)
 		{
-			fprintf(stderr, "Error opening file: %s\n", dataFilePath);
-			return errno;
+			printProfile(&profiler, stderr);
 		}
+		cleanupProfiler(&profiler);
+		return ret;
+	}
 
-		ret = readValues(file, dataArray, MAX_ROWS);
-
-		fclose(file);
+	// one store is reused for all the files
+	store = coordStoreAlloc(NULL);
+	hullStore = coordStoreAlloc(NULL);
+	if (numOfThreads > 1)
+	{
+		options.pool = threadPoolAlloc(numOfThreads);
+	}
+	if (!store || !hullStore || (numOfThreads > 1 && !options.pool))
+	{
+		fprintf(stderr, "Error allocating the atoms store\n");
+		ret = ENOMEM;
+	}
 
-		if (ret < 0)
+	// only the sample is kept in stream mode, the store holds it for the Dmax search
+	if (ret == 0 && isStream)
+	{
+		if (initStreamStats(&streamStats, sampleSize) < 0)
 		{
-			return -ret;
+			fprintf(stderr, "Error allocating the atoms store\n");
+			ret = ENOMEM;
 		}
-		if (ret == 0)
+		else
 		{
-			fprintf(stderr, "Error - 0 atoms were found in the file %s\n", dataFilePath);
-			return 1;
+			hasStreamStats = 1;
 		}
+	}
 
-		numOfRows = ret;
-
-		printf("PDB file %s, %d atoms were read\n", dataFilePath, numOfRows);
-
-		calculateCenterOfGravity(dataArray, numOfRows, centerOfGravity);
-		printf("Cg = %.3f %.3f %.3f\n", centerOfGravity[X_POS], centerOfGravity[Y_POS], centerOfGravity[Z_POS]);
-
-		turnRadius = calculateTurnRadius(dataArray, numOfRows, centerOfGravity);
-		printf("Rg = %.3f\n", turnRadius);
+	if (ret == 0 && isRmsd)
+	{
+		// all the files are compared together, the pool runs the pairs
+		ret = analyzeRmsd(&options, argv + optind, argc - optind, referencePath, binaryPath);
+	}
 
-		maxDistance = calculateMaxDistance(dataArray, numOfRows);
-		printf("Dmax = %.3f\n", maxDistance);
+	for(i = optind; i < argc && ret == 0 && !isRmsd; i++)
+	{
+		if (isStream)
+		{
+			ret = analyzeStream(&options, argv[i], &streamStats, store, hullStore);
+		}
+		else if (isBuildCache)
+		{
+			ret = buildCache(argv[i], store);
+		}
+		else if (isModels)
+		{
+			// one model at a time, the store is reused for all of them
+			ret = analyzeTrajectory(&options, argv[i], store, hullStore);
+		}
+		else if (isContacts)
+		{
+			ret = analyzeContacts(&options, argv[i], cutoff, isResidueMap, store);
+		}
+		else if (isSelection)
+		{
+			// the atoms are filtered and grouped as they are read
+			ret = analyzeSelection(&options, argv[i], &filter, grouping, store, hullStore);
+		}
+		else
+		{
+			ret = analyzeFile(&options, argv[i], store, hullStore, isProfile ? &profiler : NULL);
+		}
 	}
-	return 0;
+	if (isProfile)
+	{
+		// the files done so far are printed even if one failed
+		printProfile(&profiler, stderr);
+	}
+	cleanupProfiler(&profiler);
+	if (hasStreamStats)
+	{
+		cleanupStreamStats(&streamStats);
+	}
+	freeCoordStore(&store);
+	freeCoordStore(&hullStore);
+	freeThreadPool(&options.pool);
+	return ret;
 	
 }
@@ -0,0 +1,49 @@
+/**
+ * @file AnalyzeProtein.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Shared definitions for the protein analysis program.
+ */
+
+#ifndef ANALYZE_PROTEIN_H
+#define ANALYZE_PROTEIN_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include "storeAnalysis.h"
+
+
+/* --- Structs --- */
+
+struct FileProfile;
+
+
+/* --- Functions --- */
+
+/**
+ * Reads the atoms of a pdb file into the given store.
+ * Problems are reported to the given stream.
+ *
+ * @param options how to read, only useCache is used.
+ * @param path the path of the file.
+ * @param store the output store.
+ * @param errors the stream to report problems to.
+ * @param profile the profile of the file, receives the read and parse phases, NULL to not profile it.
+ * @return positive integer - how many atoms were read.
+ *         0 - there are no atoms in the file.
+ *         negative integer - an error code.
+ */
+int loadFile(const struct AnalysisOptions* options, const char* path, struct CoordStore* store, FILE* errors,
+             struct FileProfile* profile);
+
+/**
+ * Prints the statistics of a file.
+ *
+ * @param path the path of the file.
+ * @param stats the statistics to print.
+ */
+void printStats(const char* path, const struct ProteinStats* stats);
+
+#endif
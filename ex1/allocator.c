@@ -0,0 +1,43 @@
+/**
+ * @file allocator.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the memory allocator.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include "allocator.h"
+
+
+/* --- Functions --- */
+
+void* allocateMemory(const struct Allocator* allocator, size_t size)
+{
+	if (!allocator)
+	{
+		return malloc(size);
+	}
+	return allocator->allocate(allocator->context, size);
+}
+
+void* resizeMemory(const struct Allocator* allocator, void* block, size_t size)
+{
+	if (!allocator)
+	{
+		return realloc(block, size);
+	}
+	return allocator->resize(allocator->context, block, size);
+}
+
+void releaseMemory(const struct Allocator* allocator, void* block)
+{
+	if (!allocator)
+	{
+		free(block);
+		return;
+	}
+	allocator->release(allocator->context, block);
+}
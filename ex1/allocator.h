@@ -0,0 +1,85 @@
+/**
+ * @file allocator.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the memory allocator used by the library.
+ * A NULL allocator stands for malloc, realloc and free.
+ */
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+
+/* --- Includes --- */
+
+#include <stddef.h>
+
+
+/* --- Structs --- */
+
+/**
+ * A memory allocator supplied by the caller.
+ * The blocks must be aligned like the blocks of malloc.
+ */
+struct Allocator
+{
+	/**
+	 * Allocates a block, like malloc.
+	 *
+	 * @param context the allocator's context.
+	 * @param size the size of the block.
+	 * @return The block, or NULL if there's no memory.
+	 */
+	void* (*allocate)(void* context, size_t size);
+
+	/**
+	 * Resizes a block, like realloc.
+	 *
+	 * @param context the allocator's context.
+	 * @param block the block, NULL to allocate a new one.
+	 * @param size the new size of the block.
+	 * @return The resized block, or NULL if there's no memory and the block is unchanged.
+	 */
+	void* (*resize)(void* context, void* block, size_t size);
+
+	/**
+	 * Releases a block, like free.
+	 *
+	 * @param context the allocator's context.
+	 * @param block the block, may be NULL.
+	 */
+	void (*release)(void* context, void* block);
+	void* context;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Allocates a block.
+ *
+ * @param allocator the allocator, NULL for malloc.
+ * @param size the size of the block.
+ * @return The block, or NULL if there's no memory.
+ */
+void* allocateMemory(const struct Allocator* allocator, size_t size);
+
+/**
+ * Resizes a block.
+ *
+ * @param allocator the allocator, NULL for realloc.
+ * @param block the block, NULL to allocate a new one.
+ * @param size the new size of the block.
+ * @return The resized block, or NULL if there's no memory and the block is unchanged.
+ */
+void* resizeMemory(const struct Allocator* allocator, void* block, size_t size);
+
+/**
+ * Releases a block.
+ *
+ * @param allocator the allocator, NULL for free.
+ * @param block the block, may be NULL.
+ */
+void releaseMemory(const struct Allocator* allocator, void* block);
+
+#endif
@@ -0,0 +1,415 @@
+/**
+ * @file atomSelection.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the atom selection.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "atomSelection.h"
+#include "coordStore.h"
+#include "pdbReader.h"
+
+
+/* --- Constants --- */
+
+/** The characters that identify a residue, from the name to the insertion code. */
+#define RESIDUE_KEY_LENGTH (INSERTION_POSITION + 1 - RESIDUE_NAME_START)
+
+/** How many chain identifiers there can be, one for every character. */
+#define NUM_OF_CHAIN_IDS 256
+
+/** Marks a chain without a group. */
+#define NO_GROUP (-1)
+
+
+/* --- Structs --- */
+
+/** A group of atoms, a chain or a residue. */
+struct AtomGroup
+{
+	char residueName[RESIDUE_NAME_LENGTH + 1];
+	char chain;
+	int residueNumber;
+	char insertion;
+	// where the atoms of the group start in the store, once they are sorted
+	int start;
+	int size;
+};
+
+/** The state of reading the selected atoms, the context of its atom sink. */
+struct SelectionReader
+{
+	const struct AtomFilter* filter;
+	int grouping;
+	struct CoordStore* store;
+	// the group of every atom, an index into groups
+	int* atomGroups;
+	int atomCapacity;
+	struct AtomGroup* groups;
+	int numOfGroups;
+	int groupCapacity;
+	int chainGroups[NUM_OF_CHAIN_IDS];
+	char lastKey[RESIDUE_KEY_LENGTH];
+	// whether the atoms of every group are next to each other in the store
+	int isSorted;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Reads the residue number of an ATOM line.
+ *
+ * @param line the line.
+ * @return The residue number.
+ */
+static int parseResidueNumber(const char* line)
+{
+	char number[RESIDUE_NUMBER_LENGTH + 1];
+
+	memcpy(number, line + RESIDUE_NUMBER_START, RESIDUE_NUMBER_LENGTH);
+	number[RESIDUE_NUMBER_LENGTH] = '\0';
+	return atoi(number);
+}
+
+/**
+ * Checks whether an atom name is one of a list of names.
+ *
+ * @param names the names, separated by commas.
+ * @param line the ATOM line of the atom.
+ * @return 1 if it is, 0 otherwise.
+ */
+static int isNameListed(const char* names, const char* line)
+{
+	const char* name = line + ATOM_NAME_START;
+	size_t nameLength = ATOM_NAME_LENGTH;
+	size_t length;
+
+	// names are padded with spaces on both sides
+	while (nameLength > 0 && *name == ' ')
+	{
+		name++;
+		nameLength--;
+	}
+	while (nameLength > 0 && name[nameLength - 1] == ' ')
+	{
+		nameLength--;
+	}
+
+	for (;; names += length + 1)
+	{
+		length = strcspn(names, ",");
+		if (length == nameLength && memcmp(names, name, length) == 0)
+		{
+			return 1;
+		}
+		if (names[length] == '\0')
+		{
+			return 0;
+		}
+	}
+}
+
+int isAtomSelected(const struct AtomFilter* filter, const char* line)
+{
+	int residueNumber;
+
+	if (filter->chains && (line[CHAIN_POSITION] == '\0' || !strchr(filter->chains, line[CHAIN_POSITION])))
+	{
+		return 0;
+	}
+	if (filter->hasResidueRange)
+	{
+		residueNumber = parseResidueNumber(line);
+		if (residueNumber < filter->firstResidue || residueNumber > filter->lastResidue)
+		{
+			return 0;
+		}
+	}
+	return !filter->atomNames || isNameListed(filter->atomNames, line);
+}
+
+/**
+ * Adds a new group for an atom.
+ *
+ * @param reader the reader.
+ * @param line the ATOM line of the first atom of the group.
+ * @param atom the index of the first atom of the group.
+ * @return The index of the group, or a negative error code.
+ */
+static int addGroup(struct SelectionReader* reader, const char* line, int atom)
+{
+	struct AtomGroup* group;
+	void* newBlock;
+
+	if (reader->numOfGroups == reader->groupCapacity)
+	{
+		newBlock = realloc(reader->groups, sizeof(struct AtomGroup) * (reader->groupCapacity * 2 + 1));
+		if (!newBlock)
+		{
+			fprintf(stderr, "Not enough memory for %d groups\n", reader->numOfGroups + 1);
+			return -ENOMEM;
+		}
+		reader->groups = newBlock;
+		reader->groupCapacity = reader->groupCapacity * 2 + 1;
+	}
+	group = &reader->groups[reader->numOfGroups];
+	memcpy(group->residueName, line + RESIDUE_NAME_START, RESIDUE_NAME_LENGTH);
+	group->residueName[RESIDUE_NAME_LENGTH] = '\0';
+	group->chain = line[CHAIN_POSITION];
+	group->residueNumber = parseResidueNumber(line);
+	group->insertion = line[INSERTION_POSITION];
+	group->start = atom;
+	group->size = 0;
+	return reader->numOfGroups++;
+}
+
+/**
+ * Finds the group of an atom, adding it if it is new.
+ *
+ * @param reader the reader.
+ * @param line the ATOM line of the atom.
+ * @param atom the index of the atom.
+ * @return The index of the group, or a negative error code.
+ */
+static int findGroup(struct SelectionReader* reader, const char* line, int atom)
+{
+	unsigned char chain = (unsigned char) line[CHAIN_POSITION];
+
+	if (reader->grouping == GROUP_CHAIN)
+	{
+		if (reader->chainGroups[chain] == NO_GROUP)
+		{
+			reader->chainGroups[chain] = addGroup(reader, line, atom);
+		}
+		return reader->chainGroups[chain];
+	}
+	// atoms of a residue are written together, a new key starts a new residue
+	if (reader->numOfGroups == 0 || memcmp(reader->lastKey, line + RESIDUE_NAME_START, RESIDUE_KEY_LENGTH) != 0)
+	{
+		memcpy(reader->lastKey, line + RESIDUE_NAME_START, RESIDUE_KEY_LENGTH);
+		return addGroup(reader, line, atom);
+	}
+	return reader->numOfGroups - 1;
+}
+
+/**
+ * Adds an atom if it is selected and notes its group, the addAtom of the selection reader sink.
+ *
+ * @param context the SelectionReader.
+ * @param line the ATOM line.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return 0 on success, an error code otherwise.
+ */
+static int addSelectedAtom(void* context, const char* line, float x, float y, float z)
+{
+	struct SelectionReader* reader = context;
+	void* newBlock;
+	int atom = reader->store->size;
+	int group;
+
+	if (!isAtomSelected(reader->filter, line))
+	{
+		return 0;
+	}
+	if (appendCoord(reader->store, x, y, z) < 0)
+	{
+		fprintf(stderr, "Not enough memory for %d atoms\n", atom + 1);
+		return -ENOMEM;
+	}
+	if (reader->grouping == GROUP_NONE)
+	{
+		return 0;
+	}
+	if (atom == reader->atomCapacity)
+	{
+		// grows with the store
+		newBlock = realloc(reader->atomGroups, sizeof(int) * reader->store->capacity);
+		if (!newBlock)
+		{
+			fprintf(stderr, "Not enough memory for %d atoms\n", atom + 1);
+			return -ENOMEM;
+		}
+		reader->atomGroups = newBlock;
+		reader->atomCapacity = reader->store->capacity;
+	}
+
+	group = findGroup(reader, line, atom);
+	if (group < 0)
+	{
+		return group;
+	}
+	// a group that comes back after another one breaks the order
+	if (atom > 0 && reader->atomGroups[atom - 1] != group && reader->groups[group].size > 0)
+	{
+		reader->isSorted = 0;
+	}
+	reader->groups[group].size++;
+	reader->atomGroups[atom] = group;
+	return 0;
+}
+
+/**
+ * Sorts the atoms by group, so the atoms of every group are next to each other.
+ *
+ * @param reader the reader.
+ * @param sortedStore the output, the sorted atoms.
+ * @return 0 on success, an error code otherwise.
+ */
+static int sortByGroup(struct SelectionReader* reader, struct CoordStore* sortedStore)
+{
+	const struct CoordStore* store = reader->store;
+	int* positions;
+	int position = 0;
+	int i;
+
+	positions = malloc(sizeof(int) * reader->numOfGroups);
+	if (!positions || reserveCoords(sortedStore, store->size) < 0)
+	{
+		free(positions);
+		return -ENOMEM;
+	}
+	for (i = 0; i < reader->numOfGroups; i++)
+	{
+		reader->groups[i].start = position;
+		positions[i] = position;
+		position += reader->groups[i].size;
+	}
+	for (i = 0; i < store->size; i++)
+	{
+		position = positions[reader->atomGroups[i]]++;
+		sortedStore->x[position] = store->x[i];
+		sortedStore->y[position] = store->y[i];
+		sortedStore->z[position] = store->z[i];
+	}
+	sortedStore->size = store->size;
+	free(positions);
+	return 0;
+}
+
+/**
+ * Prints the statistics of every group.
+ *
+ * @param options how to calculate.
+ * @param reader the atoms and their groups.
+ * @param store the atoms, sorted by group.
+ * @param hullStore a scratch store for the hull points.
+ */
+static void printGroups(const struct AnalysisOptions* options, const struct SelectionReader* reader,
+                        const struct CoordStore* store, struct CoordStore* hullStore)
+{
+	const struct AtomGroup* group;
+	struct CoordStore groupStore;
+	struct ProteinStats stats;
+	int i;
+
+	for (i = 0; i < reader->numOfGroups; i++)
+	{
+		group = &reader->groups[i];
+		// the group is a view into the sorted atoms
+		groupStore = *store;
+		groupStore.x = store->x + group->start;
+		groupStore.y = store->y + group->start;
+		groupStore.z = store->z + group->start;
+		groupStore.size = group->size;
+		groupStore.capacity = group->size;
+		analyzeStore(options, &groupStore, hullStore, &stats);
+
+		if (reader->grouping == GROUP_CHAIN)
+		{
+			printf("Chain %c", group->chain);
+		}
+		else
+		{
+			printf("Residue %s %c %d", group->residueName, group->chain, group->residueNumber);
+			if (group->insertion != ' ')
+			{
+				printf("%c", group->insertion);
+			}
+		}
+		printf(", %d atoms: Cg = %.3f %.3f %.3f, Rg = %.3f, Dmax = %.3f", stats.numOfAtoms,
+		       stats.centerOfGravity[X_POS], stats.centerOfGravity[Y_POS], stats.centerOfGravity[Z_POS],
+		       stats.turnRadius, stats.maxDistance);
+		if (stats.maxDistanceBound > stats.maxDistance)
+		{
+			printf(" (approximate, at most %.3f)", stats.maxDistanceBound);
+		}
+		printf("\n");
+	}
+}
+
+int analyzeSelection(const struct AnalysisOptions* options, const char* path, const struct AtomFilter* filter,
+                     int grouping, struct CoordStore* store, struct CoordStore* hullStore)
+{
+	FILE* file;
+	struct SelectionReader reader;
+	struct AtomSink sink = {addSelectedAtom, NULL, &reader, filter->includeHetatm};
+	struct CoordStore* sortedStore = NULL;
+	struct ProteinStats stats;
+	long ret;
+	int i;
+
+	file = fopen(path, "r");
+	if(!file)
+	{
+		ret = errno;
+		fprintf(stderr, "Error opening file: %s\n", path);
+		return (int) ret;
+	}
+	memset(&reader, 0, sizeof(reader));
+	reader.filter = filter;
+	reader.grouping = grouping;
+	reader.store = store;
+	reader.isSorted = 1;
+	for (i = 0; i < NUM_OF_CHAIN_IDS; i++)
+	{
+		reader.chainGroups[i] = NO_GROUP;
+	}
+	clearCoordStore(store);
+	ret = streamValues(file, &sink, stderr);
+	fclose(file);
+
+	if (ret >= 0 && store->size == 0)
+	{
+		fprintf(stderr, "Error - 0 atoms were found in the file %s\n", path);
+		ret = 1;
+	}
+	else if (ret >= 0 && grouping == GROUP_NONE)
+	{
+		analyzeStore(options, store, hullStore, &stats);
+		printStats(path, &stats);
+		ret = 0;
+	}
+	else if (ret >= 0)
+	{
+		if (!reader.isSorted)
+		{
+			sortedStore = coordStoreAlloc(NULL);
+			ret = sortedStore ? sortByGroup(&reader, sortedStore) : -ENOMEM;
+			if (ret < 0)
+			{
+				fprintf(stderr, "Not enough memory for %d atoms\n", store->size);
+			}
+		}
+		if (ret >= 0)
+		{
+			printf("PDB file %s, %d atoms were read\n", path, store->size);
+			printGroups(options, &reader, sortedStore ? sortedStore : store, hullStore);
+			ret = 0;
+		}
+	}
+
+	freeCoordStore(&sortedStore);
+	free(reader.atomGroups);
+	free(reader.groups);
+	return ret < 0 ? (int) -ret : (int) ret;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file atomSelection.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for analyzing some of the atoms of a file, alone or in groups.
+ * The atoms are filtered and grouped as the file is read, so the file is
+ * read once whatever the selection.
+ */
+
+#ifndef ATOM_SELECTION_H
+#define ATOM_SELECTION_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+
+
+/* --- Constants --- */
+
+/** Name of the grouping of the atoms by chain. */
+#define GROUP_BY_CHAIN "chain"
+
+/** Name of the grouping of the atoms by residue. */
+#define GROUP_BY_RESIDUE "residue"
+
+/** How the selected atoms are grouped. */
+#define GROUP_NONE 0
+#define GROUP_CHAIN 1
+#define GROUP_RESIDUE 2
+
+
+/* --- Structs --- */
+
+/** Which atoms are analyzed, an atom must pass every part that is set. */
+struct AtomFilter
+{
+	// the chain identifiers to keep, like "AB", NULL for all the chains
+	const char* chains;
+	// the residue numbers to keep, from first to last
+	int hasResidueRange;
+	int firstResidue;
+	int lastResidue;
+	// the atom names to keep separated by commas, like "N,CA,C,O", NULL for all the atoms
+	const char* atomNames;
+	// 1 to read HETATM lines too
+	int includeHetatm;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Checks whether an atom passes a filter.
+ *
+ * @param filter the filter.
+ * @param line the ATOM line of the atom, at least MINIMUM_LINE_LENGTH long.
+ * @return 1 if it passes, 0 otherwise.
+ */
+int isAtomSelected(const struct AtomFilter* filter, const char* line);
+
+/**
+ * Analyzes the selected atoms of a file, and prints the statistics of all of
+ * them or of each group.
+ *
+ * @param options how to calculate.
+ * @param path the path of the file.
+ * @param filter which atoms to analyze.
+ * @param grouping GROUP_NONE, GROUP_CHAIN or GROUP_RESIDUE.
+ * @param store a scratch store for the atoms.
+ * @param hullStore a scratch store for the hull points.
+ * @return 0 on success, the exit code otherwise.
+ */
+int analyzeSelection(const struct AnalysisOptions* options, const char* path, const struct AtomFilter* filter,
+                     int grouping, struct CoordStore* store, struct CoordStore* hullStore);
+
+#endif
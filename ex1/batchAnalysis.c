@@ -0,0 +1,347 @@
+/**
+ * @file batchAnalysis.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the batch analysis.
+ * A fixed number of slots (a store for the atoms and one for the hull) limit
+ * how many files are in memory at once. A reader takes a slot and the next
+ * file together, so the slots always hold the first files that weren't
+ * printed yet, and the printing never waits for a file that can't be read.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include "batchAnalysis.h"
+#include "coordStore.h"
+#include "threadPool.h"
+
+
+/* --- Constants --- */
+
+/** How many slots there are for every thread. */
+#define SLOTS_PER_THREAD 2
+
+
+/* --- Structs --- */
+
+/** Memory for one file in the pipeline. */
+struct BatchSlot
+{
+	struct CoordStore* store;
+	struct CoordStore* hullStore;
+	struct BatchSlot* next;
+};
+
+struct Batch;
+
+/** A file in the pipeline. */
+struct BatchFile
+{
+	struct Batch* batch;
+	const char* path;
+	struct BatchSlot* slot;
+	// problems found while reading, printed with the file's results
+	char* messages;
+	size_t messagesSize;
+	int ret;
+	struct ProteinStats stats;
+	// NULL if the files aren't profiled
+	struct FileProfile* profile;
+	int isDone;
+};
+
+/** The state shared by all the threads. */
+struct Batch
+{
+	struct BatchFile* files;
+	int numOfFiles;
+	int nextFile;
+	struct BatchSlot* freeSlots;
+	const struct AnalysisOptions* options;
+	struct ThreadPool* workers;
+	pthread_mutex_t lock;
+	pthread_cond_t slotFreed;
+	pthread_cond_t fileDone;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Marks a file as done and wakes up the printing.
+ *
+ * @param file the file.
+ */
+static void markDone(struct BatchFile* file)
+{
+	pthread_mutex_lock(&file->batch->lock);
+	file->isDone = 1;
+	pthread_cond_broadcast(&file->batch->fileDone);
+	pthread_mutex_unlock(&file->batch->lock);
+}
+
+/**
+ * Calculates the statistics of a loaded file, a pool task.
+ *
+ * @param arg the BatchFile.
+ */
+static void analyzeTask(void* arg)
+{
+	struct BatchFile* file = arg;
+	if (file->profile)
+	{
+		profileStore(file->batch->options, file->slot->store, file->slot->hullStore, &file->stats, file->profile);
+	}
+	else
+	{
+		analyzeStore(file->batch->options, file->slot->store, file->slot->hullStore, &file->stats);
+	}
+	markDone(file);
+}
+
+/**
+ * Loads the next file into a free slot and passes it to the workers.
+ * Waits for a slot if there's none.
+ *
+ * @param batch the batch.
+ * @return 1 if a file was taken, 0 if every file was already taken.
+ */
+static int readNextFile(struct Batch* batch)
+{
+	struct BatchFile* file;
+	FILE* errors;
+
+	pthread_mutex_lock(&batch->lock);
+	while (!batch->freeSlots && batch->nextFile < batch->numOfFiles)
+	{
+		pthread_cond_wait(&batch->slotFreed, &batch->lock);
+	}
+	if (batch->nextFile == batch->numOfFiles)
+	{
+		pthread_mutex_unlock(&batch->lock);
+		return 0;
+	}
+	file = &batch->files[batch->nextFile++];
+	file->slot = batch->freeSlots;
+	batch->freeSlots = file->slot->next;
+	pthread_mutex_unlock(&batch->lock);
+
+	errors = open_memstream(&file->messages, &file->messagesSize);
+	file->ret = loadFile(file->batch->options, file->path, file->slot->store, errors ? errors : stderr,
+	                     file->profile);
+	if (errors)
+	{
+		fclose(errors);
+	}
+
+	if (file->ret <= 0)
+	{
+		markDone(file);
+	}
+	else if (threadPoolSubmit(batch->workers, analyzeTask, file) != 0)
+	{
+		analyzeTask(file);
+	}
+	return 1;
+}
+
+/**
+ * Loads the files one after another and passes them to the workers, a reader thread.
+ *
+ * @param arg the Batch.
+ * @return Always NULL.
+ */
+static void* readerMain(void* arg)
+{
+	struct Batch* batch = arg;
+
+	while (readNextFile(batch))
+	{
+		// every call loads one file
+	}
+	return NULL;
+}
+
+/**
+ * Waits for a file to be done, prints it and recycles its slot.
+ *
+ * @param batch the batch.
+ * @param file the file.
+ * @return 0 if the file was analyzed, otherwise its error code (1 for a file without atoms).
+ */
+static int printFile(struct Batch* batch, struct BatchFile* file)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&batch->lock);
+	while (!file->isDone)
+	{
+		pthread_cond_wait(&batch->fileDone, &batch->lock);
+	}
+	pthread_mutex_unlock(&batch->lock);
+
+	if (file->messages)
+	{
+		fwrite(file->messages, 1, file->messagesSize, stderr);
+		free(file->messages);
+	}
+	if (file->ret > 0)
+	{
+		printStats(file->path, &file->stats);
+	}
+	else
+	{
+		ret = file->ret < 0 ? -file->ret : 1;
+	}
+
+	pthread_mutex_lock(&batch->lock);
+	file->slot->next = batch->freeSlots;
+	batch->freeSlots = file->slot;
+	pthread_cond_signal(&batch->slotFreed);
+	pthread_mutex_unlock(&batch->lock);
+	return ret;
+}
+
+/**
+ * Frees a list of slots.
+ *
+ * @param slots the first slot in the list.
+ */
+static void freeSlots(struct BatchSlot* slots)
+{
+	struct BatchSlot* next;
+	while (slots)
+	{
+		next = slots->next;
+		freeCoordStore(&slots->store);
+		freeCoordStore(&slots->hullStore);
+		free(slots);
+		slots = next;
+	}
+}
+
+/**
+ * Allocates the slots of a batch.
+ *
+ * @param batch the batch.
+ * @param numOfSlots how many slots to allocate.
+ * @return 0 on success, an error code otherwise.
+ */
+static int allocSlots(struct Batch* batch, int numOfSlots)
+{
+	struct BatchSlot* slot;
+	int i;
+
+	for (i = 0; i < numOfSlots; i++)
+	{
+		slot = malloc(sizeof(struct BatchSlot));
+		if (!slot)
+		{
+			return -ENOMEM;
+		}
+		slot->store = coordStoreAlloc(NULL);
+		slot->hullStore = coordStoreAlloc(NULL);
+		slot->next = batch->freeSlots;
+		batch->freeSlots = slot;
+		if (!slot->store || !slot->hullStore)
+		{
+			return -ENOMEM;
+		}
+	}
+	return 0;
+}
+
+int analyzeBatch(char** paths, int numOfPaths, const struct AnalysisOptions* options,
+                 int numOfReaders, int numOfWorkers, struct Profiler* profiler)
+{
+	struct Batch batch;
+	struct AnalysisOptions fileOptions = *options;
+	pthread_t* readers;
+	int firstProfile = profiler ? profiler->numOfFiles : 0;
+	int numOfStartedReaders = 0;
+	int firstError = 0;
+	int ret;
+	int i;
+
+	// all the profiles are added before any is filled, so they don't move under the threads
+	for (i = 0; profiler && i < numOfPaths; i++)
+	{
+		if (!addProfile(profiler, paths[i]))
+		{
+			fprintf(stderr, "Not enough memory for the profile of %s\n", paths[i]);
+			return ENOMEM;
+		}
+	}
+
+	// the workers are already busy with other files
+	fileOptions.pool = NULL;
+	batch.options = &fileOptions;
+	batch.numOfFiles = numOfPaths;
+	batch.nextFile = 0;
+	batch.freeSlots = NULL;
+	batch.files = calloc(numOfPaths, sizeof(struct BatchFile));
+	batch.workers = threadPoolAlloc(numOfWorkers);
+	readers = malloc(sizeof(pthread_t) * numOfReaders);
+	if (!batch.files || !batch.workers || !readers ||
+	    allocSlots(&batch, SLOTS_PER_THREAD * (numOfReaders + numOfWorkers)) != 0)
+	{
+		fprintf(stderr, "Error allocating the batch\n");
+		free(batch.files);
+		freeThreadPool(&batch.workers);
+		free(readers);
+		freeSlots(batch.freeSlots);
+		return ENOMEM;
+	}
+	pthread_mutex_init(&batch.lock, NULL);
+	pthread_cond_init(&batch.slotFreed, NULL);
+	pthread_cond_init(&batch.fileDone, NULL);
+	for (i = 0; i < numOfPaths; i++)
+	{
+		batch.files[i].batch = &batch;
+		batch.files[i].path = paths[i];
+		batch.files[i].profile = profiler ? &profiler->files[firstProfile + i] : NULL;
+	}
+
+	for (i = 0; i < numOfReaders; i++)
+	{
+		if (pthread_create(&readers[i], NULL, readerMain, &batch) == 0)
+		{
+			numOfStartedReaders++;
+		}
+	}
+
+	// print the files in order, and recycle their slots
+	for (i = 0; i < numOfPaths; i++)
+	{
+		if (numOfStartedReaders == 0)
+		{
+			// no threads, read every file on this one just before it's printed, so its slot is free again
+			readNextFile(&batch);
+		}
+		ret = printFile(&batch, &batch.files[i]);
+		if (firstError == 0)
+		{
+			firstError = ret;
+		}
+	}
+
+	for (i = 0; i < numOfStartedReaders; i++)
+	{
+		pthread_join(readers[i], NULL);
+	}
+	freeThreadPool(&batch.workers);
+	pthread_mutex_destroy(&batch.lock);
+	pthread_cond_destroy(&batch.slotFreed);
+	pthread_cond_destroy(&batch.fileDone);
+	freeSlots(batch.freeSlots);
+	free(readers);
+	free(batch.files);
+	return firstError;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file batchAnalysis.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the pipelined analysis of many pdb files.
+ */
+
+#ifndef BATCH_ANALYSIS_H
+#define BATCH_ANALYSIS_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+#include "profiler.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Analyzes many files in a pipeline. Reader threads load the files into
+ * per-file stores, and worker threads calculate their statistics.
+ * The results and problems of every file are printed in the order of the paths.
+ * A file with a problem is reported, and the rest of the files are still analyzed.
+ *
+ * @param paths the paths of the files.
+ * @param numOfPaths how many paths there are.
+ * @param options how to analyze the files, the pool is ignored.
+ * @param numOfReaders how many reader threads to use.
+ * @param numOfWorkers how many worker threads to use.
+ * @param profiler receives the profiles of the files in the order of the paths, NULL to not profile them.
+ *        The time of every phase is the time of the one thread that did it.
+ * @return 0 if all the files were analyzed, otherwise the error code of the
+ *         first file that failed (1 for a file without atoms).
+ */
+int analyzeBatch(char** paths, int numOfPaths, const struct AnalysisOptions* options,
+                 int numOfReaders, int numOfWorkers, struct Profiler* profiler);
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file cellList.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the cell list.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "cellList.h"
+
+
+/* --- Constants --- */
+
+/** The most cells there may be per point, more are merged by widening the cells. */
+#define MAX_CELLS_PER_POINT 2
+
+/** Cells allowed regardless of the number of points, so tiny sets still get a 3x3x3 grid. */
+#define MIN_CELLS 27
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the cell of a coordinate on one axis.
+ *
+ * @param cells the cell list.
+ * @param value the coordinate.
+ * @param axis the axis.
+ * @return The cell, clamped to the grid.
+ */
+static int findAxisCell(const struct CellList* cells, float value, int axis)
+{
+	int cell = (int) ((value - cells->origin[axis]) / cells->cellSize);
+	if (cell < 0)
+	{
+		return 0;
+	}
+	return cell < cells->dims[axis] ? cell : cells->dims[axis] - 1;
+}
+
+void findCell(const struct CellList* cells, float x, float y, float z, int cell[COORD_NUM])
+{
+	cell[X_POS] = findAxisCell(cells, x, X_POS);
+	cell[Y_POS] = findAxisCell(cells, y, Y_POS);
+	cell[Z_POS] = findAxisCell(cells, z, Z_POS);
+}
+
+/**
+ * Sets the cell size and the grid dimensions to cover the given box.
+ *
+ * @param cells the cell list.
+ * @param low the low corner of the box.
+ * @param high the high corner of the box.
+ * @param cellSize the minimal width of a cell.
+ * @param numOfPoints how many points are in the box.
+ */
+static void sizeGrid(struct CellList* cells, const float low[COORD_NUM], const float high[COORD_NUM],
+                     float cellSize, int numOfPoints)
+{
+	double maxCells = (double) numOfPoints * MAX_CELLS_PER_POINT + MIN_CELLS;
+	double dims[COORD_NUM];
+	double numOfCells;
+	int axis;
+
+	if (maxCells > INT_MAX - 1)
+	{
+		maxCells = INT_MAX - 1;
+	}
+	for (;;)
+	{
+		numOfCells = 1;
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			dims[axis] = floor(((double) high[axis] - low[axis]) / cellSize) + 1;
+			numOfCells *= dims[axis];
+		}
+		if (numOfCells <= maxCells)
+		{
+			break;
+		}
+		// sparse points, wider cells keep the grid linear in the points
+		cellSize *= 2;
+	}
+	cells->cellSize = cellSize;
+	cells->numOfCells = (int) numOfCells;
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		cells->dims[axis] = (int) dims[axis];
+		cells->origin[axis] = low[axis];
+	}
+}
+
+struct CellList* cellListAlloc(const struct CoordStore* store, float cellSize)
+{
+	struct CellList* cells;
+	float low[COORD_NUM];
+	float high[COORD_NUM];
+	int* pointCells;
+	int cell[COORD_NUM];
+	int numOfPoints = store->size;
+	int i, c;
+
+	cells = calloc(1, sizeof(struct CellList));
+	if (!cells)
+	{
+		return NULL;
+	}
+
+	low[X_POS] = high[X_POS] = store->x[0];
+	low[Y_POS] = high[Y_POS] = store->y[0];
+	low[Z_POS] = high[Z_POS] = store->z[0];
+	for (i = 1; i < numOfPoints; i++)
+	{
+		low[X_POS] = store->x[i] < low[X_POS] ? store->x[i] : low[X_POS];
+		low[Y_POS] = store->y[i] < low[Y_POS] ? store->y[i] : low[Y_POS];
+		low[Z_POS] = store->z[i] < low[Z_POS] ? store->z[i] : low[Z_POS];
+		high[X_POS] = store->x[i] > high[X_POS] ? store->x[i] : high[X_POS];
+		high[Y_POS] = store->y[i] > high[Y_POS] ? store->y[i] : high[Y_POS];
+		high[Z_POS] = store->z[i] > high[Z_POS] ? store->z[i] : high[Z_POS];
+	}
+	sizeGrid(cells, low, high, cellSize, numOfPoints);
+	cells->numOfPoints = numOfPoints;
+
+	cells->cellStart = calloc((size_t) cells->numOfCells + 1, sizeof(int));
+	cells->order = malloc(sizeof(int) * numOfPoints);
+	cells->x = malloc(sizeof(float) * numOfPoints * COORD_NUM);
+	pointCells = malloc(sizeof(int) * numOfPoints);
+	if (!cells->cellStart || !cells->order || !cells->x || !pointCells)
+	{
+		free(pointCells);
+		freeCellList(&cells);
+		return NULL;
+	}
+	cells->y = cells->x + numOfPoints;
+	cells->z = cells->y + numOfPoints;
+
+	// a counting sort of the points by cell
+	for (i = 0; i < numOfPoints; i++)
+	{
+		findCell(cells, store->x[i], store->y[i], store->z[i], cell);
+		pointCells[i] = (cell[Z_POS] * cells->dims[Y_POS] + cell[Y_POS]) * cells->dims[X_POS] + cell[X_POS];
+		cells->cellStart[pointCells[i] + 1]++;
+	}
+	for (c = 0; c < cells->numOfCells; c++)
+	{
+		cells->cellStart[c + 1] += cells->cellStart[c];
+	}
+	for (i = 0; i < numOfPoints; i++)
+	{
+		// cellStart[c] runs ahead while cell c fills, and is moved back below
+		c = cells->cellStart[pointCells[i]]++;
+		cells->order[c] = i;
+		cells->x[c] = store->x[i];
+		cells->y[c] = store->y[i];
+		cells->z[c] = store->z[i];
+	}
+	memmove(cells->cellStart + 1, cells->cellStart, sizeof(int) * cells->numOfCells);
+	cells->cellStart[0] = 0;
+
+	free(pointCells);
+	return cells;
+}
+
+void freeCellList(struct CellList** cells)
+{
+	if (*cells == NULL)
+	{
+		return;
+	}
+	free((*cells)->cellStart);
+	free((*cells)->order);
+	free((*cells)->x);
+	free(*cells);
+	*cells = NULL;
+}
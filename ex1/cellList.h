@@ -0,0 +1,73 @@
+/**
+ * @file cellList.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for a uniform grid spatial index over a set of points.
+ * The space is split into cubic cells, and the points are sorted by cell,
+ * so the points near a given point are found in its cell and the 26 cells
+ * around it.
+ */
+
+#ifndef CELL_LIST_H
+#define CELL_LIST_H
+
+
+/* --- Includes --- */
+
+#include "coordStore.h"
+
+
+/* --- Structs --- */
+
+/**
+ * A grid of cells over a set of points.
+ * The points of cell c are order[cellStart[c]] to order[cellStart[c + 1] - 1],
+ * and their coordinates are copied in the same order to x, y and z.
+ */
+struct CellList
+{
+	float cellSize;
+	float origin[COORD_NUM];
+	int dims[COORD_NUM];
+	int numOfCells;
+	int numOfPoints;
+	int* cellStart;
+	int* order;
+	float* x;
+	float* y;
+	float* z;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Builds a cell list over the points of a store.
+ * The cells are at least cellSize wide. They are made wider if the points
+ * are so sparse there would be many more cells than points.
+ *
+ * @param store the points, must not be empty.
+ * @param cellSize the minimal width of a cell, positive.
+ * @return The new cell list, or NULL if there's no memory. Free with freeCellList.
+ */
+struct CellList* cellListAlloc(const struct CoordStore* store, float cellSize);
+
+/**
+ * Frees the given cell list and sets it to NULL.
+ *
+ * @param cells a pointer to the cell list to free.
+ */
+void freeCellList(struct CellList** cells);
+
+/**
+ * Finds the cell of a point on every axis.
+ *
+ * @param cells the cell list.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @param cell the output cell coordinates, clamped to the grid.
+ */
+void findCell(const struct CellList* cells, float x, float y, float z, int cell[COORD_NUM]);
+
+#endif
@@ -0,0 +1,474 @@
+/**
+ * @file contacts.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the contacts search.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "contacts.h"
+#include "threadPool.h"
+#include "pdbReader.h"
+
+
+/* --- Constants --- */
+
+/** Number of cells around a cell that come after it, half of the 26 neighbors. */
+#define NUM_OF_NEIGHBORS 13
+
+/** How many tasks every thread gets, so uneven cells even out. */
+#define TASKS_PER_THREAD 4
+
+/** Initial capacity of a pairs array. */
+#define INITIAL_PAIRS 1024
+
+/** The cells are widened by this factor over the cutoff, so rounding never hides a pair. */
+#define CELL_MARGIN 1.0001f
+
+/** The characters that identify a residue, from the name to the insertion code. */
+#define RESIDUE_KEY_LENGTH (INSERTION_POSITION + 1 - RESIDUE_NAME_START)
+
+
+/* --- Structs --- */
+
+/** A residue, as written in the ATOM lines of its atoms. */
+struct Residue
+{
+	char name[RESIDUE_NAME_LENGTH + 1];
+	char chain;
+	int number;
+	char insertion;
+};
+
+/** The state of reading the atoms with their residues, the context of its atom sink. */
+struct ResidueReader
+{
+	struct CoordStore* store;
+	// the residue of every atom, an index into residues
+	int* atomResidues;
+	int atomCapacity;
+	struct Residue* residues;
+	int numOfResidues;
+	int residueCapacity;
+	char lastKey[RESIDUE_KEY_LENGTH];
+};
+
+/** A range of cells to search, a pool task. */
+struct ContactTask
+{
+	const struct CellList* cells;
+	float cutoffSquared;
+	int firstCell;
+	int lastCell;
+	struct ContactPair* pairs;
+	long size;
+	long capacity;
+	int ret;
+};
+
+
+/* --- Globals --- */
+
+/** The offsets of the neighbors that come after a cell, so every pair of cells is searched once. */
+static const int NEIGHBORS[NUM_OF_NEIGHBORS][COORD_NUM] = {
+	{1, 0, 0},
+	{-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+	{-1, -1, 1}, {0, -1, 1}, {1, -1, 1},
+	{-1, 0, 1}, {0, 0, 1}, {1, 0, 1},
+	{-1, 1, 1}, {0, 1, 1}, {1, 1, 1}
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Adds a pair to the pairs of a task, growing them if needed.
+ *
+ * @param task the task.
+ * @param first one point, an index into the sorted points.
+ * @param second the other point, an index into the sorted points.
+ * @param distanceSquared the squared distance between the points.
+ * @return 0 on success, an error code otherwise.
+ */
+static int addPair(struct ContactTask* task, int first, int second, float distanceSquared)
+{
+	struct ContactPair* newPairs;
+	struct ContactPair* pair;
+	long newCapacity;
+
+	if (task->size == task->capacity)
+	{
+		newCapacity = task->capacity == 0 ? INITIAL_PAIRS : task->capacity * 2;
+		newPairs = realloc(task->pairs, sizeof(struct ContactPair) * newCapacity);
+		if (!newPairs)
+		{
+			return -ENOMEM;
+		}
+		task->pairs = newPairs;
+		task->capacity = newCapacity;
+	}
+	pair = &task->pairs[task->size++];
+	first = task->cells->order[first];
+	second = task->cells->order[second];
+	pair->first = first < second ? first : second;
+	pair->second = first < second ? second : first;
+	pair->distance = sqrtf(distanceSquared);
+	return 0;
+}
+
+/**
+ * Compares the points of two cells, or the points of one cell between themselves.
+ *
+ * @param task the task.
+ * @param cell the cell.
+ * @param other the other cell, the same cell to compare it with itself.
+ * @return 0 on success, an error code otherwise.
+ */
+static int searchCellPair(struct ContactTask* task, int cell, int other)
+{
+	const struct CellList* cells = task->cells;
+	int firstEnd = cells->cellStart[cell + 1];
+	int otherEnd = cells->cellStart[other + 1];
+	float dx, dy, dz, distance;
+	int i, j;
+
+	for (i = cells->cellStart[cell]; i < firstEnd; i++)
+	{
+		for (j = cell == other ? i + 1 : cells->cellStart[other]; j < otherEnd; j++)
+		{
+			dx = cells->x[i] - cells->x[j];
+			dy = cells->y[i] - cells->y[j];
+			dz = cells->z[i] - cells->z[j];
+			distance = dx * dx + dy * dy + dz * dz;
+			if (distance <= task->cutoffSquared && addPair(task, i, j, distance) < 0)
+			{
+				return -ENOMEM;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Searches the cells of a task, a pool task.
+ *
+ * @param arg the ContactTask.
+ */
+static void runContactTask(void* arg)
+{
+	struct ContactTask* task = arg;
+	const struct CellList* cells = task->cells;
+	int position[COORD_NUM];
+	int neighbor[COORD_NUM];
+	int cell, n, axis, isInside;
+
+	for (cell = task->firstCell; cell < task->lastCell && task->ret == 0; cell++)
+	{
+		if (cells->cellStart[cell] == cells->cellStart[cell + 1])
+		{
+			continue;
+		}
+		position[X_POS] = cell % cells->dims[X_POS];
+		position[Y_POS] = cell / cells->dims[X_POS] % cells->dims[Y_POS];
+		position[Z_POS] = cell / cells->dims[X_POS] / cells->dims[Y_POS];
+		task->ret = searchCellPair(task, cell, cell);
+		for (n = 0; n < NUM_OF_NEIGHBORS && task->ret == 0; n++)
+		{
+			isInside = 1;
+			for (axis = 0; axis < COORD_NUM; axis++)
+			{
+				neighbor[axis] = position[axis] + NEIGHBORS[n][axis];
+				isInside = isInside && neighbor[axis] >= 0 && neighbor[axis] < cells->dims[axis];
+			}
+			if (isInside)
+			{
+				task->ret = searchCellPair(task, cell, (neighbor[Z_POS] * cells->dims[Y_POS] + neighbor[Y_POS]) *
+				                                       cells->dims[X_POS] + neighbor[X_POS]);
+			}
+		}
+	}
+}
+
+long findContacts(struct ThreadPool* pool, const struct CellList* cells, float cutoff, struct ContactPair** pairs)
+{
+	struct ContactTask* tasks;
+	int numOfTasks = 1;
+	long numOfPairs = 0;
+	long ret = 0;
+	int i;
+
+	if (pool)
+	{
+		numOfTasks = threadPoolSize(pool) * TASKS_PER_THREAD;
+	}
+	if (numOfTasks > cells->numOfCells)
+	{
+		numOfTasks = cells->numOfCells;
+	}
+	tasks = calloc(numOfTasks, sizeof(struct ContactTask));
+	if (!tasks)
+	{
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < numOfTasks; i++)
+	{
+		tasks[i].cells = cells;
+		tasks[i].cutoffSquared = cutoff * cutoff;
+		tasks[i].firstCell = (int) ((long) cells->numOfCells * i / numOfTasks);
+		tasks[i].lastCell = (int) ((long) cells->numOfCells * (i + 1) / numOfTasks);
+		if (!pool || threadPoolSubmit(pool, runContactTask, &tasks[i]) != 0)
+		{
+			runContactTask(&tasks[i]);
+		}
+	}
+	if (pool)
+	{
+		threadPoolWait(pool);
+	}
+
+	// the tasks are joined in the order of their cells
+	for (i = 0; i < numOfTasks; i++)
+	{
+		numOfPairs += tasks[i].size;
+		ret = tasks[i].ret < 0 ? tasks[i].ret : ret;
+	}
+	*pairs = NULL;
+	if (ret == 0 && numOfPairs > 0)
+	{
+		*pairs = malloc(sizeof(struct ContactPair) * numOfPairs);
+		ret = *pairs ? 0 : -ENOMEM;
+	}
+	numOfPairs = 0;
+	for (i = 0; i < numOfTasks; i++)
+	{
+		if (ret == 0 && tasks[i].size > 0)
+		{
+			memcpy(*pairs + numOfPairs, tasks[i].pairs, sizeof(struct ContactPair) * tasks[i].size);
+			numOfPairs += tasks[i].size;
+		}
+		free(tasks[i].pairs);
+	}
+	free(tasks);
+	return ret < 0 ? ret : numOfPairs;
+}
+
+/**
+ * Adds an atom and notes its residue, the addAtom of the residue reader sink.
+ *
+ * @param context the ResidueReader.
+ * @param line the ATOM line.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return 0 on success, an error code otherwise.
+ */
+static int addResidueAtom(void* context, const char* line, float x, float y, float z)
+{
+	struct ResidueReader* reader = context;
+	struct Residue* residue;
+	void* newBlock;
+	char number[RESIDUE_NUMBER_LENGTH + 1];
+	int atom = reader->store->size;
+
+	if (appendCoord(reader->store, x, y, z) < 0)
+	{
+		fprintf(stderr, "Not enough memory for %d atoms\n", atom + 1);
+		return -ENOMEM;
+	}
+	if (atom == reader->atomCapacity)
+	{
+		// grows with the store
+		newBlock = realloc(reader->atomResidues, sizeof(int) * reader->store->capacity);
+		if (!newBlock)
+		{
+			fprintf(stderr, "Not enough memory for %d atoms\n", atom + 1);
+			return -ENOMEM;
+		}
+		reader->atomResidues = newBlock;
+		reader->atomCapacity = reader->store->capacity;
+	}
+
+	// atoms of a residue are written together, a new key starts a new residue
+	if (reader->numOfResidues == 0 ||
+	    memcmp(reader->lastKey, line + RESIDUE_NAME_START, RESIDUE_KEY_LENGTH) != 0)
+	{
+		if (reader->numOfResidues == reader->residueCapacity)
+		{
+			newBlock = realloc(reader->residues, sizeof(struct Residue) * (reader->residueCapacity * 2 + 1));
+			if (!newBlock)
+			{
+				fprintf(stderr, "Not enough memory for %d residues\n", reader->numOfResidues + 1);
+				return -ENOMEM;
+			}
+			reader->residues = newBlock;
+			reader->residueCapacity = reader->residueCapacity * 2 + 1;
+		}
+		memcpy(reader->lastKey, line + RESIDUE_NAME_START, RESIDUE_KEY_LENGTH);
+		residue = &reader->residues[reader->numOfResidues++];
+		memcpy(residue->name, line + RESIDUE_NAME_START, RESIDUE_NAME_LENGTH);
+		residue->name[RESIDUE_NAME_LENGTH] = '\0';
+		residue->chain = line[CHAIN_POSITION];
+		memcpy(number, line + RESIDUE_NUMBER_START, RESIDUE_NUMBER_LENGTH);
+		number[RESIDUE_NUMBER_LENGTH] = '\0';
+		residue->number = atoi(number);
+		residue->insertion = line[INSERTION_POSITION];
+	}
+	reader->atomResidues[atom] = reader->numOfResidues - 1;
+	return 0;
+}
+
+/**
+ * Compares two residue pair keys, for qsort.
+ *
+ * @param first the first key.
+ * @param second the second key.
+ * @return Negative, 0 or positive, like strcmp.
+ */
+static int compareKeys(const void* first, const void* second)
+{
+	long long firstKey = *(const long long*) first;
+	long long secondKey = *(const long long*) second;
+	return (firstKey > secondKey) - (firstKey < secondKey);
+}
+
+/**
+ * Prints a residue, without a new line.
+ *
+ * @param residue the residue.
+ */
+static void printResidue(const struct Residue* residue)
+{
+	printf("%s %c %d", residue->name, residue->chain, residue->number);
+	if (residue->insertion != ' ')
+	{
+		printf("%c", residue->insertion);
+	}
+}
+
+/**
+ * Prints the residue pairs in contact, with the number of atom pairs between them.
+ * Atom pairs within one residue are not counted.
+ *
+ * @param reader the atoms and their residues.
+ * @param pairs the atom pairs.
+ * @param numOfPairs how many atom pairs there are.
+ * @param cutoff the cutoff distance.
+ * @return 0 on success, an error code otherwise.
+ */
+static int printResidueMap(const struct ResidueReader* reader, const struct ContactPair* pairs, long numOfPairs,
+                           float cutoff)
+{
+	long long* keys;
+	long numOfKeys = 0;
+	long numOfResiduePairs = 0;
+	long i, run;
+	int first, second;
+
+	keys = malloc(sizeof(long long) * (numOfPairs > 0 ? numOfPairs : 1));
+	if (!keys)
+	{
+		fprintf(stderr, "Not enough memory for %ld contacts\n", numOfPairs);
+		return -ENOMEM;
+	}
+	for (i = 0; i < numOfPairs; i++)
+	{
+		first = reader->atomResidues[pairs[i].first];
+		second = reader->atomResidues[pairs[i].second];
+		if (first != second)
+		{
+			keys[numOfKeys++] = first < second ? (long long) first * reader->numOfResidues + second :
+			                                     (long long) second * reader->numOfResidues + first;
+		}
+	}
+	qsort(keys, numOfKeys, sizeof(long long), compareKeys);
+	for (i = 0; i < numOfKeys; i++)
+	{
+		numOfResiduePairs += i == 0 || keys[i] != keys[i - 1];
+	}
+
+	printf("Residue contacts within %.3f = %ld\n", cutoff, numOfResiduePairs);
+	for (i = 0; i < numOfKeys; i = run)
+	{
+		for (run = i + 1; run < numOfKeys && keys[run] == keys[i]; run++)
+		{
+		}
+		printResidue(&reader->residues[keys[i] / reader->numOfResidues]);
+		printf(" ");
+		printResidue(&reader->residues[keys[i] % reader->numOfResidues]);
+		printf(" %ld\n", run - i);
+	}
+	free(keys);
+	return 0;
+}
+
+int analyzeContacts(const struct AnalysisOptions* options, const char* path, float cutoff, int isResidueMap,
+                    struct CoordStore* store)
+{
+	FILE* file;
+	struct ResidueReader reader;
+	struct AtomSink sink = {addResidueAtom, NULL, &reader, 0};
+	struct CellList* cells = NULL;
+	struct ContactPair* pairs = NULL;
+	long numOfPairs = 0;
+	long ret;
+	long i;
+
+	file = fopen(path, "r");
+	if(!file)
+	{
+		ret = errno;
+		fprintf(stderr, "Error opening file: %s\n", path);
+		return (int) ret;
+	}
+	memset(&reader, 0, sizeof(reader));
+	reader.store = store;
+	clearCoordStore(store);
+	ret = streamValues(file, &sink, stderr);
+	fclose(file);
+	if (ret == 0)
+	{
+		fprintf(stderr, "Error - 0 atoms were found in the file %s\n", path);
+		ret = 1;
+	}
+	else if (ret > 0)
+	{
+		cells = cellListAlloc(store, cutoff * CELL_MARGIN);
+		numOfPairs = cells ? findContacts(options->pool, cells, cutoff, &pairs) : -ENOMEM;
+		ret = numOfPairs < 0 ? numOfPairs : 0;
+		if (ret < 0)
+		{
+			fprintf(stderr, "Not enough memory for the contacts of %d atoms\n", store->size);
+		}
+	}
+
+	if (ret == 0)
+	{
+		printf("PDB file %s, %d atoms, %d residues were read\n", path, store->size, reader.numOfResidues);
+		if (isResidueMap)
+		{
+			ret = printResidueMap(&reader, pairs, numOfPairs, cutoff);
+		}
+		else
+		{
+			printf("Contacts within %.3f = %ld\n", cutoff, numOfPairs);
+			for (i = 0; i < numOfPairs; i++)
+			{
+				// atoms are numbered from 1, in the order of the file
+				printf("%d %d %.3f\n", pairs[i].first + 1, pairs[i].second + 1, pairs[i].distance);
+			}
+		}
+	}
+	free(pairs);
+	freeCellList(&cells);
+	free(reader.atomResidues);
+	free(reader.residues);
+	return (int) (ret < 0 ? -ret : ret);
+}
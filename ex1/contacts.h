@@ -0,0 +1,61 @@
+/**
+ * @file contacts.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for finding the atom pairs within a cutoff distance, using a
+ * cell list so the work is linear in the number of atoms for a fixed density.
+ */
+
+#ifndef CONTACTS_H
+#define CONTACTS_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+#include "coordStore.h"
+#include "cellList.h"
+
+
+/* --- Structs --- */
+
+/** Two atoms within the cutoff distance, first < second. */
+struct ContactPair
+{
+	int first;
+	int second;
+	float distance;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Finds all the pairs of points within a cutoff distance.
+ * The pairs come in the order of the cells, whatever the number of threads.
+ *
+ * @param pool the threads to search on, NULL to search on this thread.
+ * @param cells the cell list of the points, with cells at least cutoff wide.
+ * @param cutoff the cutoff distance.
+ * @param pairs the output pairs, receives an array to free with free.
+ * @return non negative integer - how many pairs were found.
+ *         negative integer - an error code.
+ */
+long findContacts(struct ThreadPool* pool, const struct CellList* cells, float cutoff, struct ContactPair** pairs);
+
+/**
+ * Finds the contacts in a pdb file and prints them.
+ * Prints either every atom pair, or every residue pair with the number of
+ * atom pairs between them.
+ *
+ * @param options how to calculate, only the pool is used.
+ * @param path the path of the file.
+ * @param cutoff the cutoff distance.
+ * @param isResidueMap 1 to print residue pairs, 0 to print atom pairs.
+ * @param store a scratch store for the atoms.
+ * @return 0 on success, the exit code otherwise.
+ */
+int analyzeContacts(const struct AnalysisOptions* options, const char* path, float cutoff, int isResidueMap,
+                    struct CoordStore* store);
+
+#endif
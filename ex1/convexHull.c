@@ -0,0 +1,666 @@
+/**
+ * @file convexHull.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the 3D convex hull, using the quickhull algorithm.
+ * All the geometry is done in double precision on the float input.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "convexHull.h"
+#include "allocator.h"
+
+
+/* --- Constants --- */
+
+/** Number of vertices (and edges) in a hull face. */
+#define FACE_SIZE 3
+
+/** Initial capacity of the faces array. */
+#define INITIAL_FACES_CAPACITY 64
+
+/** Relative tolerance used to decide if a point is above a face. */
+#define RELATIVE_EPSILON 1e-10
+
+/** Marks an empty list or a missing face. */
+#define NONE -1
+
+
+/* --- Structs --- */
+
+/** A triangular face of the hull, vertices are counter clockwise from the outside. */
+struct HullFace
+{
+	int vertices[FACE_SIZE];
+	// neighbors[k] is the face across the edge vertices[k] -> vertices[k + 1]
+	int neighbors[FACE_SIZE];
+	double normal[COORD_NUM];
+	double offset;
+	int outsideHead;
+	int furthestPoint;
+	double furthestDistance;
+	int isDeleted;
+	int visitStamp;
+};
+
+/** The state of a hull under construction. */
+struct Hull
+{
+	const struct Allocator* allocator;
+	double (*points)[COORD_NUM];
+	int numOfPoints;
+	double epsilon;
+
+	struct HullFace* faces;
+	int numOfFaces;
+	int facesCapacity;
+
+	// linked lists of the outside sets, one list per face
+	int* nextOutside;
+	// 1 for points that must be kept as hull points
+	char* isHullPoint;
+	// horizon edges of the current step, by their start and end vertices
+	int* horizonStart;
+	int* horizonEnd;
+	int* horizonVertices;
+	int* faceStack;
+	int faceStackCapacity;
+	int visitStamp;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Frees all the memory of the given hull.
+ *
+ * @param hull the hull to free.
+ */
+static void cleanupHull(struct Hull* hull)
+{
+	releaseMemory(hull->allocator, hull->points);
+	releaseMemory(hull->allocator, hull->faces);
+	releaseMemory(hull->allocator, hull->nextOutside);
+	releaseMemory(hull->allocator, hull->isHullPoint);
+	releaseMemory(hull->allocator, hull->horizonStart);
+	releaseMemory(hull->allocator, hull->horizonEnd);
+	releaseMemory(hull->allocator, hull->horizonVertices);
+	releaseMemory(hull->allocator, hull->faceStack);
+}
+
+/**
+ * Calculates the signed distance of a point from a face's plane.
+ *
+ * @param hull the hull.
+ * @param face the face.
+ * @param point the index of the point.
+ * @return The distance, positive above the face.
+ */
+static double faceDistance(struct Hull* hull, struct HullFace* face, int point)
+{
+	double* p = hull->points[point];
+	return face->normal[X_POS] * p[X_POS] + face->normal[Y_POS] * p[Y_POS] +
+	       face->normal[Z_POS] * p[Z_POS] - face->offset;
+}
+
+/**
+ * Pushes a face index to the hull's face stack, growing it if needed.
+ *
+ * @param hull the hull.
+ * @param size the current size of the stack, updated.
+ * @param face the face to push.
+ * @return 0 on success, an error code otherwise.
+ */
+static int pushFace(struct Hull* hull, int* size, int face)
+{
+	int* newStack;
+	if (*size == hull->faceStackCapacity)
+	{
+		newStack = resizeMemory(hull->allocator, hull->faceStack, sizeof(int) * hull->faceStackCapacity * 2);
+		if (!newStack)
+		{
+			return -ENOMEM;
+		}
+		hull->faceStack = newStack;
+		hull->faceStackCapacity *= 2;
+	}
+	hull->faceStack[(*size)++] = face;
+	return 0;
+}
+
+/**
+ * Adds a new face with the given vertices to the hull.
+ *
+ * @param hull the hull.
+ * @param a the first vertex.
+ * @param b the second vertex.
+ * @param c the third vertex.
+ * @return The new face's index, or a negative error code.
+ */
+static int addFace(struct Hull* hull, int a, int b, int c)
+{
+	struct HullFace* newFaces;
+	struct HullFace* face;
+	double u[COORD_NUM], v[COORD_NUM];
+	double length;
+	int i;
+
+	if (hull->numOfFaces == hull->facesCapacity)
+	{
+		newFaces = resizeMemory(hull->allocator, hull->faces, sizeof(struct HullFace) * hull->facesCapacity * 2);
+		if (!newFaces)
+		{
+			return -ENOMEM;
+		}
+		hull->faces = newFaces;
+		hull->facesCapacity *= 2;
+	}
+	face = &hull->faces[hull->numOfFaces];
+	face->vertices[0] = a;
+	face->vertices[1] = b;
+	face->vertices[2] = c;
+	for (i = 0; i < FACE_SIZE; i++)
+	{
+		face->neighbors[i] = NONE;
+		u[i] = hull->points[b][i] - hull->points[a][i];
+		v[i] = hull->points[c][i] - hull->points[a][i];
+	}
+	face->normal[X_POS] = u[Y_POS] * v[Z_POS] - u[Z_POS] * v[Y_POS];
+	face->normal[Y_POS] = u[Z_POS] * v[X_POS] - u[X_POS] * v[Z_POS];
+	face->normal[Z_POS] = u[X_POS] * v[Y_POS] - u[Y_POS] * v[X_POS];
+	length = sqrt(face->normal[X_POS] * face->normal[X_POS] + face->normal[Y_POS] * face->normal[Y_POS] +
+	              face->normal[Z_POS] * face->normal[Z_POS]);
+	if (length > 0)
+	{
+		for (i = 0; i < COORD_NUM; i++)
+		{
+			face->normal[i] /= length;
+		}
+	}
+	face->offset = face->normal[X_POS] * hull->points[a][X_POS] + face->normal[Y_POS] * hull->points[a][Y_POS] +
+	               face->normal[Z_POS] * hull->points[a][Z_POS];
+	face->outsideHead = NONE;
+	face->furthestPoint = NONE;
+	face->furthestDistance = 0;
+	face->isDeleted = 0;
+	face->visitStamp = 0;
+	return hull->numOfFaces++;
+}
+
+/**
+ * Assigns a point to the outside set of the first face it is above.
+ * Points that aren't above any face but are too close to tell are kept as hull points.
+ *
+ * @param hull the hull.
+ * @param point the point to assign.
+ * @param faces the candidate faces.
+ * @param numOfFaces how many candidate faces there are.
+ */
+static void assignPoint(struct Hull* hull, int point, int* faces, int numOfFaces)
+{
+	struct HullFace* face;
+	double distance;
+	double maxDistance = -HUGE_VAL;
+	int i;
+
+	for (i = 0; i < numOfFaces; i++)
+	{
+		face = &hull->faces[faces[i]];
+		distance = faceDistance(hull, face, point);
+		if (distance > hull->epsilon)
+		{
+			hull->nextOutside[point] = face->outsideHead;
+			face->outsideHead = point;
+			if (distance > face->furthestDistance)
+			{
+				face->furthestDistance = distance;
+				face->furthestPoint = point;
+			}
+			return;
+		}
+		if (distance > maxDistance)
+		{
+			maxDistance = distance;
+		}
+	}
+	if (maxDistance > -hull->epsilon)
+	{
+		hull->isHullPoint[point] = 1;
+	}
+}
+
+/**
+ * Sets the neighbor of a face across the edge from -> to.
+ *
+ * @param face the face to update.
+ * @param from the edge's first vertex.
+ * @param to the edge's second vertex.
+ * @param neighbor the new neighbor.
+ * @return 0 on success, -1 if the face has no such edge.
+ */
+static int setNeighbor(struct HullFace* face, int from, int to, int neighbor)
+{
+	int k;
+	for (k = 0; k < FACE_SIZE; k++)
+	{
+		if (face->vertices[k] == from && face->vertices[(k + 1) % FACE_SIZE] == to)
+		{
+			face->neighbors[k] = neighbor;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Finds the initial tetrahedron of the hull.
+ *
+ * @param hull the hull.
+ * @param simplex the output, four point indices.
+ * @return 1 if a non degenerate tetrahedron was found, 0 otherwise.
+ */
+static int findInitialSimplex(struct Hull* hull, int simplex[4])
+{
+	double (*p)[COORD_NUM] = hull->points;
+	int extremes[2 * COORD_NUM];
+	double bestDistance, distance;
+	double line[COORD_NUM], diff[COORD_NUM], cross[COORD_NUM], normal[COORD_NUM];
+	double length;
+	int i, j, axis;
+
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		extremes[2 * axis] = 0;
+		extremes[2 * axis + 1] = 0;
+	}
+	for (i = 1; i < hull->numOfPoints; i++)
+	{
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			if (p[i][axis] < p[extremes[2 * axis]][axis])
+			{
+				extremes[2 * axis] = i;
+			}
+			if (p[i][axis] > p[extremes[2 * axis + 1]][axis])
+			{
+				extremes[2 * axis + 1] = i;
+			}
+		}
+	}
+
+	// the two farthest extreme points
+	bestDistance = -1;
+	for (i = 0; i < 2 * COORD_NUM; i++)
+	{
+		for (j = i + 1; j < 2 * COORD_NUM; j++)
+		{
+			distance = 0;
+			for (axis = 0; axis < COORD_NUM; axis++)
+			{
+				diff[axis] = p[extremes[i]][axis] - p[extremes[j]][axis];
+				distance += diff[axis] * diff[axis];
+			}
+			if (distance > bestDistance)
+			{
+				bestDistance = distance;
+				simplex[0] = extremes[i];
+				simplex[1] = extremes[j];
+			}
+		}
+	}
+	if (sqrt(bestDistance) <= hull->epsilon)
+	{
+		return 0;
+	}
+
+	// the point farthest from the line
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		line[axis] = p[simplex[1]][axis] - p[simplex[0]][axis];
+	}
+	length = sqrt(line[X_POS] * line[X_POS] + line[Y_POS] * line[Y_POS] + line[Z_POS] * line[Z_POS]);
+	bestDistance = -1;
+	for (i = 0; i < hull->numOfPoints; i++)
+	{
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			diff[axis] = p[i][axis] - p[simplex[0]][axis];
+		}
+		cross[X_POS] = line[Y_POS] * diff[Z_POS] - line[Z_POS] * diff[Y_POS];
+		cross[Y_POS] = line[Z_POS] * diff[X_POS] - line[X_POS] * diff[Z_POS];
+		cross[Z_POS] = line[X_POS] * diff[Y_POS] - line[Y_POS] * diff[X_POS];
+		distance = cross[X_POS] * cross[X_POS] + cross[Y_POS] * cross[Y_POS] + cross[Z_POS] * cross[Z_POS];
+		if (distance > bestDistance)
+		{
+			bestDistance = distance;
+			simplex[2] = i;
+		}
+	}
+	if (sqrt(bestDistance) / length <= hull->epsilon)
+	{
+		return 0;
+	}
+
+	// the point farthest from the plane
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		diff[axis] = p[simplex[2]][axis] - p[simplex[0]][axis];
+	}
+	normal[X_POS] = line[Y_POS] * diff[Z_POS] - line[Z_POS] * diff[Y_POS];
+	normal[Y_POS] = line[Z_POS] * diff[X_POS] - line[X_POS] * diff[Z_POS];
+	normal[Z_POS] = line[X_POS] * diff[Y_POS] - line[Y_POS] * diff[X_POS];
+	length = sqrt(normal[X_POS] * normal[X_POS] + normal[Y_POS] * normal[Y_POS] + normal[Z_POS] * normal[Z_POS]);
+	bestDistance = -1;
+	for (i = 0; i < hull->numOfPoints; i++)
+	{
+		distance = 0;
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			distance += normal[axis] * (p[i][axis] - p[simplex[0]][axis]);
+		}
+		distance = fabs(distance);
+		if (distance > bestDistance)
+		{
+			bestDistance = distance;
+			simplex[3] = i;
+		}
+	}
+	return bestDistance / length > hull->epsilon;
+}
+
+/**
+ * Builds the initial tetrahedron faces and assigns all the points to them.
+ *
+ * @param hull the hull.
+ * @param simplex the four points of the tetrahedron.
+ * @return 0 on success, an error code otherwise.
+ */
+static int buildInitialHull(struct Hull* hull, int simplex[4])
+{
+	static const int FACE_VERTICES[4][FACE_SIZE] = {{0, 1, 2}, {0, 3, 1}, {1, 3, 2}, {2, 3, 0}};
+	int faces[4];
+	double centroid[COORD_NUM];
+	struct HullFace* face;
+	int i, j, k, l, ret, axis;
+
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		centroid[axis] = 0;
+		for (i = 0; i < 4; i++)
+		{
+			centroid[axis] += hull->points[simplex[i]][axis] / 4;
+		}
+	}
+	for (i = 0; i < 4; i++)
+	{
+		ret = addFace(hull, simplex[FACE_VERTICES[i][0]], simplex[FACE_VERTICES[i][1]],
+		              simplex[FACE_VERTICES[i][2]]);
+		if (ret < 0)
+		{
+			return ret;
+		}
+		face = &hull->faces[ret];
+		if (face->normal[X_POS] * centroid[X_POS] + face->normal[Y_POS] * centroid[Y_POS] +
+		    face->normal[Z_POS] * centroid[Z_POS] - face->offset > 0)
+		{
+			// facing inwards, flip it
+			hull->numOfFaces--;
+			ret = addFace(hull, simplex[FACE_VERTICES[i][0]], simplex[FACE_VERTICES[i][2]],
+			              simplex[FACE_VERTICES[i][1]]);
+		}
+		faces[i] = ret;
+		hull->isHullPoint[simplex[i]] = 1;
+	}
+
+	// every edge has exactly one reversed twin in the tetrahedron
+	for (i = 0; i < 4; i++)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			if (i == j)
+			{
+				continue;
+			}
+			for (k = 0; k < FACE_SIZE; k++)
+			{
+				face = &hull->faces[faces[j]];
+				for (l = 0; l < FACE_SIZE; l++)
+				{
+					if (face->vertices[l] == hull->faces[faces[i]].vertices[(k + 1) % FACE_SIZE] &&
+					    face->vertices[(l + 1) % FACE_SIZE] == hull->faces[faces[i]].vertices[k])
+					{
+						hull->faces[faces[i]].neighbors[k] = faces[j];
+					}
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < hull->numOfPoints; i++)
+	{
+		if (i != simplex[0] && i != simplex[1] && i != simplex[2] && i != simplex[3])
+		{
+			assignPoint(hull, i, faces, 4);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Adds the furthest outside point of a face to the hull.
+ *
+ * @param hull the hull.
+ * @param startFace the face whose furthest point is added.
+ * @return 0 on success, 1 if the hull became numerically inconsistent,
+ *         negative error code otherwise.
+ */
+static int addPointToHull(struct Hull* hull, int startFace)
+{
+	int eye = hull->faces[startFace].furthestPoint;
+	int stackSize = 0;
+	int numOfVisible = 0;
+	int numOfHorizon = 0;
+	int firstNewFace = hull->numOfFaces;
+	int numOfNewFaces;
+	int* newFaces;
+	int face, neighbor, from, to, point, nextPoint;
+	int i, k, ret;
+
+	hull->visitStamp++;
+	hull->faces[startFace].visitStamp = hull->visitStamp;
+	ret = pushFace(hull, &stackSize, startFace);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	// flood the faces visible from the eye point, visible faces end up at the bottom of the stack
+	while (numOfVisible < stackSize)
+	{
+		face = hull->faceStack[numOfVisible++];
+		for (k = 0; k < FACE_SIZE; k++)
+		{
+			neighbor = hull->faces[face].neighbors[k];
+			if (hull->faces[neighbor].visitStamp == hull->visitStamp)
+			{
+				continue;
+			}
+			if (faceDistance(hull, &hull->faces[neighbor], eye) > hull->epsilon)
+			{
+				hull->faces[neighbor].visitStamp = hull->visitStamp;
+				ret = pushFace(hull, &stackSize, neighbor);
+				if (ret < 0)
+				{
+					return ret;
+				}
+				continue;
+			}
+			from = hull->faces[face].vertices[k];
+			to = hull->faces[face].vertices[(k + 1) % FACE_SIZE];
+			if (hull->horizonStart[from] != NONE)
+			{
+				// the horizon isn't a simple loop
+				return 1;
+			}
+			ret = addFace(hull, from, to, eye);
+			if (ret < 0)
+			{
+				return ret;
+			}
+			hull->faces[ret].neighbors[0] = neighbor;
+			if (setNeighbor(&hull->faces[neighbor], to, from, ret) != 0)
+			{
+				return 1;
+			}
+			hull->horizonStart[from] = ret;
+			hull->horizonEnd[to] = ret;
+			hull->horizonVertices[numOfHorizon++] = from;
+		}
+	}
+
+	// connect the new faces to each other around the eye
+	numOfNewFaces = hull->numOfFaces - firstNewFace;
+	for (i = firstNewFace; i < hull->numOfFaces; i++)
+	{
+		hull->faces[i].neighbors[1] = hull->horizonStart[hull->faces[i].vertices[1]];
+		hull->faces[i].neighbors[2] = hull->horizonEnd[hull->faces[i].vertices[0]];
+		if (hull->faces[i].neighbors[1] == NONE || hull->faces[i].neighbors[2] == NONE)
+		{
+			return 1;
+		}
+	}
+	for (i = 0; i < numOfHorizon; i++)
+	{
+		from = hull->horizonVertices[i];
+		hull->horizonEnd[hull->faces[hull->horizonStart[from]].vertices[1]] = NONE;
+		hull->horizonStart[from] = NONE;
+	}
+	hull->isHullPoint[eye] = 1;
+
+	// the new faces are used as a list for the reassignment
+	newFaces = allocateMemory(hull->allocator, sizeof(int) * numOfNewFaces);
+	if (!newFaces)
+	{
+		return -ENOMEM;
+	}
+	for (i = 0; i < numOfNewFaces; i++)
+	{
+		newFaces[i] = firstNewFace + i;
+	}
+	for (i = 0; i < numOfVisible; i++)
+	{
+		face = hull->faceStack[i];
+		hull->faces[face].isDeleted = 1;
+		for (point = hull->faces[face].outsideHead; point != NONE; point = nextPoint)
+		{
+			nextPoint = hull->nextOutside[point];
+			if (point != eye)
+			{
+				assignPoint(hull, point, newFaces, numOfNewFaces);
+			}
+		}
+		hull->faces[face].outsideHead = NONE;
+	}
+	releaseMemory(hull->allocator, newFaces);
+	return 0;
+}
+
+int findHullPoints(const struct Allocator* allocator, const float* x, const float* y, const float* z,
+                   int numOfPoints, int* hullIndices)
+{
+	struct Hull hull;
+	double scale = 0;
+	int simplex[4];
+	int numOfHullPoints = 0;
+	int ret = 0;
+	int i, k, axis;
+
+	if (numOfPoints < 4)
+	{
+		return 0;
+	}
+
+	memset(&hull, 0, sizeof(hull));
+	hull.allocator = allocator;
+	hull.numOfPoints = numOfPoints;
+	hull.points = allocateMemory(allocator, sizeof(double) * COORD_NUM * numOfPoints);
+	hull.nextOutside = allocateMemory(allocator, sizeof(int) * numOfPoints);
+	hull.isHullPoint = allocateMemory(allocator, sizeof(char) * numOfPoints);
+	hull.horizonStart = allocateMemory(allocator, sizeof(int) * numOfPoints);
+	hull.horizonEnd = allocateMemory(allocator, sizeof(int) * numOfPoints);
+	hull.horizonVertices = allocateMemory(allocator, sizeof(int) * numOfPoints);
+	hull.faces = allocateMemory(allocator, sizeof(struct HullFace) * INITIAL_FACES_CAPACITY);
+	hull.facesCapacity = INITIAL_FACES_CAPACITY;
+	hull.faceStack = allocateMemory(allocator, sizeof(int) * INITIAL_FACES_CAPACITY);
+	hull.faceStackCapacity = INITIAL_FACES_CAPACITY;
+	if (!hull.points || !hull.nextOutside || !hull.isHullPoint || !hull.horizonStart ||
+	    !hull.horizonEnd || !hull.horizonVertices || !hull.faces || !hull.faceStack)
+	{
+		cleanupHull(&hull);
+		return -ENOMEM;
+	}
+	memset(hull.isHullPoint, 0, sizeof(char) * numOfPoints);
+
+	for (i = 0; i < numOfPoints; i++)
+	{
+		hull.points[i][X_POS] = x[i];
+		hull.points[i][Y_POS] = y[i];
+		hull.points[i][Z_POS] = z[i];
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			if (fabs(hull.points[i][axis]) > scale)
+			{
+				scale = fabs(hull.points[i][axis]);
+			}
+		}
+		hull.horizonStart[i] = NONE;
+		hull.horizonEnd[i] = NONE;
+	}
+	hull.epsilon = RELATIVE_EPSILON * (scale > 1 ? scale : 1);
+
+	if (findInitialSimplex(&hull, simplex))
+	{
+		ret = buildInitialHull(&hull, simplex);
+		// faces are appended as the hull grows, so a single pass visits all of them
+		for (i = 0; i < hull.numOfFaces && ret == 0; i++)
+		{
+			if (!hull.faces[i].isDeleted && hull.faces[i].outsideHead != NONE)
+			{
+				ret = addPointToHull(&hull, i);
+			}
+		}
+	}
+	else
+	{
+		ret = 1;
+	}
+
+	if (ret == 0)
+	{
+		for (i = 0; i < hull.numOfFaces; i++)
+		{
+			for (k = 0; k < FACE_SIZE && !hull.faces[i].isDeleted; k++)
+			{
+				hull.isHullPoint[hull.faces[i].vertices[k]] = 1;
+			}
+		}
+		for (i = 0; i < numOfPoints; i++)
+		{
+			if (hull.isHullPoint[i])
+			{
+				hullIndices[numOfHullPoints++] = i;
+			}
+		}
+	}
+	cleanupHull(&hull);
+	if (ret < 0)
+	{
+		return ret;
+	}
+	return numOfHullPoints;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file convexHull.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the 3D convex hull (quickhull) of a set of atoms.
+ */
+
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+
+/* --- Includes --- */
+
+#include "pdbStats.h"
+#include "allocator.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the points that lie on the convex hull of the given points.
+ * Points that are numerically too close to the hull surface to be told apart
+ * from it are reported as well, so the result can always replace the full set
+ * when searching for the two farthest points.
+ *
+ * @param allocator where the working memory comes from, NULL for malloc.
+ * @param x the x coordinates of the points.
+ * @param y the y coordinates of the points.
+ * @param z the z coordinates of the points.
+ * @param numOfPoints how many points there are.
+ * @param hullIndices the output array, at least numOfPoints long.
+ *        Receives the indices of the hull points.
+ * @return positive integer - how many hull points were found.
+ *         0 - the points are degenerate (too few, collinear or coplanar).
+ *         negative integer - an error code.
+ */
+int findHullPoints(const struct Allocator* allocator, const float* x, const float* y, const float* z,
+                   int numOfPoints, int* hullIndices);
+
+#endif
@@ -0,0 +1,230 @@
+/**
+ * @file coordCache.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the binary coordinates cache.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "coordCache.h"
+
+
+/* --- Constants --- */
+
+/** The first bytes of every cache file. */
+#define CACHE_MAGIC "PDBC"
+
+/** The length of CACHE_MAGIC. */
+#define CACHE_MAGIC_LENGTH 4
+
+/** The version of the format, changes whenever the layout does. */
+#define CACHE_VERSION 1
+
+/** Extra room in the path buffer, for the extension and the temporary suffix. */
+#define PATH_EXTRA 32
+
+/** The suffix of the temporary file a cache is written to, for mkstemp. */
+#define TEMP_SUFFIX ".XXXXXX"
+
+/** The permissions of a cache file. */
+#define CACHE_MODE 0644
+
+
+/* --- Structs --- */
+
+/**
+ * The header of a cache file, in the byte order of the machine.
+ * A cache from a machine with the other byte order has a wrong version.
+ */
+struct CacheHeader
+{
+	char magic[CACHE_MAGIC_LENGTH];
+	uint32_t version;
+	uint64_t numOfAtoms;
+	int64_t sourceSize;
+	int64_t sourceSeconds;
+	int64_t sourceNanoseconds;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Builds the path of the cache of a pdb file.
+ *
+ * @param path the path of the pdb file.
+ * @return The cache path, or NULL if there's no memory. Free with free.
+ */
+static char* cachePath(const char* path)
+{
+	char* result;
+
+	result = malloc(strlen(path) + PATH_EXTRA);
+	if (result)
+	{
+		strcpy(result, path);
+		strcat(result, CACHE_EXTENSION);
+	}
+	return result;
+}
+
+int getCacheKey(FILE* file, struct CacheKey* key)
+{
+	struct stat fileStat;
+
+	if (fstat(fileno(file), &fileStat) != 0)
+	{
+		return -errno;
+	}
+	if (!S_ISREG(fileStat.st_mode))
+	{
+		return -EINVAL;
+	}
+	key->size = fileStat.st_size;
+	key->modifiedSeconds = fileStat.st_mtim.tv_sec;
+	key->modifiedNanoseconds = fileStat.st_mtim.tv_nsec;
+	return 0;
+}
+
+int readCache(const char* path, const struct CacheKey* key, struct CoordStore* store)
+{
+	char* cacheFile;
+	int fd;
+	struct stat cacheStat;
+	const struct CacheHeader* header;
+	const float* values;
+	void* data;
+	size_t size;
+	int numOfAtoms;
+	int ret = 0;
+
+	cacheFile = cachePath(path);
+	if (!cacheFile)
+	{
+		return -ENOMEM;
+	}
+	fd = open(cacheFile, O_RDONLY);
+	free(cacheFile);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	if (fstat(fd, &cacheStat) != 0 || !S_ISREG(cacheStat.st_mode) ||
+	    (size_t) cacheStat.st_size < sizeof(struct CacheHeader))
+	{
+		close(fd);
+		return 0;
+	}
+	size = cacheStat.st_size;
+	data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	header = data;
+	values = (const float*) (header + 1);
+	if (memcmp(header->magic, CACHE_MAGIC, CACHE_MAGIC_LENGTH) == 0 && header->version == CACHE_VERSION &&
+	    header->sourceSize == key->size && header->sourceSeconds == key->modifiedSeconds &&
+	    header->sourceNanoseconds == key->modifiedNanoseconds &&
+	    header->numOfAtoms > 0 && header->numOfAtoms <= INT_MAX &&
+	    size == sizeof(struct CacheHeader) + sizeof(float) * COORD_NUM * header->numOfAtoms)
+	{
+		numOfAtoms = (int) header->numOfAtoms;
+		ret = assignCoords(store, values, values + numOfAtoms, values + 2 * (size_t) numOfAtoms, numOfAtoms);
+		if (ret == 0)
+		{
+			ret = numOfAtoms;
+		}
+	}
+	munmap(data, size);
+	return ret;
+}
+
+int writeCache(const char* path, const struct CacheKey* key, const struct CoordStore* store)
+{
+	char* finalPath;
+	char* tempPath;
+	FILE* file = NULL;
+	int fd;
+	struct CacheHeader header;
+	size_t count = store->size;
+	int ret = 0;
+
+	finalPath = cachePath(path);
+	tempPath = malloc(strlen(path) + PATH_EXTRA);
+	if (!finalPath || !tempPath)
+	{
+		free(finalPath);
+		free(tempPath);
+		return -ENOMEM;
+	}
+	// a unique name, so concurrent writers don't mix their caches
+	strcpy(tempPath, finalPath);
+	strcat(tempPath, TEMP_SUFFIX);
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, CACHE_MAGIC_LENGTH);
+	header.version = CACHE_VERSION;
+	header.numOfAtoms = count;
+	header.sourceSize = key->size;
+	header.sourceSeconds = key->modifiedSeconds;
+	header.sourceNanoseconds = key->modifiedNanoseconds;
+
+	fd = mkstemp(tempPath);
+	if (fd < 0)
+	{
+		ret = -errno;
+	}
+	else
+	{
+		// mkstemp makes the file private, caches are shared like the pdb files
+		fchmod(fd, CACHE_MODE);
+		file = fdopen(fd, "wb");
+		if (!file)
+		{
+			ret = -errno;
+			close(fd);
+			remove(tempPath);
+		}
+	}
+	if (file)
+	{
+		if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(store->x, sizeof(float), count, file) != count ||
+		    fwrite(store->y, sizeof(float), count, file) != count ||
+		    fwrite(store->z, sizeof(float), count, file) != count)
+		{
+			ret = -EIO;
+		}
+		if (fclose(file) != 0 && ret == 0)
+		{
+			ret = -EIO;
+		}
+		if (ret == 0 && rename(tempPath, finalPath) != 0)
+		{
+			ret = -errno;
+		}
+		if (ret != 0)
+		{
+			remove(tempPath);
+		}
+	}
+	free(finalPath);
+	free(tempPath);
+	return ret;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file coordCache.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the binary coordinates cache.
+ * The cache of a pdb file is kept next to it, with CACHE_EXTENSION added to
+ * its name. It holds a header with the number of atoms and the size and
+ * modification time of the pdb file, followed by the x, y and z arrays as
+ * float32. A cache is used only while the size and time still match.
+ */
+
+#ifndef COORD_CACHE_H
+#define COORD_CACHE_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include "coordStore.h"
+
+
+/* --- Constants --- */
+
+/** The extension added to the name of a pdb file for its cache. */
+#define CACHE_EXTENSION ".pdbc"
+
+
+/* --- Structs --- */
+
+/** What identifies a version of a pdb file. */
+struct CacheKey
+{
+	long long size;
+	long long modifiedSeconds;
+	long long modifiedNanoseconds;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Gets the key of an open pdb file.
+ *
+ * @param file the pdb file.
+ * @param key the output key.
+ * @return 0 on success, an error code if the file can't be cached,
+ *         for example if it isn't a regular file.
+ */
+int getCacheKey(FILE* file, struct CacheKey* key);
+
+/**
+ * Reads the atoms of a pdb file from its cache.
+ *
+ * @param path the path of the pdb file.
+ * @param key the key of the pdb file.
+ * @param store the output store.
+ * @return positive integer - how many atoms were read.
+ *         0 - there's no valid cache.
+ *         negative integer - an error code.
+ */
+int readCache(const char* path, const struct CacheKey* key, struct CoordStore* store);
+
+/**
+ * Writes the cache of a pdb file.
+ * The cache is written to a temporary file and renamed, so readers never
+ * see a partial cache.
+ *
+ * @param path the path of the pdb file.
+ * @param key the key of the pdb file, taken before it was read.
+ * @param store the atoms of the pdb file.
+ * @return 0 on success, an error code otherwise.
+ */
+int writeCache(const char* path, const struct CacheKey* key, const struct CoordStore* store);
+
+#endif
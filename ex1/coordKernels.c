@@ -0,0 +1,798 @@
+/**
+ * @file coordKernels.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the coordinate kernels.
+ * The sums are accumulated in double precision, so all the kernels agree on
+ * the printed results. The squared distances are calculated in float with the
+ * same operations in every kernel, so the maximum is identical in all of them.
+ * The cross covariance is calculated in double, where the products are exact.
+ * The moments are multiplied in float like the squared distances, and summed in double.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <math.h>
+#include "coordKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+
+/* --- Constants --- */
+
+/** How many different products the moments sum, the upper triangle of the covariance. */
+#define NUM_OF_PRODUCTS 6
+
+/** The coordinates multiplied in each product of the moments. */
+static const int PRODUCT_ROWS[NUM_OF_PRODUCTS] = {X_POS, X_POS, X_POS, Y_POS, Y_POS, Z_POS};
+static const int PRODUCT_COLUMNS[NUM_OF_PRODUCTS] = {X_POS, Y_POS, Z_POS, Y_POS, Z_POS, Z_POS};
+
+
+/* --- Scalar kernels --- */
+
+/**
+ * Scalar version of sumCoords, see coordKernels.h.
+ */
+static void sumCoordsScalar(const float* x, const float* y, const float* z, int numOfPoints,
+                            double sums[COORD_NUM])
+{
+	double xSum = 0, ySum = 0, zSum = 0;
+	int i;
+
+	for (i = 0; i < numOfPoints; i++)
+	{
+		xSum += x[i];
+		ySum += y[i];
+		zSum += z[i];
+	}
+	sums[X_POS] = xSum;
+	sums[Y_POS] = ySum;
+	sums[Z_POS] = zSum;
+}
+
+/**
+ * Scalar version of sumSquaredDistances, see coordKernels.h.
+ */
+static double sumSquaredDistancesScalar(const float* x, const float* y, const float* z, int numOfPoints,
+                                        const float center[COORD_NUM])
+{
+	double sum = 0;
+	float dx, dy, dz;
+	int i;
+
+	for (i = 0; i < numOfPoints; i++)
+	{
+		dx = x[i] - center[X_POS];
+		dy = y[i] - center[Y_POS];
+		dz = z[i] - center[Z_POS];
+		sum += dx * dx + dy * dy + dz * dz;
+	}
+	return sum;
+}
+
+/**
+ * Compares one point to a range of points, the common tail of all the versions.
+ *
+ * @param x the x coordinates.
+ * @param y the y coordinates.
+ * @param z the z coordinates.
+ * @param i the point to compare.
+ * @param first the first point of the range.
+ * @param last one past the last point of the range.
+ * @param maxDistance the maximum so far.
+ * @return The new maximum.
+ */
+static float maxSquaredDistanceRow(const float* x, const float* y, const float* z,
+                                   int i, int first, int last, float maxDistance)
+{
+	float dx, dy, dz, distance;
+	int j;
+
+	for (j = first; j < last; j++)
+	{
+		dx = x[j] - x[i];
+		dy = y[j] - y[i];
+		dz = z[j] - z[i];
+		distance = dx * dx + dy * dy + dz * dz;
+		if (distance > maxDistance)
+		{
+			maxDistance = distance;
+		}
+	}
+	return maxDistance;
+}
+
+/**
+ * Scalar version of maxSquaredDistance, see coordKernels.h.
+ */
+static float maxSquaredDistanceScalar(const float* x, const float* y, const float* z,
+                                      int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+	float maxDistance = 0;
+	int i;
+
+	for (i = firstRow; i < lastRow; i++)
+	{
+		maxDistance = maxSquaredDistanceRow(x, y, z, i, i + 1 > firstColumn ? i + 1 : firstColumn,
+		                                    lastColumn, maxDistance);
+	}
+	return maxDistance;
+}
+
+/**
+ * Scalar version of crossCovariance, see coordKernels.h.
+ */
+static void crossCovarianceScalar(const float* ax, const float* ay, const float* az,
+                                  const float* bx, const float* by, const float* bz, int numOfPoints,
+                                  double covariance[COORD_NUM * COORD_NUM])
+{
+	double sums[COORD_NUM * COORD_NUM] = {0};
+	double a[COORD_NUM], b[COORD_NUM];
+	int i, row, column;
+
+	for (i = 0; i < numOfPoints; i++)
+	{
+		a[X_POS] = ax[i];
+		a[Y_POS] = ay[i];
+		a[Z_POS] = az[i];
+		b[X_POS] = bx[i];
+		b[Y_POS] = by[i];
+		b[Z_POS] = bz[i];
+		for (row = 0; row < COORD_NUM; row++)
+		{
+			for (column = 0; column < COORD_NUM; column++)
+			{
+				sums[COORD_NUM * row + column] += a[row] * b[column];
+			}
+		}
+	}
+	memcpy(covariance, sums, sizeof(sums));
+}
+
+/**
+ * Fills moments from the sums of a kernel, the common end of all the versions.
+ *
+ * @param moments the output moments.
+ * @param squaredDistances the sum of the squared distances.
+ * @param products the sums of the products, in the order of PRODUCT_ROWS and PRODUCT_COLUMNS.
+ * @param minimum the lowest value of each coordinate.
+ * @param maximum the highest value of each coordinate.
+ * @param tail the moments of the points left after the vectors, NULL if there are none.
+ */
+static void storeMoments(struct CoordMoments* moments, double squaredDistances,
+                         const double products[NUM_OF_PRODUCTS], const float minimum[COORD_NUM],
+                         const float maximum[COORD_NUM], const struct CoordMoments* tail)
+{
+	int product, axis, i;
+
+	moments->squaredDistances = squaredDistances;
+	for (product = 0; product < NUM_OF_PRODUCTS; product++)
+	{
+		moments->covariance[COORD_NUM * PRODUCT_ROWS[product] + PRODUCT_COLUMNS[product]] = products[product];
+		moments->covariance[COORD_NUM * PRODUCT_COLUMNS[product] + PRODUCT_ROWS[product]] = products[product];
+	}
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		moments->minimum[axis] = minimum[axis];
+		moments->maximum[axis] = maximum[axis];
+	}
+	if (!tail)
+	{
+		return;
+	}
+	moments->squaredDistances += tail->squaredDistances;
+	for (i = 0; i < COORD_NUM * COORD_NUM; i++)
+	{
+		moments->covariance[i] += tail->covariance[i];
+	}
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		moments->minimum[axis] = fminf(moments->minimum[axis], tail->minimum[axis]);
+		moments->maximum[axis] = fmaxf(moments->maximum[axis], tail->maximum[axis]);
+	}
+}
+
+/**
+ * Scalar version of sumMoments, see coordKernels.h.
+ */
+static void sumMomentsScalar(const float* x, const float* y, const float* z, int numOfPoints,
+                             const float center[COORD_NUM], struct CoordMoments* moments)
+{
+	const float* coords[COORD_NUM] = {x, y, z};
+	double squaredDistances = 0;
+	double products[NUM_OF_PRODUCTS] = {0};
+	float minimum[COORD_NUM] = {HUGE_VALF, HUGE_VALF, HUGE_VALF};
+	float maximum[COORD_NUM] = {-HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+	float d[COORD_NUM];
+	int i, axis, product;
+
+	for (i = 0; i < numOfPoints; i++)
+	{
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			d[axis] = coords[axis][i] - center[axis];
+			minimum[axis] = fminf(minimum[axis], coords[axis][i]);
+			maximum[axis] = fmaxf(maximum[axis], coords[axis][i]);
+		}
+		squaredDistances += d[X_POS] * d[X_POS] + d[Y_POS] * d[Y_POS] + d[Z_POS] * d[Z_POS];
+		for (product = 0; product < NUM_OF_PRODUCTS; product++)
+		{
+			products[product] += d[PRODUCT_ROWS[product]] * d[PRODUCT_COLUMNS[product]];
+		}
+	}
+	storeMoments(moments, squaredDistances, products, minimum, maximum, NULL);
+}
+
+/** The scalar kernels. */
+static const struct CoordKernels SCALAR_KERNELS = {
+	KERNELS_SCALAR, sumCoordsScalar, sumSquaredDistancesScalar, maxSquaredDistanceScalar, crossCovarianceScalar,
+	sumMomentsScalar
+};
+
+
+#ifdef HAS_X86_KERNELS
+
+/* --- SSE2 kernels --- */
+
+/** How many floats are in an SSE register. */
+#define SSE_WIDTH 4
+
+/**
+ * Adds the four floats of a register to two double accumulators.
+ *
+ * @param sum the accumulator of the low two floats.
+ * @param sumHigh the accumulator of the high two floats.
+ * @param values the floats to add.
+ */
+#define SSE_ADD_TO_DOUBLES(sum, sumHigh, values) \
+	do \
+	{ \
+		(sum) = _mm_add_pd((sum), _mm_cvtps_pd(values)); \
+		(sumHigh) = _mm_add_pd((sumHigh), _mm_cvtps_pd(_mm_movehl_ps((values), (values)))); \
+	} while (0)
+
+/**
+ * Sums the two halves of double accumulators.
+ *
+ * @param sum the low accumulator.
+ * @param sumHigh the high accumulator.
+ * @return The total.
+ */
+__attribute__((target("sse2")))
+static double sseReduceDoubles(__m128d sum, __m128d sumHigh)
+{
+	double values[2];
+	_mm_storeu_pd(values, _mm_add_pd(sum, sumHigh));
+	return values[0] + values[1];
+}
+
+/**
+ * Finds the maximal float in a register.
+ *
+ * @param values the register.
+ * @return The maximal value.
+ */
+__attribute__((target("sse2")))
+static float sseReduceMax(__m128 values)
+{
+	values = _mm_max_ps(values, _mm_movehl_ps(values, values));
+	values = _mm_max_ss(values, _mm_shuffle_ps(values, values, 1));
+	return _mm_cvtss_f32(values);
+}
+
+/**
+ * Finds the minimal float in a register.
+ *
+ * @param values the register.
+ * @return The minimal value.
+ */
+__attribute__((target("sse2")))
+static float sseReduceMin(__m128 values)
+{
+	values = _mm_min_ps(values, _mm_movehl_ps(values, values));
+	values = _mm_min_ss(values, _mm_shuffle_ps(values, values, 1));
+	return _mm_cvtss_f32(values);
+}
+
+/**
+ * SSE2 version of sumCoords, see coordKernels.h.
+ */
+__attribute__((target("sse2")))
+static void sumCoordsSse(const float* x, const float* y, const float* z, int numOfPoints,
+                         double sums[COORD_NUM])
+{
+	__m128d xSum = _mm_setzero_pd(), xSumHigh = _mm_setzero_pd();
+	__m128d ySum = _mm_setzero_pd(), ySumHigh = _mm_setzero_pd();
+	__m128d zSum = _mm_setzero_pd(), zSumHigh = _mm_setzero_pd();
+	double tail[COORD_NUM];
+	int i;
+
+	for (i = 0; i + SSE_WIDTH <= numOfPoints; i += SSE_WIDTH)
+	{
+		SSE_ADD_TO_DOUBLES(xSum, xSumHigh, _mm_loadu_ps(x + i));
+		SSE_ADD_TO_DOUBLES(ySum, ySumHigh, _mm_loadu_ps(y + i));
+		SSE_ADD_TO_DOUBLES(zSum, zSumHigh, _mm_loadu_ps(z + i));
+	}
+	sumCoordsScalar(x + i, y + i, z + i, numOfPoints - i, tail);
+	sums[X_POS] = sseReduceDoubles(xSum, xSumHigh) + tail[X_POS];
+	sums[Y_POS] = sseReduceDoubles(ySum, ySumHigh) + tail[Y_POS];
+	sums[Z_POS] = sseReduceDoubles(zSum, zSumHigh) + tail[Z_POS];
+}
+
+/**
+ * SSE2 version of sumSquaredDistances, see coordKernels.h.
+ */
+__attribute__((target("sse2")))
+static double sumSquaredDistancesSse(const float* x, const float* y, const float* z, int numOfPoints,
+                                     const float center[COORD_NUM])
+{
+	__m128 cx = _mm_set1_ps(center[X_POS]);
+	__m128 cy = _mm_set1_ps(center[Y_POS]);
+	__m128 cz = _mm_set1_ps(center[Z_POS]);
+	__m128d sum = _mm_setzero_pd(), sumHigh = _mm_setzero_pd();
+	__m128 dx, dy, dz;
+	int i;
+
+	for (i = 0; i + SSE_WIDTH <= numOfPoints; i += SSE_WIDTH)
+	{
+		dx = _mm_sub_ps(_mm_loadu_ps(x + i), cx);
+		dy = _mm_sub_ps(_mm_loadu_ps(y + i), cy);
+		dz = _mm_sub_ps(_mm_loadu_ps(z + i), cz);
+		dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		SSE_ADD_TO_DOUBLES(sum, sumHigh, dx);
+	}
+	return sseReduceDoubles(sum, sumHigh) +
+	       sumSquaredDistancesScalar(x + i, y + i, z + i, numOfPoints - i, center);
+}
+
+/**
+ * SSE2 version of maxSquaredDistance, see coordKernels.h.
+ */
+__attribute__((target("sse2")))
+static float maxSquaredDistanceSse(const float* x, const float* y, const float* z,
+                                   int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+	__m128 maxDistance = _mm_setzero_ps();
+	__m128 xi, yi, zi, dx, dy, dz;
+	float tailMax = 0;
+	float vectorMax;
+	int i, j;
+
+	for (i = firstRow; i < lastRow; i++)
+	{
+		xi = _mm_set1_ps(x[i]);
+		yi = _mm_set1_ps(y[i]);
+		zi = _mm_set1_ps(z[i]);
+		for (j = i + 1 > firstColumn ? i + 1 : firstColumn; j + SSE_WIDTH <= lastColumn; j += SSE_WIDTH)
+		{
+			dx = _mm_sub_ps(_mm_loadu_ps(x + j), xi);
+			dy = _mm_sub_ps(_mm_loadu_ps(y + j), yi);
+			dz = _mm_sub_ps(_mm_loadu_ps(z + j), zi);
+			dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			maxDistance = _mm_max_ps(maxDistance, dx);
+		}
+		tailMax = maxSquaredDistanceRow(x, y, z, i, j, lastColumn, tailMax);
+	}
+	vectorMax = sseReduceMax(maxDistance);
+	return tailMax > vectorMax ? tailMax : vectorMax;
+}
+
+/**
+ * Loads two floats as doubles.
+ *
+ * @param values the floats.
+ * @return The doubles.
+ */
+__attribute__((target("sse2")))
+static __m128d sseLoadDoubles(const float* values)
+{
+	return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*) values)));
+}
+
+/**
+ * SSE2 version of crossCovariance, see coordKernels.h.
+ */
+__attribute__((target("sse2")))
+static void crossCovarianceSse(const float* ax, const float* ay, const float* az,
+                               const float* bx, const float* by, const float* bz, int numOfPoints,
+                               double covariance[COORD_NUM * COORD_NUM])
+{
+	__m128d sums[COORD_NUM * COORD_NUM];
+	__m128d a[COORD_NUM], b[COORD_NUM];
+	double tail[COORD_NUM * COORD_NUM];
+	double values[2];
+	int i, row, column;
+
+	for (i = 0; i < COORD_NUM * COORD_NUM; i++)
+	{
+		sums[i] = _mm_setzero_pd();
+	}
+	// two points at a time, in double
+	for (i = 0; i + 2 <= numOfPoints; i += 2)
+	{
+		a[X_POS] = sseLoadDoubles(ax + i);
+		a[Y_POS] = sseLoadDoubles(ay + i);
+		a[Z_POS] = sseLoadDoubles(az + i);
+		b[X_POS] = sseLoadDoubles(bx + i);
+		b[Y_POS] = sseLoadDoubles(by + i);
+		b[Z_POS] = sseLoadDoubles(bz + i);
+		for (row = 0; row < COORD_NUM; row++)
+		{
+			for (column = 0; column < COORD_NUM; column++)
+			{
+				sums[COORD_NUM * row + column] = _mm_add_pd(sums[COORD_NUM * row + column],
+				                                            _mm_mul_pd(a[row], b[column]));
+			}
+		}
+	}
+	crossCovarianceScalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, numOfPoints - i, tail);
+	for (i = 0; i < COORD_NUM * COORD_NUM; i++)
+	{
+		_mm_storeu_pd(values, sums[i]);
+		covariance[i] = values[0] + values[1] + tail[i];
+	}
+}
+
+/**
+ * SSE2 version of sumMoments, see coordKernels.h.
+ */
+__attribute__((target("sse2")))
+static void sumMomentsSse(const float* x, const float* y, const float* z, int numOfPoints,
+                          const float center[COORD_NUM], struct CoordMoments* moments)
+{
+	const float* coords[COORD_NUM] = {x, y, z};
+	__m128 centers[COORD_NUM], minimum[COORD_NUM], maximum[COORD_NUM], d[COORD_NUM];
+	__m128d sum = _mm_setzero_pd(), sumHigh = _mm_setzero_pd();
+	__m128d products[NUM_OF_PRODUCTS], productsHigh[NUM_OF_PRODUCTS];
+	__m128 values;
+	struct CoordMoments tail;
+	double productSums[NUM_OF_PRODUCTS];
+	float minimumValues[COORD_NUM], maximumValues[COORD_NUM];
+	int i, axis, product;
+
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		centers[axis] = _mm_set1_ps(center[axis]);
+		minimum[axis] = _mm_set1_ps(HUGE_VALF);
+		maximum[axis] = _mm_set1_ps(-HUGE_VALF);
+	}
+	for (product = 0; product < NUM_OF_PRODUCTS; product++)
+	{
+		products[product] = productsHigh[product] = _mm_setzero_pd();
+	}
+	for (i = 0; i + SSE_WIDTH <= numOfPoints; i += SSE_WIDTH)
+	{
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			values = _mm_loadu_ps(coords[axis] + i);
+			minimum[axis] = _mm_min_ps(minimum[axis], values);
+			maximum[axis] = _mm_max_ps(maximum[axis], values);
+			d[axis] = _mm_sub_ps(values, centers[axis]);
+		}
+		values = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d[X_POS], d[X_POS]), _mm_mul_ps(d[Y_POS], d[Y_POS])),
+		                    _mm_mul_ps(d[Z_POS], d[Z_POS]));
+		SSE_ADD_TO_DOUBLES(sum, sumHigh, values);
+		for (product = 0; product < NUM_OF_PRODUCTS; product++)
+		{
+			values = _mm_mul_ps(d[PRODUCT_ROWS[product]], d[PRODUCT_COLUMNS[product]]);
+			SSE_ADD_TO_DOUBLES(products[product], productsHigh[product], values);
+		}
+	}
+	sumMomentsScalar(x + i, y + i, z + i, numOfPoints - i, center, &tail);
+	for (product = 0; product < NUM_OF_PRODUCTS; product++)
+	{
+		productSums[product] = sseReduceDoubles(products[product], productsHigh[product]);
+	}
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		minimumValues[axis] = sseReduceMin(minimum[axis]);
+		maximumValues[axis] = sseReduceMax(maximum[axis]);
+	}
+	storeMoments(moments, sseReduceDoubles(sum, sumHigh), productSums, minimumValues, maximumValues, &tail);
+}
+
+/** The SSE2 kernels. */
+static const struct CoordKernels SSE_KERNELS = {
+	KERNELS_SSE, sumCoordsSse, sumSquaredDistancesSse, maxSquaredDistanceSse, crossCovarianceSse, sumMomentsSse
+};
+
+
+/* --- AVX2 kernels --- */
+
+/** How many floats are in an AVX register. */
+#define AVX_WIDTH 8
+
+/**
+ * Adds the eight floats of a register to two double accumulators.
+ *
+ * @param sum the accumulator of the low four floats.
+ * @param sumHigh the accumulator of the high four floats.
+ * @param values the floats to add.
+ */
+#define AVX_ADD_TO_DOUBLES(sum, sumHigh, values) \
+	do \
+	{ \
+		(sum) = _mm256_add_pd((sum), _mm256_cvtps_pd(_mm256_castps256_ps128(values))); \
+		(sumHigh) = _mm256_add_pd((sumHigh), _mm256_cvtps_pd(_mm256_extractf128_ps((values), 1))); \
+	} while (0)
+
+/**
+ * Sums the four quarters of double accumulators.
+ *
+ * @param sum the low accumulator.
+ * @param sumHigh the high accumulator.
+ * @return The total.
+ */
+__attribute__((target("avx2")))
+static double avxReduceDoubles(__m256d sum, __m256d sumHigh)
+{
+	double values[4];
+	_mm256_storeu_pd(values, _mm256_add_pd(sum, sumHigh));
+	return (values[0] + values[1]) + (values[2] + values[3]);
+}
+
+/**
+ * Finds the maximal float in a register.
+ *
+ * @param values the register.
+ * @return The maximal value.
+ */
+__attribute__((target("avx2")))
+static float avxReduceMax(__m256 values)
+{
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+	return _mm_cvtss_f32(half);
+}
+
+/**
+ * Finds the minimal float in a register.
+ *
+ * @param values the register.
+ * @return The minimal value.
+ */
+__attribute__((target("avx2")))
+static float avxReduceMin(__m256 values)
+{
+	__m128 half = _mm_min_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1));
+	half = _mm_min_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_min_ss(half, _mm_shuffle_ps(half, half, 1));
+	return _mm_cvtss_f32(half);
+}
+
+/**
+ * AVX2 version of sumCoords, see coordKernels.h.
+ */
+__attribute__((target("avx2")))
+static void sumCoordsAvx2(const float* x, const float* y, const float* z, int numOfPoints,
+                          double sums[COORD_NUM])
+{
+	__m256d xSum = _mm256_setzero_pd(), xSumHigh = _mm256_setzero_pd();
+	__m256d ySum = _mm256_setzero_pd(), ySumHigh = _mm256_setzero_pd();
+	__m256d zSum = _mm256_setzero_pd(), zSumHigh = _mm256_setzero_pd();
+	double tail[COORD_NUM];
+	int i;
+
+	for (i = 0; i + AVX_WIDTH <= numOfPoints; i += AVX_WIDTH)
+	{
+		AVX_ADD_TO_DOUBLES(xSum, xSumHigh, _mm256_loadu_ps(x + i));
+		AVX_ADD_TO_DOUBLES(ySum, ySumHigh, _mm256_loadu_ps(y + i));
+		AVX_ADD_TO_DOUBLES(zSum, zSumHigh, _mm256_loadu_ps(z + i));
+	}
+	sumCoordsScalar(x + i, y + i, z + i, numOfPoints - i, tail);
+	sums[X_POS] = avxReduceDoubles(xSum, xSumHigh) + tail[X_POS];
+	sums[Y_POS] = avxReduceDoubles(ySum, ySumHigh) + tail[Y_POS];
+	sums[Z_POS] = avxReduceDoubles(zSum, zSumHigh) + tail[Z_POS];
+}
+
+/**
+ * AVX2 version of sumSquaredDistances, see coordKernels.h.
+ */
+__attribute__((target("avx2")))
+static double sumSquaredDistancesAvx2(const float* x, const float* y, const float* z, int numOfPoints,
+                                      const float center[COORD_NUM])
+{
+	__m256 cx = _mm256_set1_ps(center[X_POS]);
+	__m256 cy = _mm256_set1_ps(center[Y_POS]);
+	__m256 cz = _mm256_set1_ps(center[Z_POS]);
+	__m256d sum = _mm256_setzero_pd(), sumHigh = _mm256_setzero_pd();
+	__m256 dx, dy, dz;
+	int i;
+
+	for (i = 0; i + AVX_WIDTH <= numOfPoints; i += AVX_WIDTH)
+	{
+		dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), cx);
+		dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), cy);
+		dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), cz);
+		dx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		AVX_ADD_TO_DOUBLES(sum, sumHigh, dx);
+	}
+	return avxReduceDoubles(sum, sumHigh) +
+	       sumSquaredDistancesScalar(x + i, y + i, z + i, numOfPoints - i, center);
+}
+
+/**
+ * AVX2 version of maxSquaredDistance, see coordKernels.h.
+ */
+__attribute__((target("avx2")))
+static float maxSquaredDistanceAvx2(const float* x, const float* y, const float* z,
+                                    int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+	__m256 maxDistance = _mm256_setzero_ps();
+	__m256 xi, yi, zi, dx, dy, dz;
+	float tailMax = 0;
+	float vectorMax;
+	int i, j;
+
+	for (i = firstRow; i < lastRow; i++)
+	{
+		xi = _mm256_set1_ps(x[i]);
+		yi = _mm256_set1_ps(y[i]);
+		zi = _mm256_set1_ps(z[i]);
+		for (j = i + 1 > firstColumn ? i + 1 : firstColumn; j + AVX_WIDTH <= lastColumn; j += AVX_WIDTH)
+		{
+			dx = _mm256_sub_ps(_mm256_loadu_ps(x + j), xi);
+			dy = _mm256_sub_ps(_mm256_loadu_ps(y + j), yi);
+			dz = _mm256_sub_ps(_mm256_loadu_ps(z + j), zi);
+			dx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+			                   _mm256_mul_ps(dz, dz));
+			maxDistance = _mm256_max_ps(maxDistance, dx);
+		}
+		tailMax = maxSquaredDistanceRow(x, y, z, i, j, lastColumn, tailMax);
+	}
+	vectorMax = avxReduceMax(maxDistance);
+	return tailMax > vectorMax ? tailMax : vectorMax;
+}
+
+/**
+ * AVX2 version of crossCovariance, see coordKernels.h.
+ */
+__attribute__((target("avx2")))
+static void crossCovarianceAvx2(const float* ax, const float* ay, const float* az,
+                                const float* bx, const float* by, const float* bz, int numOfPoints,
+                                double covariance[COORD_NUM * COORD_NUM])
+{
+	__m256d sums[COORD_NUM * COORD_NUM];
+	__m256d a[COORD_NUM], b[COORD_NUM];
+	double tail[COORD_NUM * COORD_NUM];
+	int i, row, column;
+
+	for (i = 0; i < COORD_NUM * COORD_NUM; i++)
+	{
+		sums[i] = _mm256_setzero_pd();
+	}
+	// four points at a time, in double
+	for (i = 0; i + 4 <= numOfPoints; i += 4)
+	{
+		a[X_POS] = _mm256_cvtps_pd(_mm_loadu_ps(ax + i));
+		a[Y_POS] = _mm256_cvtps_pd(_mm_loadu_ps(ay + i));
+		a[Z_POS] = _mm256_cvtps_pd(_mm_loadu_ps(az + i));
+		b[X_POS] = _mm256_cvtps_pd(_mm_loadu_ps(bx + i));
+		b[Y_POS] = _mm256_cvtps_pd(_mm_loadu_ps(by + i));
+		b[Z_POS] = _mm256_cvtps_pd(_mm_loadu_ps(bz + i));
+		for (row = 0; row < COORD_NUM; row++)
+		{
+			for (column = 0; column < COORD_NUM; column++)
+			{
+				sums[COORD_NUM * row + column] = _mm256_add_pd(sums[COORD_NUM * row + column],
+				                                               _mm256_mul_pd(a[row], b[column]));
+			}
+		}
+	}
+	crossCovarianceScalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, numOfPoints - i, tail);
+	for (i = 0; i < COORD_NUM * COORD_NUM; i++)
+	{
+		covariance[i] = avxReduceDoubles(sums[i], _mm256_setzero_pd()) + tail[i];
+	}
+}
+
+/**
+ * AVX2 version of sumMoments, see coordKernels.h.
+ */
+__attribute__((target("avx2")))
+static void sumMomentsAvx2(const float* x, const float* y, const float* z, int numOfPoints,
+                           const float center[COORD_NUM], struct CoordMoments* moments)
+{
+	const float* coords[COORD_NUM] = {x, y, z};
+	__m256 centers[COORD_NUM], minimum[COORD_NUM], maximum[COORD_NUM], d[COORD_NUM];
+	__m256d sum = _mm256_setzero_pd(), sumHigh = _mm256_setzero_pd();
+	__m256d products[NUM_OF_PRODUCTS], productsHigh[NUM_OF_PRODUCTS];
+	__m256 values;
+	struct CoordMoments tail;
+	double productSums[NUM_OF_PRODUCTS];
+	float minimumValues[COORD_NUM], maximumValues[COORD_NUM];
+	int i, axis, product;
+
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		centers[axis] = _mm256_set1_ps(center[axis]);
+		minimum[axis] = _mm256_set1_ps(HUGE_VALF);
+		maximum[axis] = _mm256_set1_ps(-HUGE_VALF);
+	}
+	for (product = 0; product < NUM_OF_PRODUCTS; product++)
+	{
+		products[product] = productsHigh[product] = _mm256_setzero_pd();
+	}
+	for (i = 0; i + AVX_WIDTH <= numOfPoints; i += AVX_WIDTH)
+	{
+		for (axis = 0; axis < COORD_NUM; axis++)
+		{
+			values = _mm256_loadu_ps(coords[axis] + i);
+			minimum[axis] = _mm256_min_ps(minimum[axis], values);
+			maximum[axis] = _mm256_max_ps(maximum[axis], values);
+			d[axis] = _mm256_sub_ps(values, centers[axis]);
+		}
+		values = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d[X_POS], d[X_POS]), _mm256_mul_ps(d[Y_POS], d[Y_POS])),
+		                       _mm256_mul_ps(d[Z_POS], d[Z_POS]));
+		AVX_ADD_TO_DOUBLES(sum, sumHigh, values);
+		for (product = 0; product < NUM_OF_PRODUCTS; product++)
+		{
+			values = _mm256_mul_ps(d[PRODUCT_ROWS[product]], d[PRODUCT_COLUMNS[product]]);
+			AVX_ADD_TO_DOUBLES(products[product], productsHigh[product], values);
+		}
+	}
+	sumMomentsScalar(x + i, y + i, z + i, numOfPoints - i, center, &tail);
+	for (product = 0; product < NUM_OF_PRODUCTS; product++)
+	{
+		productSums[product] = avxReduceDoubles(products[product], productsHigh[product]);
+	}
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		minimumValues[axis] = avxReduceMin(minimum[axis]);
+		maximumValues[axis] = avxReduceMax(maximum[axis]);
+	}
+	storeMoments(moments, avxReduceDoubles(sum, sumHigh), productSums, minimumValues, maximumValues, &tail);
+}
+
+/** The AVX2 kernels. */
+static const struct CoordKernels AVX2_KERNELS = {
+	KERNELS_AVX2, sumCoordsAvx2, sumSquaredDistancesAvx2, maxSquaredDistanceAvx2, crossCovarianceAvx2,
+	sumMomentsAvx2
+};
+
+#endif
+
+
+/* --- Functions --- */
+
+const struct CoordKernels* selectKernels(void)
+{
+#ifdef HAS_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return &AVX2_KERNELS;
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		return &SSE_KERNELS;
+	}
+#endif
+	return &SCALAR_KERNELS;
+}
+
+const struct CoordKernels* findKernels(const char* name)
+{
+	if (strcmp(name, KERNELS_SCALAR) == 0)
+	{
+		return &SCALAR_KERNELS;
+	}
+#ifdef HAS_X86_KERNELS
+	__builtin_cpu_init();
+	if (strcmp(name, KERNELS_SSE) == 0 && __builtin_cpu_supports("sse2"))
+	{
+		return &SSE_KERNELS;
+	}
+	if (strcmp(name, KERNELS_AVX2) == 0 && __builtin_cpu_supports("avx2"))
+	{
+		return &AVX2_KERNELS;
+	}
+#endif
+	return NULL;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file coordKernels.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the vectorized kernels over coordinate arrays.
+ * There is a scalar version of every kernel, and SSE2 and AVX2 versions
+ * on x86 processors that support them.
+ */
+
+#ifndef COORD_KERNELS_H
+#define COORD_KERNELS_H
+
+
+/* --- Includes --- */
+
+#include "pdbStats.h"
+
+
+/* --- Constants --- */
+
+/** Name of the scalar kernels. */
+#define KERNELS_SCALAR "scalar"
+
+/** Name of the SSE2 kernels. */
+#define KERNELS_SSE "sse"
+
+/** Name of the AVX2 kernels. */
+#define KERNELS_AVX2 "avx2"
+
+
+/* --- Structs --- */
+
+/** The second moments of points about a center, and their bounding box. */
+struct CoordMoments
+{
+	// the sum of the squared distances from the center, summed like sumSquaredDistances sums it
+	double squaredDistances;
+	// covariance[COORD_NUM * i + j] is the sum of d_i * d_j, d being a point minus the center
+	double covariance[COORD_NUM * COORD_NUM];
+	// the lowest and the highest value of each coordinate
+	float minimum[COORD_NUM];
+	float maximum[COORD_NUM];
+};
+
+/** A set of kernels for one instruction set. */
+struct CoordKernels
+{
+	const char* name;
+
+	/**
+	 * Sums each of the coordinates.
+	 *
+	 * @param x the x coordinates.
+	 * @param y the y coordinates.
+	 * @param z the z coordinates.
+	 * @param numOfPoints how many points there are.
+	 * @param sums the output, the sum of each coordinate.
+	 */
+	void (*sumCoords)(const float* x, const float* y, const float* z, int numOfPoints, double sums[COORD_NUM]);
+
+	/**
+	 * Sums the squared distances of all the points from a given point.
+	 *
+	 * @param x the x coordinates.
+	 * @param y the y coordinates.
+	 * @param z the z coordinates.
+	 * @param numOfPoints how many points there are.
+	 * @param center the point to measure from.
+	 * @return The sum of the squared distances.
+	 */
+	double (*sumSquaredDistances)(const float* x, const float* y, const float* z, int numOfPoints,
+	                              const float center[COORD_NUM]);
+
+	/**
+	 * Finds the maximum squared distance over a block of point pairs.
+	 * Every pair (i, j) with firstRow <= i < lastRow, firstColumn <= j < lastColumn
+	 * and i < j is compared.
+	 *
+	 * @param x the x coordinates.
+	 * @param y the y coordinates.
+	 * @param z the z coordinates.
+	 * @param firstRow the first point of the rows range.
+	 * @param lastRow one past the last point of the rows range.
+	 * @param firstColumn the first point of the columns range.
+	 * @param lastColumn one past the last point of the columns range.
+	 * @return The maximum squared distance, 0 if there are no pairs.
+	 */
+	float (*maxSquaredDistance)(const float* x, const float* y, const float* z,
+	                            int firstRow, int lastRow, int firstColumn, int lastColumn);
+
+	/**
+	 * Sums the products of the coordinates of matching points in two sets,
+	 * covariance[COORD_NUM * i + j] is the sum of a_i * b_j.
+	 *
+	 * @param ax the x coordinates of the first set.
+	 * @param ay the y coordinates of the first set.
+	 * @param az the z coordinates of the first set.
+	 * @param bx the x coordinates of the second set.
+	 * @param by the y coordinates of the second set.
+	 * @param bz the z coordinates of the second set.
+	 * @param numOfPoints how many points there are in each set.
+	 * @param covariance the output 3x3 matrix, row major.
+	 */
+	void (*crossCovariance)(const float* ax, const float* ay, const float* az,
+	                        const float* bx, const float* by, const float* bz, int numOfPoints,
+	                        double covariance[COORD_NUM * COORD_NUM]);
+
+	/**
+	 * Sums the second moments of all the points about a given point, and
+	 * finds their bounding box, in a single pass. The squared distances are
+	 * summed exactly like sumSquaredDistances sums them.
+	 *
+	 * @param x the x coordinates.
+	 * @param y the y coordinates.
+	 * @param z the z coordinates.
+	 * @param numOfPoints how many points there are.
+	 * @param center the point to measure from.
+	 * @param moments the output moments. The box is empty, from infinity to minus infinity, without points.
+	 */
+	void (*sumMoments)(const float* x, const float* y, const float* z, int numOfPoints,
+	                   const float center[COORD_NUM], struct CoordMoments* moments);
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Selects the best kernels the processor supports.
+ *
+ * @return The selected kernels.
+ */
+const struct CoordKernels* selectKernels(void);
+
+/**
+ * Finds kernels by name.
+ *
+ * @param name the kernels name, one of KERNELS_SCALAR, KERNELS_SSE or KERNELS_AVX2.
+ * @return The kernels, or NULL if they are unknown or the processor doesn't support them.
+ */
+const struct CoordKernels* findKernels(const char* name);
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * @file coordStore.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the coordinates store.
+ */
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include "coordStore.h"
+
+
+/* --- Constants --- */
+
+/** The capacity of a store on its first growth. */
+#define INITIAL_CAPACITY 4096
+
+
+/* --- Functions --- */
+
+struct CoordStore* coordStoreAlloc(const struct Allocator* allocator)
+{
+	struct CoordStore* store = allocateMemory(allocator, sizeof(struct CoordStore));
+	if (!store)
+	{
+		return NULL;
+	}
+	store->x = NULL;
+	store->y = NULL;
+	store->z = NULL;
+	store->size = 0;
+	store->capacity = 0;
+	store->allocator = allocator;
+	store->block = NULL;
+	return store;
+}
+
+void freeCoordStore(struct CoordStore** store)
+{
+	if (*store == NULL)
+	{
+		return;
+	}
+	// the three arrays share one block
+	releaseMemory((*store)->allocator, (*store)->block);
+	releaseMemory((*store)->allocator, *store);
+	*store = NULL;
+}
+
+void clearCoordStore(struct CoordStore* store)
+{
+	store->size = 0;
+}
+
+int reserveCoords(struct CoordStore* store, int capacity)
+{
+	void* block;
+	float* newX;
+	size_t arraySize;
+	uintptr_t address;
+
+	if (capacity <= store->capacity)
+	{
+		return 0;
+	}
+	if (capacity > INT_MAX - COORD_PADDING)
+	{
+		return -ENOMEM;
+	}
+	capacity = (capacity + COORD_PADDING - 1) / COORD_PADDING * COORD_PADDING;
+	arraySize = sizeof(float) * (size_t) capacity;
+	// room to move the start up to the alignment
+	block = allocateMemory(store->allocator, arraySize * COORD_NUM + COORD_ALIGNMENT - 1);
+	if (!block)
+	{
+		return -ENOMEM;
+	}
+	address = (uintptr_t) block;
+	newX = (float*) (address + (COORD_ALIGNMENT - address % COORD_ALIGNMENT) % COORD_ALIGNMENT);
+	if (store->size > 0)
+	{
+		memcpy(newX, store->x, sizeof(float) * store->size);
+		memcpy(newX + capacity, store->y, sizeof(float) * store->size);
+		memcpy(newX + 2 * (size_t) capacity, store->z, sizeof(float) * store->size);
+	}
+	releaseMemory(store->allocator, store->block);
+	store->block = block;
+	store->x = newX;
+	store->y = newX + capacity;
+	store->z = newX + 2 * (size_t) capacity;
+	store->capacity = capacity;
+	return 0;
+}
+
+int appendCoord(struct CoordStore* store, float x, float y, float z)
+{
+	int ret;
+
+	if (store->size == store->capacity)
+	{
+		// grow by half, so the unused tail stays small for big structures
+		if (store->capacity == 0)
+		{
+			ret = reserveCoords(store, INITIAL_CAPACITY);
+		}
+		else if (store->capacity > INT_MAX / 3 * 2)
+		{
+			ret = reserveCoords(store, INT_MAX - COORD_PADDING);
+		}
+		else
+		{
+			ret = reserveCoords(store, store->capacity + store->capacity / 2);
+		}
+		if (ret < 0 || store->size == store->capacity)
+		{
+			return -ENOMEM;
+		}
+	}
+	store->x[store->size] = x;
+	store->y[store->size] = y;
+	store->z[store->size] = z;
+	store->size++;
+	return 0;
+}
+
+int assignCoords(struct CoordStore* store, const float* x, const float* y, const float* z, int numOfPoints)
+{
+	int ret;
+
+	clearCoordStore(store);
+	ret = reserveCoords(store, numOfPoints);
+	if (ret < 0)
+	{
+		return ret;
+	}
+	memcpy(store->x, x, sizeof(float) * numOfPoints);
+	memcpy(store->y, y, sizeof(float) * numOfPoints);
+	memcpy(store->z, z, sizeof(float) * numOfPoints);
+	store->size = numOfPoints;
+	return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file coordStore.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for a growable store of atom coordinates.
+ */
+
+#ifndef COORD_STORE_H
+#define COORD_STORE_H
+
+
+/* --- Includes --- */
+
+#include "pdbStats.h"
+#include "allocator.h"
+
+
+/* --- Constants --- */
+
+/** Alignment in bytes of the coordinate arrays. */
+#define COORD_ALIGNMENT 64
+
+/** The capacity is always a multiple of this many points, so vector loads never pass the end. */
+#define COORD_PADDING 16
+
+
+/* --- Structs --- */
+
+/**
+ * A growable set of points, stored as separate x, y and z arrays.
+ * The arrays are aligned to COORD_ALIGNMENT and padded to COORD_PADDING points.
+ * The memory is kept when the store is cleared, so one store can be
+ * reused for many files.
+ */
+struct CoordStore
+{
+	float* x;
+	float* y;
+	float* z;
+	int size;
+	int capacity;
+	// where the memory comes from, NULL for malloc
+	const struct Allocator* allocator;
+	// the allocated block, x is the first aligned address in it
+	void* block;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Allocates a new empty store.
+ *
+ * @param allocator where the memory of the store comes from, NULL for malloc.
+ *        Must outlive the store.
+ * @return The new store, or NULL if there's no memory. Free with freeCoordStore.
+ */
+struct CoordStore* coordStoreAlloc(const struct Allocator* allocator);
+
+/**
+ * Frees the given store and sets it to NULL.
+ *
+ * @param store a pointer to the store to free.
+ */
+void freeCoordStore(struct CoordStore** store);
+
+/**
+ * Removes all the points from the store, keeping its memory.
+ *
+ * @param store the store to clear.
+ */
+void clearCoordStore(struct CoordStore* store);
+
+/**
+ * Makes sure the store can hold at least the given number of points.
+ *
+ * @param store the store to grow.
+ * @param capacity the required capacity.
+ * @return 0 on success, an error code otherwise.
+ */
+int reserveCoords(struct CoordStore* store, int capacity);
+
+/**
+ * Adds a point at the end of the store, growing it if needed.
+ *
+ * @param store the store to add to.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return 0 on success, an error code otherwise.
+ */
+int appendCoord(struct CoordStore* store, float x, float y, float z);
+
+/**
+ * Replaces the points of the store with the given arrays.
+ *
+ * @param store the store to fill.
+ * @param x the x coordinates.
+ * @param y the y coordinates.
+ * @param z the z coordinates.
+ * @param numOfPoints how many points there are.
+ * @return 0 on success, an error code otherwise.
+ */
+int assignCoords(struct CoordStore* store, const float* x, const float* y, const float* z, int numOfPoints);
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file diameterCoreset.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the diameter coreset.
+ */
+
+
+/* --- Includes --- */
+
+#include <errno.h>
+#include <math.h>
+#include "diameterCoreset.h"
+#include "allocator.h"
+
+
+/* --- Constants --- */
+
+/** Marks a column without points. */
+#define NO_POINT (-1)
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the bounding box of the points.
+ *
+ * @param store the points, must not be empty.
+ * @param minimum the output, the lowest value of each coordinate.
+ * @param maximum the output, the highest value of each coordinate.
+ */
+static void findBoundingBox(const struct CoordStore* store, float minimum[COORD_NUM], float maximum[COORD_NUM])
+{
+	const float* coords[COORD_NUM] = {store->x, store->y, store->z};
+	int axis;
+	int i;
+
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		minimum[axis] = maximum[axis] = coords[axis][0];
+		for (i = 1; i < store->size; i++)
+		{
+			minimum[axis] = fminf(minimum[axis], coords[axis][i]);
+			maximum[axis] = fmaxf(maximum[axis], coords[axis][i]);
+		}
+	}
+}
+
+int findDiameterCoreset(const struct CoordStore* store, float epsilon, struct CoordStore* coreset, float* maxError)
+{
+	const float* coords[COORD_NUM] = {store->x, store->y, store->z};
+	float minimum[COORD_NUM];
+	float maximum[COORD_NUM];
+	int* lowest;
+	int* highest;
+	int longAxis = X_POS;
+	int firstAxis, secondAxis;
+	double firstColumns, secondColumns;
+	double columnWidth;
+	int numOfColumns;
+	int column;
+	int axis;
+	int i;
+
+	clearCoordStore(coreset);
+	if (store->size == 0)
+	{
+		return 0;
+	}
+	findBoundingBox(store, minimum, maximum);
+	for (axis = Y_POS; axis < COORD_NUM; axis++)
+	{
+		if (maximum[axis] - minimum[axis] > maximum[longAxis] - minimum[longAxis])
+		{
+			longAxis = axis;
+		}
+	}
+	firstAxis = (longAxis + 1) % COORD_NUM;
+	secondAxis = (longAxis + 2) % COORD_NUM;
+
+	// the longest side is at most the diameter, and each end moves at most a column diagonal
+	columnWidth = epsilon * (maximum[longAxis] - minimum[longAxis]) / (2 * sqrt(2));
+	if (!(columnWidth > 0))
+	{
+		return 0;
+	}
+	firstColumns = floor((maximum[firstAxis] - minimum[firstAxis]) / columnWidth) + 1;
+	secondColumns = floor((maximum[secondAxis] - minimum[secondAxis]) / columnWidth) + 1;
+	if (2 * firstColumns * secondColumns >= store->size)
+	{
+		return 0;
+	}
+	numOfColumns = (int) (firstColumns * secondColumns);
+
+	lowest = allocateMemory(coreset->allocator, sizeof(int) * numOfColumns);
+	highest = allocateMemory(coreset->allocator, sizeof(int) * numOfColumns);
+	if (!lowest || !highest || reserveCoords(coreset, 2 * numOfColumns) < 0)
+	{
+		releaseMemory(coreset->allocator, lowest);
+		releaseMemory(coreset->allocator, highest);
+		return -ENOMEM;
+	}
+	for (column = 0; column < numOfColumns; column++)
+	{
+		lowest[column] = highest[column] = NO_POINT;
+	}
+
+	for (i = 0; i < store->size; i++)
+	{
+		int first = (int) ((coords[firstAxis][i] - minimum[firstAxis]) / columnWidth);
+		int second = (int) ((coords[secondAxis][i] - minimum[secondAxis]) / columnWidth);
+		// rounding may put the farthest points one column too far
+		column = (first < firstColumns ? first : (int) firstColumns - 1) * (int) secondColumns +
+		         (second < secondColumns ? second : (int) secondColumns - 1);
+		if (lowest[column] == NO_POINT || coords[longAxis][i] < coords[longAxis][lowest[column]])
+		{
+			lowest[column] = i;
+		}
+		if (highest[column] == NO_POINT || coords[longAxis][i] > coords[longAxis][highest[column]])
+		{
+			highest[column] = i;
+		}
+	}
+
+	for (column = 0; column < numOfColumns; column++)
+	{
+		if (lowest[column] == NO_POINT)
+		{
+			continue;
+		}
+		appendCoord(coreset, store->x[lowest[column]], store->y[lowest[column]], store->z[lowest[column]]);
+		if (highest[column] != lowest[column])
+		{
+			appendCoord(coreset, store->x[highest[column]], store->y[highest[column]], store->z[highest[column]]);
+		}
+	}
+	releaseMemory(coreset->allocator, lowest);
+	releaseMemory(coreset->allocator, highest);
+	*maxError = (float) (2 * sqrt(2) * columnWidth);
+	return coreset->size;
+}
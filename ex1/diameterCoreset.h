@@ -0,0 +1,39 @@
+/**
+ * @file diameterCoreset.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for a small subset of points with almost the same diameter.
+ * The points are split into columns along the longest axis of their bounding
+ * box, and only the lowest and highest point of each column are kept.
+ * Any point lies between the two kept points of its column, so the diameter
+ * of the subset is off by at most twice the width of a column diagonal.
+ */
+
+#ifndef DIAMETER_CORESET_H
+#define DIAMETER_CORESET_H
+
+
+/* --- Includes --- */
+
+#include "coordStore.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Finds a subset of points whose diameter is within an error of the full diameter.
+ * The subset diameter is never more than the full diameter, and never less
+ * than it by more than maxError, which is at most epsilon times the full diameter.
+ * Takes time linear in the number of points.
+ *
+ * @param store the points.
+ * @param epsilon the relative error allowed, between 0 and 1.
+ * @param coreset the output subset, cleared first.
+ * @param maxError the output, the most the subset diameter may be less than the full one.
+ * @return positive integer - how many points the subset has.
+ *         0 - the subset would not be much smaller than the points, nothing was found.
+ *         negative integer - an error code.
+ */
+int findDiameterCoreset(const struct CoordStore* store, float epsilon, struct CoordStore* coreset, float* maxError);
+
+#endif
@@ -0,0 +1,505 @@
+/**
+ * @file pdbBenchmark.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Times each phase of the analysis on synthetic pdb files of growing sizes,
+ * and reports the rates as JSON.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <libgen.h>
+#include <getopt.h>
+#include "storeAnalysis.h"
+#include "coordStore.h"
+#include "coordKernels.h"
+#include "threadPool.h"
+#include "syntheticPdb.h"
+
+
+/* --- Constants --- */
+
+/** The runs when none are given, the shape, atoms per model and models. */
+static const char* const DEFAULT_RUNS[] = {"blob:1000", "blob:10000", "blob:100000", "blob:1000000",
+                                           "fibril:1000", "fibril:10000", "fibril:100000", "fibril:1000000",
+                                           "blob:10000x100"};
+
+/** How many default runs there are. */
+#define NUM_OF_DEFAULT_RUNS 9
+
+/** Small runs are repeated until each phase handles at least this many atoms. */
+#define MIN_WORK_ATOMS 2000000L
+
+/** The pairwise Dmax is repeated until it compares at least this many pairs. */
+#define MIN_WORK_PAIRS 100000000.0
+
+/** The pairwise Dmax is skipped above this many atoms. */
+#define DEFAULT_MAX_PAIRS_ATOMS 20000
+
+/** The relative error of the approximate Dmax when none is given. */
+#define DEFAULT_EPSILON 0.01f
+
+/** The most threads allowed. */
+#define MAX_THREADS 1024
+
+/** The seed of all the runs, fixed so runs are repeatable. */
+#define BENCHMARK_SEED 1
+
+
+/* --- Structs --- */
+
+/** One file to time. */
+struct BenchmarkRun
+{
+	const char* shape;
+	long numOfAtoms;
+	int numOfModels;
+};
+
+/** How the benchmark runs. */
+struct BenchmarkOptions
+{
+	const struct CoordKernels* kernels;
+	struct ThreadPool* pool;
+	int numOfThreads;
+	long maxPairsAtoms;
+	float epsilon;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Prints the usage message and exits.
+ *
+ * @param programPath the path of the program, argv[0].
+ */
+static void printUsage(char* programPath)
+{
+	fprintf(stderr, "Usage: %s [-j threads] [--kernels=%s|%s|%s] [--max-pairs=atoms] [--eps=e] [--output=file] "
+	        "[%s|%s:atoms[xmodels]] ...\n",
+	        basename(programPath), KERNELS_AVX2, KERNELS_SSE, KERNELS_SCALAR, SHAPE_BLOB, SHAPE_FIBRIL);
+	exit(1);
+}
+
+/**
+ * Parses a number argument.
+ *
+ * @param arg the argument.
+ * @param minimum the smallest valid number.
+ * @param maximum the largest valid number.
+ * @param programPath the path of the program, for the usage message.
+ * @return The number. Exits on invalid arguments.
+ */
+static long parseNumber(char* arg, long minimum, long maximum, char* programPath)
+{
+	char* endPtr;
+	long number;
+
+	number = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || number < minimum || number > maximum)
+	{
+		printUsage(programPath);
+	}
+	return number;
+}
+
+/**
+ * Parses a run argument, shape:atoms or shape:atomsxmodels.
+ *
+ * @param arg the argument.
+ * @param run the output run.
+ * @return 0 on success, -EINVAL if the argument is invalid.
+ */
+static int parseRun(const char* arg, struct BenchmarkRun* run)
+{
+	const char* numbers = strchr(arg, ':');
+	char* endPtr;
+
+	if (!numbers)
+	{
+		return -EINVAL;
+	}
+	if ((size_t) (numbers - arg) == strlen(SHAPE_BLOB) && strncmp(arg, SHAPE_BLOB, numbers - arg) == 0)
+	{
+		run->shape = SHAPE_BLOB;
+	}
+	else if ((size_t) (numbers - arg) == strlen(SHAPE_FIBRIL) && strncmp(arg, SHAPE_FIBRIL, numbers - arg) == 0)
+	{
+		run->shape = SHAPE_FIBRIL;
+	}
+	else
+	{
+		return -EINVAL;
+	}
+
+	numbers++;
+	run->numOfAtoms = strtol(numbers, &endPtr, 10);
+	run->numOfModels = 1;
+	if (endPtr == numbers)
+	{
+		return -EINVAL;
+	}
+	if (*endPtr == 'x')
+	{
+		numbers = endPtr + 1;
+		run->numOfModels = (int) strtol(numbers, &endPtr, 10);
+		if (endPtr == numbers)
+		{
+			return -EINVAL;
+		}
+	}
+	return *endPtr == '\0' ? 0 : -EINVAL;
+}
+
+/**
+ * Gets the time of a monotonic clock.
+ *
+ * @return The time in seconds.
+ */
+static double getTime(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Calculates how many times to repeat a phase, so small runs are timed well.
+ *
+ * @param work how much work one repeat does.
+ * @param minimumWork how much work all the repeats should do together.
+ * @return How many times to repeat.
+ */
+static int countRepeats(double work, double minimumWork)
+{
+	return work >= minimumWork ? 1 : (int) (minimumWork / work + 0.5);
+}
+
+/**
+ * Prints the timing of a phase that goes over the atoms.
+ *
+ * @param output the stream to print to.
+ * @param name the name of the phase.
+ * @param repeats how many times the phase was repeated.
+ * @param seconds how long all the repeats took.
+ * @param numOfAtoms how many atoms each repeat went over.
+ */
+static void printAtomsPhase(FILE* output, const char* name, int repeats, double seconds, long numOfAtoms)
+{
+	fprintf(output, "      \"%s\": {\"repeats\": %d, \"seconds\": %.6g, \"atomsPerSecond\": %.6g},\n",
+	        name, repeats, seconds / repeats, numOfAtoms * repeats / seconds);
+}
+
+/**
+ * Generates a synthetic file into memory.
+ *
+ * @param run the file to generate.
+ * @param size the output size of the file.
+ * @return The contents, or NULL if there's no memory. Free with free.
+ */
+static char* generateFile(const struct BenchmarkRun* run, size_t* size)
+{
+	struct SyntheticPdb pdb;
+	char* data;
+
+	initSyntheticPdb(&pdb, run->shape, run->numOfAtoms, run->numOfModels, BENCHMARK_SEED);
+	*size = syntheticPdbSize(&pdb);
+	data = malloc(*size);
+	if (data)
+	{
+		writeSyntheticLines(&pdb, data, *size);
+	}
+	return data;
+}
+
+/**
+ * Times the phases of one run on a generated file and prints them.
+ *
+ * @param options how to run.
+ * @param run the file to time.
+ * @param data the contents of the file.
+ * @param size the size of the contents.
+ * @param handle the handle to parse with.
+ * @param hullStore a scratch store for the hull points.
+ * @param output the stream to print to.
+ * @return 0 on success, the exit code otherwise.
+ */
+static int timePhases(const struct BenchmarkOptions* options, const struct BenchmarkRun* run, const char* data,
+                      size_t size, struct PdbStats* handle, struct CoordStore* hullStore, FILE* output)
+{
+	const struct CoordStore* store;
+	float centerOfGravity[COORD_NUM];
+	float turnRadius = 0;
+	float maxDistance = 0;
+	float bound;
+	long numOfAtoms = run->numOfAtoms * run->numOfModels;
+	double pairs;
+	double start;
+	double seconds;
+	int repeats;
+	int ret = 0;
+	int i;
+
+	repeats = countRepeats(numOfAtoms, MIN_WORK_ATOMS);
+	start = getTime();
+	for (i = 0; i < repeats && ret >= 0; i++)
+	{
+		ret = parsePdbBuffer(handle, data, size);
+	}
+	seconds = getTime() - start;
+	if (ret < 0)
+	{
+		fprintf(stderr, "Error parsing the file %s:%ld: %s\n", run->shape, numOfAtoms, pdbStatsError(ret));
+		return EINVAL;
+	}
+	fprintf(output, "      \"parse\": {\"repeats\": %d, \"seconds\": %.6g, \"atomsPerSecond\": %.6g, "
+	        "\"bytesPerSecond\": %.6g},\n", repeats, seconds / repeats, numOfAtoms * repeats / seconds,
+	        size * (double) repeats / seconds);
+
+	store = getPdbAtoms(handle);
+	start = getTime();
+	for (i = 0; i < repeats; i++)
+	{
+		calculateCenterOfGravity(options->kernels, store, centerOfGravity);
+	}
+	printAtomsPhase(output, "centerOfGravity", repeats, getTime() - start, numOfAtoms);
+
+	start = getTime();
+	for (i = 0; i < repeats; i++)
+	{
+		turnRadius = calculateTurnRadius(options->kernels, store, centerOfGravity);
+	}
+	printAtomsPhase(output, "turnRadius", repeats, getTime() - start, numOfAtoms);
+
+	start = getTime();
+	for (i = 0; i < repeats; i++)
+	{
+		maxDistance = calculateMaxDistanceHull(options->pool, options->kernels, store, hullStore);
+	}
+	seconds = getTime() - start;
+	// the hull points are compared pairwise, all the points if there's no hull
+	pairs = hullStore->size > 0 ? hullStore->size : numOfAtoms;
+	pairs = pairs * (pairs - 1) / 2;
+	fprintf(output, "      \"maxDistanceHull\": {\"repeats\": %d, \"seconds\": %.6g, \"atomsPerSecond\": %.6g, "
+	        "\"hullPoints\": %d, \"pairsPerSecond\": %.6g},\n", repeats, seconds / repeats,
+	        numOfAtoms * repeats / seconds, hullStore->size, pairs * repeats / seconds);
+
+	start = getTime();
+	for (i = 0; i < repeats; i++)
+	{
+		calculateMaxDistanceApprox(options->pool, options->kernels, store, hullStore, options->epsilon, &bound);
+	}
+	seconds = getTime() - start;
+	fprintf(output, "      \"maxDistanceApprox\": {\"repeats\": %d, \"seconds\": %.6g, \"atomsPerSecond\": %.6g, "
+	        "\"epsilon\": %g, \"bound\": %.3f},\n", repeats, seconds / repeats, numOfAtoms * repeats / seconds,
+	        options->epsilon, bound);
+
+	fprintf(output, "      \"maxDistancePairs\": ");
+	if (numOfAtoms <= options->maxPairsAtoms)
+	{
+		pairs = (double) numOfAtoms * (numOfAtoms - 1) / 2;
+		repeats = countRepeats(pairs, MIN_WORK_PAIRS);
+		start = getTime();
+		for (i = 0; i < repeats; i++)
+		{
+			calculateMaxDistance(options->pool, options->kernels, store);
+		}
+		seconds = getTime() - start;
+		fprintf(output, "{\"repeats\": %d, \"seconds\": %.6g, \"pairsPerSecond\": %.6g},\n",
+		        repeats, seconds / repeats, pairs * repeats / seconds);
+	}
+	else
+	{
+		fprintf(output, "null,\n");
+	}
+
+	// the results, so a change in them shows up next to the times
+	fprintf(output, "      \"result\": {\"turnRadius\": %.3f, \"maxDistance\": %.3f}\n", turnRadius, maxDistance);
+	return 0;
+}
+
+/**
+ * Generates the file of one run, times all its phases and prints them.
+ *
+ * @param options how to run.
+ * @param run the file to time.
+ * @param output the stream to print to.
+ * @param isLast whether this is the last run, so no comma follows it.
+ * @return 0 on success, the exit code otherwise.
+ */
+static int runBenchmark(const struct BenchmarkOptions* options, const struct BenchmarkRun* run, FILE* output,
+                        int isLast)
+{
+	struct PdbStats* handle;
+	struct CoordStore* hullStore;
+	long numOfAtoms = run->numOfAtoms * run->numOfModels;
+	double start;
+	double seconds;
+	char* data;
+	size_t size;
+	int ret = 0;
+
+	start = getTime();
+	data = generateFile(run, &size);
+	seconds = getTime() - start;
+	handle = pdbStatsAlloc(NULL);
+	hullStore = coordStoreAlloc(NULL);
+	if (!data || !handle || !hullStore)
+	{
+		fprintf(stderr, "Error allocating the file %s:%ld\n", run->shape, numOfAtoms);
+		ret = ENOMEM;
+	}
+	else
+	{
+		fprintf(output, "    {\n      \"shape\": \"%s\", \"atoms\": %ld, \"models\": %d, \"bytes\": %lu,\n",
+		        run->shape, numOfAtoms, run->numOfModels, (unsigned long) size);
+		printAtomsPhase(output, "generate", 1, seconds, numOfAtoms);
+		ret = timePhases(options, run, data, size, handle, hullStore, output);
+		fprintf(output, "    }%s\n", isLast ? "" : ",");
+	}
+
+	freeCoordStore(&hullStore);
+	freePdbStats(&handle);
+	free(data);
+	return ret;
+}
+
+
+/* --- Main --- */
+
+/**
+ * The main function.
+ *
+ * @param argc the number of arguments.
+ * @param argv An array of strings, the arguments of the program.
+ * @return 0 in a succesful execution, other in case of an error.
+ */
+int main(int argc, char *argv[])
+{
+	struct BenchmarkOptions options;
+	struct BenchmarkRun* runs;
+	struct SyntheticPdb pdb;
+	const char* const* runArgs;
+	int numOfRuns;
+	FILE* output = stdout;
+	char* outputPath = NULL;
+	char* endPtr;
+	int ret = 0;
+	int option;
+	int i;
+	static struct option longOptions[] = {
+		{"kernels", required_argument, NULL, 'k'},
+		{"threads", required_argument, NULL, 'j'},
+		{"max-pairs", required_argument, NULL, 'p'},
+		{"eps", required_argument, NULL, 'e'},
+		{"output", required_argument, NULL, 'o'},
+		{NULL, 0, NULL, 0}
+	};
+
+	options.kernels = selectKernels();
+	options.pool = NULL;
+	options.numOfThreads = 1;
+	options.maxPairsAtoms = DEFAULT_MAX_PAIRS_ATOMS;
+	options.epsilon = DEFAULT_EPSILON;
+
+	while ((option = getopt_long(argc, argv, "j:", longOptions, NULL)) != -1)
+	{
+		if (option == 'k' && findKernels(optarg) != NULL)
+		{
+			options.kernels = findKernels(optarg);
+		}
+		else if (option == 'j')
+		{
+			options.numOfThreads = (int) parseNumber(optarg, 1, MAX_THREADS, argv[0]);
+		}
+		else if (option == 'p')
+		{
+			options.maxPairsAtoms = parseNumber(optarg, 0, INT_MAX, argv[0]);
+		}
+		else if (option == 'e')
+		{
+			options.epsilon = strtof(optarg, &endPtr);
+			if (endPtr == optarg || *endPtr != '\0' || !(options.epsilon > 0) || !(options.epsilon < 1))
+			{
+				printUsage(argv[0]);
+			}
+		}
+		else if (option == 'o')
+		{
+			outputPath = optarg;
+		}
+		else
+		{
+			printUsage(argv[0]);
+		}
+	}
+
+	numOfRuns = optind < argc ? argc - optind : NUM_OF_DEFAULT_RUNS;
+	runArgs = optind < argc ? (const char* const*) argv + optind : DEFAULT_RUNS;
+	runs = malloc(sizeof(struct BenchmarkRun) * numOfRuns);
+	if (!runs)
+	{
+		fprintf(stderr, "Error allocating the runs\n");
+		return ENOMEM;
+	}
+	for (i = 0; i < numOfRuns; i++)
+	{
+		// the generator checks the sizes
+		if (parseRun(runArgs[i], &runs[i]) < 0 ||
+		    initSyntheticPdb(&pdb, runs[i].shape, runs[i].numOfAtoms, runs[i].numOfModels, BENCHMARK_SEED) < 0 ||
+		    runs[i].numOfAtoms * runs[i].numOfModels > INT_MAX)
+		{
+			free(runs);
+			printUsage(argv[0]);
+		}
+	}
+
+	if (options.numOfThreads > 1)
+	{
+		options.pool = threadPoolAlloc(options.numOfThreads);
+		if (!options.pool)
+		{
+			fprintf(stderr, "Error allocating the threads\n");
+			ret = ENOMEM;
+		}
+	}
+	if (ret == 0 && outputPath)
+	{
+		output = fopen(outputPath, "w");
+		if (!output)
+		{
+			ret = errno;
+			fprintf(stderr, "Error opening file: %s\n", outputPath);
+		}
+	}
+
+	if (ret == 0)
+	{
+		fprintf(output, "{\n  \"kernels\": \"%s\", \"threads\": %d,\n  \"runs\": [\n",
+		        options.kernels->name, options.numOfThreads);
+		for (i = 0; i < numOfRuns && ret == 0; i++)
+		{
+			ret = runBenchmark(&options, &runs[i], output, i == numOfRuns - 1);
+			fflush(output);
+		}
+		fprintf(output, "  ]\n}\n");
+	}
+	if (output && output != stdout && fclose(output) != 0 && ret == 0)
+	{
+		fprintf(stderr, "Error writing file: %s\n", outputPath);
+		ret = EIO;
+	}
+	freeThreadPool(&options.pool);
+	free(runs);
+	return ret;
+}
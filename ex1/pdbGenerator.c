@@ -0,0 +1,102 @@
+/**
+ * @file pdbGenerator.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Writes a synthetic pdb file to the standard output.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <libgen.h>
+#include "syntheticPdb.h"
+
+
+/* --- Constants --- */
+
+/** The size of the output buffer. */
+#define WRITE_BUFFER_SIZE (1 << 16)
+
+
+/* --- Functions --- */
+
+/**
+ * Prints the usage message and exits.
+ *
+ * @param programPath the path of the program, argv[0].
+ */
+static void printUsage(char* programPath)
+{
+	fprintf(stderr, "Usage: %s %s|%s <atoms> [models] [seed]\n", basename(programPath), SHAPE_BLOB, SHAPE_FIBRIL);
+	exit(1);
+}
+
+/**
+ * Parses a positive number argument.
+ *
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The number. Exits on invalid arguments.
+ */
+static long parseCount(char* arg, char* programPath)
+{
+	char* endPtr;
+	long count;
+
+	count = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || count < 1)
+	{
+		printUsage(programPath);
+	}
+	return count;
+}
+
+
+/* --- Main --- */
+
+/**
+ * The main function.
+ *
+ * @param argc the number of arguments.
+ * @param argv An array of strings, the arguments of the program.
+ * @return 0 in a succesful execution, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static char buffer[WRITE_BUFFER_SIZE];
+	struct SyntheticPdb pdb;
+	long numOfAtoms;
+	long numOfModels = 1;
+	unsigned long long seed = 0;
+	size_t size;
+
+	if (argc < 3 || argc > 5)
+	{
+		printUsage(argv[0]);
+	}
+	numOfAtoms = parseCount(argv[2], argv[0]);
+	if (argc > 3)
+	{
+		numOfModels = parseCount(argv[3], argv[0]);
+	}
+	if (argc > 4)
+	{
+		seed = strtoull(argv[4], NULL, 10);
+	}
+	if (numOfModels > 1 << 30 || initSyntheticPdb(&pdb, argv[1], numOfAtoms, (int) numOfModels, seed) < 0)
+	{
+		printUsage(argv[0]);
+	}
+
+	while ((size = writeSyntheticLines(&pdb, buffer, sizeof(buffer))) > 0)
+	{
+		if (fwrite(buffer, 1, size, stdout) != size)
+		{
+			fprintf(stderr, "Error writing the output\n");
+			return 1;
+		}
+	}
+	return 0;
+}
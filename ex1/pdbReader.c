@@ -0,0 +1,492 @@
+/**
+ * @file pdbReader.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the pdb reader.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pdbReader.h"
+
+
+/* --- Constants --- */
+
+/** The usual length of a pdb line, used to guess how many atoms a file has. */
+#define TYPICAL_LINE_SIZE 81
+
+/** The most digits a decimal value with a point can have in VALUE_LENGTH characters. */
+#define MAX_FRACTION_DIGITS (VALUE_LENGTH - 1)
+
+/** Where the point of a value in the usual %8.3f layout is. */
+#define FIXED_POINT_POSITION (VALUE_LENGTH - 4)
+
+/** Masks of the bytes of a word, see parseFixedValue. */
+#define BYTES_OF_ONE 0x0101010101010101ULL
+#define LOW_BITS 0x7f7f7f7f7f7f7f7fULL
+#define HIGH_BITS 0x8080808080808080ULL
+// the bytes before the point, and the bytes after it
+#define INTEGER_BYTES 0x00000000ffffffffULL
+#define FRACTION_BYTES 0xffffff0000000000ULL
+
+
+/* --- Structs --- */
+
+/** The context of a sink that adds the atoms to a store. */
+struct StoreSink
+{
+	struct CoordStore* store;
+	FILE* errors;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Checks if a character is white space, like isspace in the "C" locale.
+ *
+ * @param c the character.
+ * @return 1 for true, 0 for false.
+ */
+static int isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/**
+ * Parses a value with strtof, for values that aren't plain decimals.
+ *
+ * @param line the line to parse from.
+ * @param valueStart the position of the value.
+ * @param errors the stream to report problems to.
+ * @return The parsed value. In case of error, returns 0 and sets errno.
+ */
+static float parseValueSlow(const char* line, int valueStart, FILE* errors)
+{
+	char* endPtr;
+	char tempString[VALUE_LENGTH + 1];
+	float value;
+	// the line is at least MINIMUM_LINE_LENGTH long, so the value is all there
+	memcpy(tempString, line + valueStart, VALUE_LENGTH);
+	tempString[VALUE_LENGTH] = '\0';
+	value = strtof(tempString, &endPtr);
+	if (endPtr == tempString)
+	{
+		errno = EINVAL; 
+		if (errors)
+		{
+			fprintf(errors, "Error in coordinate conversion %s!\n", tempString);
+		}
+	}
+	return value;
+}
+
+/**
+ * Finds the bytes of a word that are equal to a character.
+ *
+ * @param word the word, 8 characters.
+ * @param c the character.
+ * @return The high bit of every byte that is equal to the character.
+ */
+static uint64_t findBytes(uint64_t word, char c)
+{
+	uint64_t difference = word ^ (BYTES_OF_ONE * (unsigned char) c);
+	// no byte carries into the next one, so a byte is non zero exactly when its high bit ends up set
+	return ~(((difference & LOW_BITS) + LOW_BITS) | difference) & HIGH_BITS;
+}
+
+/**
+ * Gathers the high bits of the first four bytes of a mask into a number.
+ *
+ * @param mask the mask, with only the high bits of its bytes set.
+ * @return Bit i is the high bit of byte i.
+ */
+static unsigned gatherIntegerBytes(uint64_t mask)
+{
+	// bit 8i lands on bit 24 + i, and no other product lands on bits 24 to 27
+	return (unsigned) ((((mask & INTEGER_BYTES) >> 7) * 0x01020408) >> 24) & 0xf;
+}
+
+/**
+ * Parses a value in the %8.3f layout of the pdb format: spaces, an optional
+ * sign, the integer digits, a point and three fraction digits.
+ * The whole field is one word, so the layout is checked and the digits are
+ * summed with no branches on the number of digits or on the sign, which
+ * are different from atom to atom. Only on little endian machines.
+ *
+ * @param field the VALUE_LENGTH characters of the value.
+ * @param value the output value.
+ * @return 1 if the value has that layout, 0 otherwise (other blanks are left to parseValue too).
+ */
+static int parseFixedValue(const char* field, float* value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t word;
+	uint64_t digits;
+	uint64_t notDigits;
+	unsigned spaces;
+	unsigned signs;
+	unsigned integerDigits;
+	int isNegative;
+
+	memcpy(&word, field, sizeof(word));
+	// the value of the digit bytes, with no borrows between the bytes
+	digits = word ^ (BYTES_OF_ONE * '0');
+	// a byte is a digit when it's below 10 after that, the high bit keeps bytes above 127 out
+	notDigits = (((digits & LOW_BITS) + BYTES_OF_ONE * (0x80 - 10)) | digits) & HIGH_BITS;
+	spaces = gatherIntegerBytes(findBytes(word, ' '));
+	signs = gatherIntegerBytes(findBytes(word, '-') | findBytes(word, '+'));
+	integerDigits = gatherIntegerBytes(~notDigits & HIGH_BITS);
+	isNegative = findBytes(word, '-') != 0;
+
+	// spaces, then at most one sign, then digits, then the point and three digits
+	if ((spaces | signs | integerDigits) != 0xf || (spaces & (spaces + 1)) != 0 ||
+	    ((~integerDigits & 0xf) & ((~integerDigits & 0xf) + 1)) != 0 || (signs & (signs - 1)) != 0 ||
+	    (notDigits & FRACTION_BYTES) != 0 || field[FIXED_POINT_POSITION] != '.')
+	{
+		return 0;
+	}
+
+	// the integer digits move up one byte over the point, so the bytes are 7 digits from byte 1
+	digits &= (((~notDigits & HIGH_BITS) >> 7) * 0xff);
+	digits = ((digits & INTEGER_BYTES) << 8) | (digits & FRACTION_BYTES);
+	// the 8 digits of the word into a number, pairs, then fours, then all of them, the first byte is the highest digit
+	digits = (digits * (10 * 256 + 1)) >> 8;
+	digits = ((digits & 0x00ff00ff00ff00ffULL) * (100 * 65536 + 1)) >> 16;
+	digits = ((digits & 0x0000ffff0000ffffULL) * (10000 * 4294967296ULL + 1)) >> 32;
+	// at most 7 digits, so both numbers are exact floats and the division is rounded exactly like strtof rounds.
+	// multiplied by the sign and not negated, so -0.000 is -0 like strtof makes it
+	*value = (float) digits / 1e3f * (float) (1 - 2 * isNegative);
+	return 1;
+#else
+	(void) field;
+	(void) value;
+	return 0;
+#endif
+}
+
+float parseValue(const char* line, int valueStart, FILE* errors)
+{
+	static const float POWERS_OF_TEN[MAX_FRACTION_DIGITS + 1] = {
+		1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f
+	};
+	const char* c = line + valueStart;
+	const char* end = c + VALUE_LENGTH;
+	long mantissa = 0;
+	int numOfDigits = 0;
+	int numOfFractionDigits = 0;
+	int hasPoint = 0;
+	int isNegative = 0;
+	float value;
+
+	if (parseFixedValue(c, &value))
+	{
+		return value;
+	}
+	while (c < end && isBlank(*c))
+	{
+		c++;
+	}
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		isNegative = *c == '-';
+		c++;
+	}
+	for (; c < end; c++)
+	{
+		if (*c >= '0' && *c <= '9')
+		{
+			mantissa = mantissa * 10 + (*c - '0');
+			numOfDigits++;
+			numOfFractionDigits += hasPoint;
+		}
+		else if (*c == '.' && !hasPoint)
+		{
+			hasPoint = 1;
+		}
+		else
+		{
+			break;
+		}
+	}
+	// like strtof, anything after the number is ignored, unless it may continue the number
+	if (numOfDigits == 0 || (c < end && (*c == 'e' || *c == 'E' || *c == 'x' || *c == 'X')))
+	{
+		return parseValueSlow(line, valueStart, errors);
+	}
+
+	// with a point there are at most 7 digits, so both numbers are exact floats
+	// and the division is rounded exactly like strtof rounds
+	value = (float) mantissa;
+	if (numOfFractionDigits > 0)
+	{
+		value /= POWERS_OF_TEN[numOfFractionDigits];
+	}
+	return isNegative ? -value : value;
+}
+
+/**
+ * Parses the coordinates of an ATOM line and passes them to the sink.
+ *
+ * @param line the line.
+ * @param length the length of the line.
+ * @param sink the sink of the atoms.
+ * @param errors the stream to report problems to.
+ * @return 0 on success, an error code otherwise.
+ */
+static int parseAtomLine(const char* line, size_t length, const struct AtomSink* sink, FILE* errors)
+{
+	float xValue, yValue, zValue;
+
+	if(length < MINIMUM_LINE_LENGTH)
+	{
+		if (errors)
+		{
+			fprintf(errors, "ATOM line is too short %ld characters\n", (long) length);
+		}
+		return ERRSHORT;
+	}
+	xValue = parseValue(line, X_VALUE_START, errors);
+	if (xValue == 0 && errno != 0)
+	{
+		return -errno;
+	}
+	yValue = parseValue(line, Y_VALUE_START, errors);
+	if (yValue == 0 && errno != 0)
+	{
+		return -errno;
+	}
+	zValue = parseValue(line, Z_VALUE_START, errors);
+	if (zValue == 0 && errno != 0)
+	{
+		return -errno;
+	}
+	return sink->addAtom(sink->context, line, xValue, yValue, zValue);
+}
+
+/**
+ * Parses a line of any kind, passing what matters to a sink.
+ *
+ * @param line the line.
+ * @param length the length of the line.
+ * @param sink the sink of the atoms.
+ * @param errors the stream to report problems to.
+ * @return 1 if an atom was read, 0 if not, a negative error code otherwise.
+ */
+static int parseLine(const char* line, size_t length, const struct AtomSink* sink, FILE* errors)
+{
+	int ret;
+
+	if (length < sizeof(ROW_START) - 1)
+	{
+		return 0;
+	}
+	if (memcmp(line, ROW_START, sizeof(ROW_START) - 1) == 0 ||
+	    (sink->includeHetatm && memcmp(line, HETATM_ROW_START, sizeof(HETATM_ROW_START) - 1) == 0))
+	{
+		ret = parseAtomLine(line, length, sink, errors);
+		return ret < 0 ? ret : 1;
+	}
+	if (sink->endModel && memcmp(line, MODEL_END, sizeof(MODEL_END) - 1) == 0)
+	{
+		return sink->endModel(sink->context);
+	}
+	// Row doesn't start with the right word
+	return 0;
+}
+
+/**
+ * Passes the atoms of a file to a sink, line by line.
+ *
+ * @param file the file to read from.
+ * @param sink the sink of the atoms.
+ * @param errors the stream to report problems to.
+ * @return non negative integer - how many atoms were read.
+ *         negative integer - an error code.
+ */
+static long scanLines(FILE* file, const struct AtomSink* sink, FILE* errors)
+{
+	char line[MAX_LINE_SIZE];
+	long numOfAtoms = 0;
+	int ret;
+
+	// errno is checked after every value, it must not be left over from before
+	errno = 0;
+	while(fgets(line, MAX_LINE_SIZE, file) != NULL)
+	{
+		ret = parseLine(line, strlen(line), sink, errors);
+		if (ret < 0)
+		{
+			return ret;
+		}
+		numOfAtoms += ret;
+	}
+
+	return numOfAtoms;
+	
+}
+
+/**
+ * Passes the atoms in a memory buffer to a sink, without copying the lines.
+ *
+ * @param data the contents of a pdb file.
+ * @param size the size of the contents.
+ * @param sink the sink of the atoms.
+ * @param errors the stream to report problems to.
+ * @return non negative integer - how many atoms were read.
+ *         negative integer - an error code.
+ */
+static long scanBuffer(const char* data, size_t size, const struct AtomSink* sink, FILE* errors)
+{
+	const char* line = data;
+	const char* dataEnd = data + size;
+	const char* newline;
+	size_t length;
+	long numOfAtoms = 0;
+	int ret;
+
+	errno = 0;
+	while (line < dataEnd)
+	{
+		// lines are cut like fgets cuts them
+		length = (size_t) (dataEnd - line);
+		if (length > MAX_LINE_SIZE - 1)
+		{
+			length = MAX_LINE_SIZE - 1;
+		}
+		newline = memchr(line, '\n', length);
+		if (newline)
+		{
+			length = (size_t) (newline - line) + 1;
+		}
+
+		ret = parseLine(line, length, sink, errors);
+		if (ret < 0)
+		{
+			return ret;
+		}
+		numOfAtoms += ret;
+		line += length;
+	}
+
+	return numOfAtoms;
+}
+
+/**
+ * Maps a regular file to memory.
+ *
+ * @param file the file to map.
+ * @param size the output size of the file.
+ * @return The mapped contents, or NULL if the file can't be mapped. Unmap with munmap.
+ */
+static const char* mapFile(FILE* file, size_t* size)
+{
+	struct stat fileStat;
+	void* data;
+
+	if (fstat(fileno(file), &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0 ||
+	    (uintmax_t) fileStat.st_size > SIZE_MAX)
+	{
+		return NULL;
+	}
+	*size = (size_t) fileStat.st_size;
+	data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+	if (data == MAP_FAILED)
+	{
+		return NULL;
+	}
+	posix_madvise(data, *size, POSIX_MADV_SEQUENTIAL);
+	return data;
+}
+
+/**
+ * Adds an atom to a store, the addAtom of a store sink.
+ *
+ * @param context the StoreSink.
+ * @param line the ATOM line.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return 0 on success, an error code otherwise.
+ */
+static int appendToStore(void* context, const char* line, float x, float y, float z)
+{
+	struct StoreSink* storeSink = context;
+	int ret = appendCoord(storeSink->store, x, y, z);
+	(void) line;
+	if (ret < 0 && storeSink->errors)
+	{
+		fprintf(storeSink->errors, "Not enough memory for %d atoms\n", storeSink->store->size + 1);
+	}
+	return ret;
+}
+
+int readValues(FILE* file, struct CoordStore* store, FILE* errors)
+{
+	struct StoreSink storeSink = {store, errors};
+	struct AtomSink sink = {appendToStore, NULL, &storeSink, 0};
+	long ret;
+
+	clearCoordStore(store);
+	ret = scanLines(file, &sink, errors);
+	return ret < 0 ? (int) ret : store->size;
+}
+
+int readBufferValues(const char* data, size_t size, struct CoordStore* store, FILE* errors)
+{
+	struct StoreSink storeSink = {store, errors};
+	struct AtomSink sink = {appendToStore, NULL, &storeSink, 0};
+	long ret;
+
+	clearCoordStore(store);
+	if (size / TYPICAL_LINE_SIZE <= INT_MAX)
+	{
+		// a guess, saves growing the store many times
+		reserveCoords(store, (int) (size / TYPICAL_LINE_SIZE));
+	}
+	ret = scanBuffer(data, size, &sink, errors);
+	return ret < 0 ? (int) ret : store->size;
+}
+
+long streamValues(FILE* file, const struct AtomSink* sink, FILE* errors)
+{
+	const char* data;
+	size_t size;
+	long ret;
+
+	data = mapFile(file, &size);
+	if (!data)
+	{
+		return scanLines(file, sink, errors);
+	}
+	ret = scanBuffer(data, size, sink, errors);
+	munmap((void*) data, size);
+	return ret;
+}
+
+int readMappedValues(FILE* file, struct CoordStore* store, FILE* errors)
+{
+	const char* data;
+	size_t size;
+	int ret;
+
+	data = mapFile(file, &size);
+	if (!data)
+	{
+		return readValues(file, store, errors);
+	}
+	ret = readBufferValues(data, size, store, errors);
+	munmap((void*) data, size);
+	return ret;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file pdbReader.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for reading atom coordinates from pdb files.
+ */
+
+#ifndef PDB_READER_H
+#define PDB_READER_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stddef.h>
+#include "coordStore.h"
+
+
+/* --- Constants --- */
+
+/** Maximum number of characters in a line. */
+#define MAX_LINE_SIZE 200
+
+/** How every row that matters for calculations should start. */
+#define ROW_START "ATOM  "
+
+/** How the rows of atoms outside the standard residues start. */
+#define HETATM_ROW_START "HETATM"
+
+/** How the row that ends a model starts. */
+#define MODEL_END "ENDMDL"
+
+/** Where the x value starts in the line. */
+#define X_VALUE_START 30
+
+/** Where the y value starts in the line. */
+#define Y_VALUE_START 38
+
+/** Where the z value starts in the line. */
+#define Z_VALUE_START 46
+
+/** Where the values end. */
+#define VALUES_END 53
+
+/** Where the atom name starts in the line. */
+#define ATOM_NAME_START 12
+
+/** The number of characters in an atom name. */
+#define ATOM_NAME_LENGTH 4
+
+/** Where the residue name starts in the line. */
+#define RESIDUE_NAME_START 17
+
+/** The number of characters in a residue name. */
+#define RESIDUE_NAME_LENGTH 3
+
+/** Where the chain identifier is in the line. */
+#define CHAIN_POSITION 21
+
+/** Where the residue number starts in the line. */
+#define RESIDUE_NUMBER_START 22
+
+/** The number of characters in a residue number. */
+#define RESIDUE_NUMBER_LENGTH 4
+
+/** Where the insertion code is in the line. */
+#define INSERTION_POSITION 26
+
+/** Minimum line length. */
+#define MINIMUM_LINE_LENGTH 61
+
+/** The number of characters in each value. */
+#define VALUE_LENGTH 8
+
+/** An error number if the line is too short. */
+#define ERRSHORT -1;
+
+
+/* --- Structs --- */
+
+/** Receives the atoms of a file as they are read. */
+struct AtomSink
+{
+	/**
+	 * Called for every atom that is read.
+	 *
+	 * @param context the sink's context.
+	 * @param line the ATOM (or HETATM) line, at least MINIMUM_LINE_LENGTH long.
+	 * @param x the x coordinate.
+	 * @param y the y coordinate.
+	 * @param z the z coordinate.
+	 * @return 0 to go on reading, an error code to stop.
+	 */
+	int (*addAtom)(void* context, const char* line, float x, float y, float z);
+
+	/**
+	 * Called at the end of every model, NULL to read all the models as one.
+	 *
+	 * @param context the sink's context.
+	 * @return 0 to go on reading, an error code to stop.
+	 */
+	int (*endModel)(void* context);
+	void* context;
+	// 1 to pass HETATM lines to addAtom as well, 0 for ATOM lines only
+	int includeHetatm;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Parses a value of VALUE_LENGTH from given line.
+ * Plain decimal values are parsed in place, anything else goes through strtof.
+ * 
+ * @param line the line to parse from.
+ * @param valueStart the position of the value.
+ * @param errors the stream to report problems to.
+ * @return The parsed value. In case of error, returns 0 and sets errno.
+ */
+float parseValue(const char* line, int valueStart, FILE* errors);
+
+/**
+ * Reads the values from the given file into the given store, line by line.
+ * The store is cleared first, and grows as needed.
+ * 
+ * @param file the file to read from.
+ * @param store the output store.
+ * @param errors the stream to report problems to.
+ * @return positive integer - how many lines were read.
+ *         negative integer - an error code.
+ */
+int readValues(FILE* file, struct CoordStore* store, FILE* errors);
+
+/**
+ * Reads the values from a memory buffer into the given store, without copying the lines.
+ * Lines are split exactly like readValues splits them, so both give the same results.
+ * The store is cleared first, and grows as needed.
+ *
+ * @param data the contents of a pdb file.
+ * @param size the size of the contents.
+ * @param store the output store.
+ * @param errors the stream to report problems to, NULL to stay silent.
+ * @return positive integer - how many lines were read.
+ *         negative integer - an error code.
+ */
+int readBufferValues(const char* data, size_t size, struct CoordStore* store, FILE* errors);
+
+/**
+ * Reads the values from the given file into the given store.
+ * Regular files are mapped to memory and read with readBufferValues,
+ * other files (pipes, terminals) are read with readValues.
+ *
+ * @param file the file to read from.
+ * @param store the output store.
+ * @param errors the stream to report problems to.
+ * @return positive integer - how many lines were read.
+ *         negative integer - an error code.
+ */
+int readMappedValues(FILE* file, struct CoordStore* store, FILE* errors);
+
+/**
+ * Passes the atoms of the given file to a sink, without keeping them.
+ * Regular files are mapped to memory, other files are read line by line.
+ *
+ * @param file the file to read from.
+ * @param sink the sink of the atoms.
+ * @param errors the stream to report problems to.
+ * @return non negative integer - how many atoms were read.
+ *         negative integer - an error code.
+ */
+long streamValues(FILE* file, const struct AtomSink* sink, FILE* errors);
+
+#endif
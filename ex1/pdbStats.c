@@ -0,0 +1,192 @@
+/**
+ * @file pdbStats.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of libpdbstats.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <errno.h>
+#include "pdbStats.h"
+#include "storeAnalysis.h"
+#include "allocator.h"
+#include "pdbReader.h"
+
+
+/* --- Structs --- */
+
+/** A handle, see pdbStats.h. */
+struct PdbStats
+{
+	struct Allocator allocator;
+	// points to allocator, or NULL for malloc
+	const struct Allocator* allocatorPointer;
+	struct AnalysisOptions options;
+	struct CoordStore* store;
+	struct CoordStore* hullStore;
+};
+
+
+/* --- Handle functions --- */
+
+/**
+ * Converts an error code of the reader to a PDB_STATS code.
+ *
+ * @param ret the error code, negative.
+ * @return The PDB_STATS code.
+ */
+static int toPdbStatsError(int ret)
+{
+	if (ret == -ENOMEM)
+	{
+		return PDB_STATS_NO_MEMORY;
+	}
+	if (ret == -EINVAL || ret == -ERANGE)
+	{
+		return PDB_STATS_BAD_COORDINATE;
+	}
+	return PDB_STATS_SHORT_LINE;
+}
+
+struct PdbStats* pdbStatsAlloc(const struct Allocator* allocator)
+{
+	struct PdbStats* handle = allocateMemory(allocator, sizeof(struct PdbStats));
+	if (!handle)
+	{
+		return NULL;
+	}
+	memset(handle, 0, sizeof(struct PdbStats));
+	if (allocator)
+	{
+		handle->allocator = *allocator;
+		handle->allocatorPointer = &handle->allocator;
+	}
+	handle->options.kernels = selectKernels();
+	handle->options.pool = NULL;
+	handle->options.useHull = 1;
+	handle->options.dmaxEpsilon = 0;
+	handle->options.useCache = 0;
+	handle->options.useShape = 0;
+	handle->store = coordStoreAlloc(handle->allocatorPointer);
+	handle->hullStore = coordStoreAlloc(handle->allocatorPointer);
+	if (!handle->store || !handle->hullStore)
+	{
+		freePdbStats(&handle);
+	}
+	return handle;
+}
+
+void freePdbStats(struct PdbStats** handle)
+{
+	struct Allocator allocator;
+
+	if (*handle == NULL)
+	{
+		return;
+	}
+	freeCoordStore(&(*handle)->store);
+	freeCoordStore(&(*handle)->hullStore);
+	// the handle holds the allocator that frees it
+	allocator = (*handle)->allocator;
+	releaseMemory((*handle)->allocatorPointer ? &allocator : NULL, *handle);
+	*handle = NULL;
+}
+
+int setPdbStatsKernels(struct PdbStats* handle, const char* name)
+{
+	const struct CoordKernels* kernels = findKernels(name);
+	if (!kernels)
+	{
+		return PDB_STATS_BAD_ARGUMENT;
+	}
+	handle->options.kernels = kernels;
+	return PDB_STATS_OK;
+}
+
+int setPdbStatsDmaxEpsilon(struct PdbStats* handle, float epsilon)
+{
+	if (!(epsilon >= 0) || !(epsilon < 1))
+	{
+		return PDB_STATS_BAD_ARGUMENT;
+	}
+	handle->options.dmaxEpsilon = epsilon;
+	return PDB_STATS_OK;
+}
+
+void setPdbStatsShape(struct PdbStats* handle, int useShape)
+{
+	handle->options.useShape = useShape;
+}
+
+int parsePdbBuffer(struct PdbStats* handle, const char* data, size_t size)
+{
+	int ret = readBufferValues(data, size, handle->store, NULL);
+	if (ret < 0)
+	{
+		clearCoordStore(handle->store);
+		return toPdbStatsError(ret);
+	}
+	return ret > 0 ? ret : PDB_STATS_NO_ATOMS;
+}
+
+int calculatePdbStats(struct PdbStats* handle, int useHull, struct ProteinStats* stats)
+{
+	struct AnalysisOptions options = handle->options;
+
+	if (handle->store->size == 0)
+	{
+		return PDB_STATS_NO_ATOMS;
+	}
+	options.useHull = useHull;
+	analyzeStore(&options, handle->store, handle->hullStore, stats);
+	return PDB_STATS_OK;
+}
+
+const struct CoordStore* getPdbAtoms(const struct PdbStats* handle)
+{
+	return handle->store;
+}
+
+int getPdbNumOfAtoms(const struct PdbStats* handle)
+{
+	return handle->store->size;
+}
+
+const float* getPdbCoords(const struct PdbStats* handle, int axis)
+{
+	switch (axis)
+	{
+		case X_POS:
+			return handle->store->x;
+		case Y_POS:
+			return handle->store->y;
+		case Z_POS:
+			return handle->store->z;
+		default:
+			return NULL;
+	}
+}
+
+const char* pdbStatsError(int code)
+{
+	switch (code)
+	{
+		case PDB_STATS_OK:
+			return "Success";
+		case PDB_STATS_NO_MEMORY:
+			return "Not enough memory";
+		case PDB_STATS_BAD_COORDINATE:
+			return "Error in coordinate conversion";
+		case PDB_STATS_SHORT_LINE:
+			return "ATOM line is too short";
+		case PDB_STATS_NO_ATOMS:
+			return "0 atoms were found";
+		case PDB_STATS_BAD_ARGUMENT:
+			return "Invalid argument";
+		default:
+			return "Unknown error";
+	}
+}
@@ -0,0 +1,190 @@
+/**
+ * @file pdbStats.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for libpdbstats, the statistics of protein atoms in pdb files.
+ * A PdbStats handle parses pdb contents from memory and calculates their
+ * statistics, reusing its buffers from one parse to the next. Errors are
+ * returned as PDB_STATS error codes, nothing is printed and the process is
+ * never stopped. A handle may only be used by one thread at a time.
+ */
+
+#ifndef PDB_STATS_H
+#define PDB_STATS_H
+
+
+/* --- Includes --- */
+
+#include <stddef.h>
+
+
+/* --- Constants --- */
+
+/** How many coordinates are there (x, y, z). */
+#define COORD_NUM 3
+
+/** X coordinate position. */
+#define X_POS 0
+
+/** Y coordinate position. */
+#define Y_POS 1
+
+/** Z coordinate position. */
+#define Z_POS 2
+
+/** Success. */
+#define PDB_STATS_OK 0
+
+/** Error code - there's not enough memory. */
+#define PDB_STATS_NO_MEMORY (-1)
+
+/** Error code - a coordinate isn't a number. */
+#define PDB_STATS_BAD_COORDINATE (-2)
+
+/** Error code - an ATOM line is too short to hold the coordinates. */
+#define PDB_STATS_SHORT_LINE (-3)
+
+/** Error code - there are no atoms. */
+#define PDB_STATS_NO_ATOMS (-4)
+
+/** Error code - an argument is invalid. */
+#define PDB_STATS_BAD_ARGUMENT (-5)
+
+
+/* --- Structs --- */
+
+struct Allocator;
+struct PdbStats;
+
+/** The shape of a set of atoms, the tensors are row major and about the center of gravity. */
+struct ShapeStats
+{
+	// the axis aligned bounding box
+	float boxMinimum[COORD_NUM];
+	float boxMaximum[COORD_NUM];
+	// the covariance of the coordinates
+	float gyrationTensor[COORD_NUM * COORD_NUM];
+	// the inertia tensor, every atom weighs 1
+	float inertiaTensor[COORD_NUM * COORD_NUM];
+	// the eigenvalues of the gyration tensor from the largest, their sum is Rg squared
+	float principalMoments[COORD_NUM];
+	// row k is the unit eigenvector of principalMoments[k]
+	float principalAxes[COORD_NUM * COORD_NUM];
+	// the oriented bounding box, how far the atoms reach along each principal axis from the center of gravity
+	float orientedBoxMinimum[COORD_NUM];
+	float orientedBoxMaximum[COORD_NUM];
+	// the first principal moment minus the mean of the other two, 0 for a sphere
+	float asphericity;
+};
+
+/** The results of analyzing one file. */
+struct ProteinStats
+{
+	int numOfAtoms;
+	float centerOfGravity[COORD_NUM];
+	float turnRadius;
+	float maxDistance;
+	// the true Dmax is at most this, above maxDistance only when it is approximated
+	float maxDistanceBound;
+	// how many pairs of points were compared to find Dmax
+	long long numOfPairs;
+	// 1 if the shape was found, see setPdbStatsShape
+	int hasShape;
+	struct ShapeStats shape;
+};
+
+
+/* --- Handle functions --- */
+
+/**
+ * Allocates a new handle.
+ *
+ * @param allocator where all the memory of the handle comes from, NULL for malloc.
+ *        It is copied, but its context must outlive the handle.
+ * @return The new handle, or NULL if there's no memory. Free with freePdbStats.
+ */
+struct PdbStats* pdbStatsAlloc(const struct Allocator* allocator);
+
+/**
+ * Frees the given handle and sets it to NULL.
+ *
+ * @param handle a pointer to the handle to free.
+ */
+void freePdbStats(struct PdbStats** handle);
+
+/**
+ * Sets the kernels the handle calculates with, the best supported ones by default.
+ *
+ * @param handle the handle.
+ * @param name the kernels name, see coordKernels.h.
+ * @return PDB_STATS_OK, or PDB_STATS_BAD_ARGUMENT if the kernels are unknown or unsupported.
+ */
+int setPdbStatsKernels(struct PdbStats* handle, const char* name);
+
+/**
+ * Sets the relative error allowed in Dmax, 0 for the exact value by default.
+ * With an error, Dmax is approximated in about linear time and maxDistanceBound
+ * holds the bound of the true value.
+ *
+ * @param handle the handle.
+ * @param epsilon the relative error, at least 0 and less than 1.
+ * @return PDB_STATS_OK, or PDB_STATS_BAD_ARGUMENT if the error is out of range.
+ */
+int setPdbStatsDmaxEpsilon(struct PdbStats* handle, float epsilon);
+
+/**
+ * Sets whether the shape of the atoms is also calculated, in the same pass as Rg.
+ * It isn't by default.
+ *
+ * @param handle the handle.
+ * @param useShape 1 to calculate the shape, 0 not to.
+ */
+void setPdbStatsShape(struct PdbStats* handle, int useShape);
+
+/**
+ * Parses the atoms of pdb contents, replacing the atoms of the last parse.
+ *
+ * @param handle the handle.
+ * @param data the contents of a pdb file, don't have to end with a null.
+ * @param size the size of the contents.
+ * @return positive integer - how many atoms were read.
+ *         negative integer - a PDB_STATS error code, the handle has no atoms.
+ */
+int parsePdbBuffer(struct PdbStats* handle, const char* data, size_t size);
+
+/**
+ * Calculates the statistics of the atoms of the last parse.
+ *
+ * @param handle the handle.
+ * @param useHull 1 to find Dmax with the convex hull, 0 to compare every pair.
+ * @param stats the output statistics.
+ * @return PDB_STATS_OK, or a PDB_STATS error code.
+ */
+int calculatePdbStats(struct PdbStats* handle, int useHull, struct ProteinStats* stats);
+
+/**
+ * Gets how many atoms the last parse read.
+ *
+ * @param handle the handle.
+ * @return How many atoms there are, 0 if the last parse failed.
+ */
+int getPdbNumOfAtoms(const struct PdbStats* handle);
+
+/**
+ * Gets one coordinate of the atoms of the last parse.
+ *
+ * @param handle the handle.
+ * @param axis X_POS, Y_POS or Z_POS.
+ * @return getPdbNumOfAtoms coordinates, owned by the handle and valid until the next parse.
+ */
+const float* getPdbCoords(const struct PdbStats* handle, int axis);
+
+/**
+ * Describes an error code.
+ *
+ * @param code a PDB_STATS code.
+ * @return A constant description.
+ */
+const char* pdbStatsError(int code);
+
+#endif
@@ -0,0 +1,264 @@
+/**
+ * @file profiler.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the phase profiler.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "profiler.h"
+#include "coordStore.h"
+#include "pdbReader.h"
+
+
+/* --- Constants --- */
+
+/** The first number of profiles there's room for. */
+#define INITIAL_PROFILES 16
+
+/** The names of the phases in the JSON, in the order of the phases. */
+static const char* const PHASE_NAMES[NUM_OF_PHASES] = {"read", "parse", "centerOfGravity", "turnRadius",
+                                                       "maxDistance"};
+
+
+/* --- Functions --- */
+
+/**
+ * Gets the seconds of a clock.
+ *
+ * @param clock the clock.
+ * @return The seconds of the clock.
+ */
+static double getSeconds(clockid_t clock)
+{
+	struct timespec time;
+
+	clock_gettime(clock, &time);
+	return (double) time.tv_sec + time.tv_nsec / 1e9;
+}
+
+void startPhase(const struct FileProfile* profile, const struct ThreadPool* pool, struct PhaseClock* clock)
+{
+	if (!profile)
+	{
+		return;
+	}
+	clock->isProcessTime = pool != NULL;
+	clock->wallSeconds = getSeconds(CLOCK_MONOTONIC);
+	clock->cpuSeconds = getSeconds(pool ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID);
+}
+
+void stopPhase(struct FileProfile* profile, const struct PhaseClock* clock, int phase)
+{
+	double cpuSeconds;
+
+	if (!profile)
+	{
+		return;
+	}
+	cpuSeconds = getSeconds(clock->isProcessTime ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID);
+	profile->phases[phase].wallSeconds = getSeconds(CLOCK_MONOTONIC) - clock->wallSeconds;
+	profile->phases[phase].cpuSeconds = cpuSeconds - clock->cpuSeconds;
+}
+
+struct FileProfile* addProfile(struct Profiler* profiler, const char* path)
+{
+	struct FileProfile* files;
+	int capacity;
+
+	if (profiler->numOfFiles == profiler->capacity)
+	{
+		capacity = profiler->capacity ? 2 * profiler->capacity : INITIAL_PROFILES;
+		files = realloc(profiler->files, sizeof(struct FileProfile) * capacity);
+		if (!files)
+		{
+			return NULL;
+		}
+		profiler->files = files;
+		profiler->capacity = capacity;
+	}
+	files = &profiler->files[profiler->numOfFiles++];
+	memset(files, 0, sizeof(struct FileProfile));
+	files->path = path;
+	return files;
+}
+
+/**
+ * Counts the lines in a memory buffer, cut like the reader cuts them.
+ *
+ * @param data the contents of a pdb file.
+ * @param size the size of the contents.
+ * @return How many lines there are.
+ */
+static long long countLines(const char* data, size_t size)
+{
+	const char* line = data;
+	const char* dataEnd = data + size;
+	const char* newline;
+	size_t length;
+	long long numOfLines = 0;
+
+	while (line < dataEnd)
+	{
+		length = (size_t) (dataEnd - line);
+		if (length > MAX_LINE_SIZE - 1)
+		{
+			length = MAX_LINE_SIZE - 1;
+		}
+		newline = memchr(line, '\n', length);
+		line += newline ? (size_t) (newline - line) + 1 : length;
+		numOfLines++;
+	}
+	return numOfLines;
+}
+
+void countProfiledFile(struct FileProfile* profile, FILE* file, int numOfAtoms)
+{
+	struct stat status;
+	void* data;
+	size_t size;
+
+	if (!profile)
+	{
+		return;
+	}
+	profile->atomLines = numOfAtoms > 0 ? numOfAtoms : 0;
+	if (fstat(fileno(file), &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0)
+	{
+		return;
+	}
+	size = (size_t) status.st_size;
+	profile->bytesRead = (long long) size;
+	data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+	if (data == MAP_FAILED)
+	{
+		return;
+	}
+	profile->linesScanned = countLines(data, size);
+	munmap(data, size);
+}
+
+void profileStore(const struct AnalysisOptions* options, const struct CoordStore* store,
+                  struct CoordStore* hullStore, struct ProteinStats* stats, struct FileProfile* profile)
+{
+	struct PhaseClock clock;
+
+	// the profile is never NULL here, so every phase sets the clock
+	memset(&clock, 0, sizeof(clock));
+	stats->numOfAtoms = store->size;
+	startPhase(profile, options->pool, &clock);
+	calculateCenterOfGravity(options->kernels, store, stats->centerOfGravity);
+	stopPhase(profile, &clock, PHASE_CENTER_OF_GRAVITY);
+
+	startPhase(profile, options->pool, &clock);
+	calculateStoreTurnRadius(options, store, stats);
+	stopPhase(profile, &clock, PHASE_TURN_RADIUS);
+
+	startPhase(profile, options->pool, &clock);
+	calculateStoreMaxDistance(options, store, hullStore, stats);
+	stopPhase(profile, &clock, PHASE_MAX_DISTANCE);
+	profile->numOfPairs = stats->numOfPairs;
+}
+
+void initProfiler(struct Profiler* profiler)
+{
+	memset(profiler, 0, sizeof(struct Profiler));
+}
+
+void cleanupProfiler(struct Profiler* profiler)
+{
+	free(profiler->files);
+	initProfiler(profiler);
+}
+
+/**
+ * Prints a string as a JSON string.
+ *
+ * @param output the stream to print to.
+ * @param string the string.
+ */
+static void printJsonString(FILE* output, const char* string)
+{
+	fputc('"', output);
+	for (; *string != '\0'; string++)
+	{
+		if (*string == '"' || *string == '\\')
+		{
+			fprintf(output, "\\%c", *string);
+		}
+		else if ((unsigned char) *string < ' ')
+		{
+			fprintf(output, "\\u%04x", (unsigned char) *string);
+		}
+		else
+		{
+			fputc(*string, output);
+		}
+	}
+	fputc('"', output);
+}
+
+/**
+ * Prints the counters and the phases of a profile as JSON members.
+ *
+ * @param output the stream to print to.
+ * @param profile the profile.
+ * @param indent how many spaces the members are indented by.
+ */
+static void printProfileMembers(FILE* output, const struct FileProfile* profile, int indent)
+{
+	int phase;
+
+	fprintf(output, "\"bytesRead\": %lld, \"linesScanned\": %lld, \"atomLines\": %lld, \"pairComparisons\": %lld,\n",
+	        profile->bytesRead, profile->linesScanned, profile->atomLines, profile->numOfPairs);
+	fprintf(output, "%*s\"phases\": {", indent, "");
+	for (phase = 0; phase < NUM_OF_PHASES; phase++)
+	{
+		fprintf(output, "%s\n%*s\"%s\": {\"wallSeconds\": %.6f, \"cpuSeconds\": %.6f}", phase ? "," : "",
+		        indent + 2, "", PHASE_NAMES[phase], profile->phases[phase].wallSeconds,
+		        profile->phases[phase].cpuSeconds);
+	}
+	fprintf(output, "\n%*s}", indent, "");
+}
+
+void printProfile(const struct Profiler* profiler, FILE* output)
+{
+	const struct FileProfile* profile;
+	struct FileProfile total;
+	int phase;
+	int i;
+
+	memset(&total, 0, sizeof(total));
+	fprintf(output, "{\n  \"files\": [");
+	for (i = 0; i < profiler->numOfFiles; i++)
+	{
+		profile = &profiler->files[i];
+		fprintf(output, "%s\n    {\n      \"path\": ", i ? "," : "");
+		printJsonString(output, profile->path);
+		fprintf(output, ", ");
+		printProfileMembers(output, profile, 6);
+		fprintf(output, "\n    }");
+
+		for (phase = 0; phase < NUM_OF_PHASES; phase++)
+		{
+			total.phases[phase].wallSeconds += profile->phases[phase].wallSeconds;
+			total.phases[phase].cpuSeconds += profile->phases[phase].cpuSeconds;
+		}
+		total.bytesRead += profile->bytesRead;
+		total.linesScanned += profile->linesScanned;
+		total.atomLines += profile->atomLines;
+		total.numOfPairs += profile->numOfPairs;
+	}
+	fprintf(output, "\n  ],\n  \"total\": {\n    \"files\": %d, ", profiler->numOfFiles);
+	printProfileMembers(output, &total, 4);
+	fprintf(output, "\n  }\n}\n");
+}
@@ -0,0 +1,155 @@
+/**
+ * @file profiler.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for profiling the analysis of files phase by phase.
+ * The phases are timed by hooks on the usual path of loading and analyzing a
+ * file, one file after another or in a batch, and the hooks do nothing for a
+ * file without a profile. A file is mapped to memory, so its pages are read
+ * while it is parsed: the read phase is opening the file (and reading its
+ * cache), and the rest of the I/O is in the parse phase. A file read from its
+ * cache isn't parsed, so it has no bytes and no lines either. The profiles are
+ * kept until all the files are done, and then printed together as JSON.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include "AnalyzeProtein.h"
+
+
+/* --- Constants --- */
+
+/** The phases of analyzing a file, in order. */
+#define PHASE_READ 0
+#define PHASE_PARSE 1
+#define PHASE_CENTER_OF_GRAVITY 2
+#define PHASE_TURN_RADIUS 3
+#define PHASE_MAX_DISTANCE 4
+
+/** How many phases there are. */
+#define NUM_OF_PHASES 5
+
+
+/* --- Structs --- */
+
+/** The time one phase took. */
+struct PhaseTime
+{
+	double wallSeconds;
+	// the time of all the threads of the process, more than wallSeconds when the pool is busy
+	double cpuSeconds;
+};
+
+/** The profile of one file, or the sum of the profiles of all of them. */
+struct FileProfile
+{
+	const char* path;
+	struct PhaseTime phases[NUM_OF_PHASES];
+	long long bytesRead;
+	long long linesScanned;
+	long long atomLines;
+	long long numOfPairs;
+};
+
+/** The profiles of the analyzed files. */
+struct Profiler
+{
+	struct FileProfile* files;
+	int numOfFiles;
+	int capacity;
+};
+
+/** The start of a phase. */
+struct PhaseClock
+{
+	double wallSeconds;
+	double cpuSeconds;
+	// 1 if the CPU time is of all the threads of the process, 0 if it's of the calling thread
+	int isProcessTime;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Initializes a profiler without profiles.
+ *
+ * @param profiler the profiler to initialize. Free with cleanupProfiler.
+ */
+void initProfiler(struct Profiler* profiler);
+
+/**
+ * Frees the memory of a profiler.
+ *
+ * @param profiler the profiler.
+ */
+void cleanupProfiler(struct Profiler* profiler);
+
+/**
+ * Adds an empty profile for a file.
+ * The profiles are moved when there's no room for more, so a profile is only
+ * valid until the next one is added.
+ *
+ * @param profiler the profiler.
+ * @param path the path of the file, must outlive the profiler.
+ * @return The new profile, or NULL if there's no memory.
+ */
+struct FileProfile* addProfile(struct Profiler* profiler, const char* path);
+
+/**
+ * Starts timing a phase of a file, if the file is profiled.
+ *
+ * @param profile the profile of the file, NULL if it isn't profiled.
+ * @param pool the threads of the phase, NULL if it runs on the calling thread
+ *        alone. The CPU time is then the calling thread's, so the files of a
+ *        batch don't count the CPU time of each other.
+ * @param clock the output start of the phase.
+ */
+void startPhase(const struct FileProfile* profile, const struct ThreadPool* pool, struct PhaseClock* clock);
+
+/**
+ * Stops timing a phase of a file, if the file is profiled.
+ *
+ * @param profile the profile of the file, NULL if it isn't profiled.
+ * @param clock the start of the phase.
+ * @param phase the phase, receives its time.
+ */
+void stopPhase(struct FileProfile* profile, const struct PhaseClock* clock, int phase);
+
+/**
+ * Counts the bytes and the lines of a parsed file, if the file is profiled.
+ * The lines are counted apart from the parsing, so it isn't slowed down
+ * without a profile. They're only counted in regular files, which can be read again.
+ *
+ * @param profile the profile of the file, NULL if it isn't profiled.
+ * @param file the file.
+ * @param numOfAtoms how many atom lines the parsing accepted.
+ */
+void countProfiledFile(struct FileProfile* profile, FILE* file, int numOfAtoms);
+
+/**
+ * Analyzes a store like analyzeStore does, and times every phase in the profile of its file.
+ *
+ * @param options how to calculate.
+ * @param store the atoms.
+ * @param hullStore a scratch store for the hull points.
+ * @param stats the output statistics.
+ * @param profile the profile of the file.
+ */
+void profileStore(const struct AnalysisOptions* options, const struct CoordStore* store,
+                  struct CoordStore* hullStore, struct ProteinStats* stats, struct FileProfile* profile);
+
+/**
+ * Prints the profile of every file and their total as JSON.
+ *
+ * @param profiler the profiler.
+ * @param output the stream to print to.
+ */
+void printProfile(const struct Profiler* profiler, FILE* output);
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ * @file rmsdMatrix.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the RMSD matrix.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include "rmsdMatrix.h"
+#include "coordStore.h"
+#include "coordKernels.h"
+#include "threadPool.h"
+#include "superposition.h"
+
+
+/* --- Structs --- */
+
+/** A structure, moved so its center of gravity is at the origin. */
+struct Conformer
+{
+	struct CoordStore* store;
+	double sumOfSquares;
+};
+
+/** A matrix being calculated, shared by all the threads. */
+struct RmsdJob
+{
+	const struct CoordKernels* kernels;
+	// the rows are the reference alone, or the same as the columns
+	struct Conformer* rows;
+	struct Conformer* columns;
+	int numOfRows;
+	int numOfColumns;
+	float* matrix;
+};
+
+/** One row of a matrix, a pool task. */
+struct RmsdRow
+{
+	struct RmsdJob* job;
+	int row;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Loads a structure and moves it to the origin.
+ *
+ * @param options how to load.
+ * @param path the path of the file.
+ * @param conformer the output structure.
+ * @return 0 on success, the exit code otherwise.
+ */
+static int loadConformer(const struct AnalysisOptions* options, const char* path, struct Conformer* conformer)
+{
+	const float origin[COORD_NUM] = {0, 0, 0};
+	float centerOfGravity[COORD_NUM];
+	struct CoordStore* store;
+	int ret;
+	int i;
+
+	conformer->store = coordStoreAlloc(NULL);
+	if (!conformer->store)
+	{
+		fprintf(stderr, "Error allocating the atoms store\n");
+		return ENOMEM;
+	}
+	store = conformer->store;
+	ret = loadFile(options, path, store, stderr, NULL);
+	if (ret <= 0)
+	{
+		return ret < 0 ? -ret : 1;
+	}
+
+	calculateCenterOfGravity(options->kernels, store, centerOfGravity);
+	for (i = 0; i < store->size; i++)
+	{
+		store->x[i] -= centerOfGravity[X_POS];
+		store->y[i] -= centerOfGravity[Y_POS];
+		store->z[i] -= centerOfGravity[Z_POS];
+	}
+	conformer->sumOfSquares = options->kernels->sumSquaredDistances(store->x, store->y, store->z, store->size,
+	                                                                 origin);
+	return 0;
+}
+
+/**
+ * Calculates the RMSD of two structures with the same number of atoms.
+ *
+ * @param kernels the kernels to calculate with.
+ * @param first the first structure.
+ * @param second the second structure.
+ * @return The RMSD after the optimal superposition.
+ */
+static float calculateRmsd(const struct CoordKernels* kernels, const struct Conformer* first,
+                           const struct Conformer* second)
+{
+	double covariance[COORD_NUM * COORD_NUM];
+
+	kernels->crossCovariance(first->store->x, first->store->y, first->store->z,
+	                         second->store->x, second->store->y, second->store->z, first->store->size, covariance);
+	return (float) superpose(covariance, first->sumOfSquares + second->sumOfSquares, first->store->size, NULL);
+}
+
+/**
+ * Calculates one row of a matrix, a pool task.
+ * When comparing all with all, only the pairs after the diagonal are
+ * calculated, and copied to the other half.
+ *
+ * @param arg the RmsdRow.
+ */
+static void runRmsdRow(void* arg)
+{
+	struct RmsdRow* task = arg;
+	struct RmsdJob* job = task->job;
+	int isAllPairs = job->rows == job->columns;
+	float* row = job->matrix + (size_t) task->row * job->numOfColumns;
+	int column;
+
+	for (column = isAllPairs ? task->row + 1 : 0; column < job->numOfColumns; column++)
+	{
+		row[column] = calculateRmsd(job->kernels, &job->rows[task->row], &job->columns[column]);
+		if (isAllPairs)
+		{
+			job->matrix[(size_t) column * job->numOfColumns + task->row] = row[column];
+		}
+	}
+	if (isAllPairs)
+	{
+		row[task->row] = 0;
+	}
+}
+
+/**
+ * Prints a CSV field, quoted if it has special characters.
+ *
+ * @param field the field.
+ */
+static void printCsvField(const char* field)
+{
+	if (!strpbrk(field, ",\"\n"))
+	{
+		printf("%s", field);
+		return;
+	}
+	putchar('"');
+	for (; *field; field++)
+	{
+		if (*field == '"')
+		{
+			putchar('"');
+		}
+		putchar(*field);
+	}
+	putchar('"');
+}
+
+/**
+ * Writes a matrix in the binary format, see rmsdMatrix.h.
+ *
+ * @param path the path of the file.
+ * @param job the calculated matrix.
+ * @return 0 on success, the exit code otherwise.
+ */
+static int writeBinaryMatrix(const char* path, const struct RmsdJob* job)
+{
+	FILE* file;
+	int32_t dims[2] = {job->numOfRows, job->numOfColumns};
+	size_t size = (size_t) job->numOfRows * job->numOfColumns;
+	int ret = 0;
+
+	file = fopen(path, "wb");
+	if (!file)
+	{
+		ret = errno;
+		fprintf(stderr, "Error opening file: %s\n", path);
+		return ret;
+	}
+	if (fwrite(RMSD_MAGIC, sizeof(RMSD_MAGIC) - 1, 1, file) != 1 || fwrite(dims, sizeof(dims), 1, file) != 1 ||
+	    fwrite(job->matrix, sizeof(float), size, file) != size)
+	{
+		ret = EIO;
+	}
+	if (fclose(file) != 0)
+	{
+		ret = EIO;
+	}
+	if (ret != 0)
+	{
+		fprintf(stderr, "Error writing file: %s\n", path);
+	}
+	return ret;
+}
+
+int analyzeRmsd(const struct AnalysisOptions* options, char** paths, int numOfPaths, const char* referencePath,
+                const char* binaryPath)
+{
+	struct Conformer* conformers;
+	struct RmsdRow* tasks = NULL;
+	struct RmsdJob job;
+	int numOfConformers = numOfPaths + (referencePath != NULL);
+	int ret = 0;
+	int i, j;
+
+	conformers = calloc(numOfConformers, sizeof(struct Conformer));
+	if (!conformers)
+	{
+		fprintf(stderr, "Error allocating the atoms store\n");
+		return ENOMEM;
+	}
+	// the reference is loaded last, after the columns
+	for (i = 0; i < numOfConformers && ret == 0; i++)
+	{
+		ret = loadConformer(options, i < numOfPaths ? paths[i] : referencePath, &conformers[i]);
+		if (ret == 0 && conformers[i].store->size != conformers[0].store->size)
+		{
+			fprintf(stderr, "Error - %s has %d atoms, but %s has %d atoms\n",
+			        i < numOfPaths ? paths[i] : referencePath, conformers[i].store->size, paths[0],
+			        conformers[0].store->size);
+			ret = EINVAL;
+		}
+	}
+
+	job.kernels = options->kernels;
+	job.columns = conformers;
+	job.numOfColumns = numOfPaths;
+	job.rows = referencePath ? &conformers[numOfPaths] : conformers;
+	job.numOfRows = referencePath ? 1 : numOfPaths;
+	job.matrix = NULL;
+	if (ret == 0)
+	{
+		job.matrix = malloc(sizeof(float) * job.numOfRows * job.numOfColumns);
+		tasks = malloc(sizeof(struct RmsdRow) * job.numOfRows);
+		if (!job.matrix || !tasks)
+		{
+			fprintf(stderr, "Error allocating the RMSD matrix\n");
+			ret = ENOMEM;
+		}
+	}
+
+	if (ret == 0)
+	{
+		for (i = 0; i < job.numOfRows; i++)
+		{
+			tasks[i].job = &job;
+			tasks[i].row = i;
+			if (!options->pool || threadPoolSubmit(options->pool, runRmsdRow, &tasks[i]) != 0)
+			{
+				runRmsdRow(&tasks[i]);
+			}
+		}
+		if (options->pool)
+		{
+			threadPoolWait(options->pool);
+		}
+
+		printf("file");
+		for (j = 0; j < job.numOfColumns; j++)
+		{
+			printf(",");
+			printCsvField(paths[j]);
+		}
+		printf("\n");
+		for (i = 0; i < job.numOfRows; i++)
+		{
+			printCsvField(referencePath ? referencePath : paths[i]);
+			for (j = 0; j < job.numOfColumns; j++)
+			{
+				printf(",%.3f", job.matrix[(size_t) i * job.numOfColumns + j]);
+			}
+			printf("\n");
+		}
+		if (binaryPath)
+		{
+			ret = writeBinaryMatrix(binaryPath, &job);
+		}
+	}
+
+	for (i = 0; i < numOfConformers; i++)
+	{
+		freeCoordStore(&conformers[i].store);
+	}
+	free(conformers);
+	free(tasks);
+	free(job.matrix);
+	return ret;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file rmsdMatrix.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for comparing many structures of the same protein by the RMSD
+ * of their atoms after the optimal superposition.
+ */
+
+#ifndef RMSD_MATRIX_H
+#define RMSD_MATRIX_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+
+
+/* --- Constants --- */
+
+/** The first bytes of a binary RMSD matrix file. */
+#define RMSD_MAGIC "RMSD"
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the RMSD between pdb files with the same atoms, in the same order.
+ * Compares every file with every other file, or a reference file with every file.
+ * The matrix is printed as CSV, with the file paths heading the rows and
+ * the columns. It can also be written to a binary file: RMSD_MAGIC, the
+ * number of rows and of columns as 32 bit integers, and then the matrix
+ * row by row as float32, all in the byte order of the machine.
+ *
+ * @param options how to calculate, the pool runs the pairs in parallel.
+ * @param paths the paths of the files.
+ * @param numOfPaths how many files there are.
+ * @param referencePath the file to compare with all the files, NULL to compare all with all.
+ * @param binaryPath the path of the binary matrix to write, NULL for none.
+ * @return 0 on success, the exit code otherwise.
+ */
+int analyzeRmsd(const struct AnalysisOptions* options, char** paths, int numOfPaths, const char* referencePath,
+                const char* binaryPath);
+
+#endif
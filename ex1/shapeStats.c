@@ -0,0 +1,153 @@
+/**
+ * @file shapeStats.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the shape of a set of points.
+ */
+
+
+/* --- Includes --- */
+
+#include <math.h>
+#include "shapeStats.h"
+
+
+/* --- Constants --- */
+
+/** Maximum number of Jacobi sweeps, it converges in far fewer. */
+#define MAX_SWEEPS 50
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the eigenvalues and eigenvectors of a symmetric 3x3 matrix with Jacobi rotations.
+ *
+ * @param matrix the matrix, its diagonal receives the eigenvalues.
+ * @param vectors the output eigenvectors, column k belongs to eigenvalue k.
+ */
+static void jacobiEigen(double matrix[COORD_NUM][COORD_NUM], double vectors[COORD_NUM][COORD_NUM])
+{
+	double offDiagonal, theta, t, c, s, tau, p, q;
+	int sweep, i, j, k;
+
+	for (i = 0; i < COORD_NUM; i++)
+	{
+		for (j = 0; j < COORD_NUM; j++)
+		{
+			vectors[i][j] = i == j;
+		}
+	}
+	for (sweep = 0; sweep < MAX_SWEEPS; sweep++)
+	{
+		offDiagonal = fabs(matrix[X_POS][Y_POS]) + fabs(matrix[X_POS][Z_POS]) + fabs(matrix[Y_POS][Z_POS]);
+		if (offDiagonal == 0)
+		{
+			return;
+		}
+		for (i = 0; i < COORD_NUM; i++)
+		{
+			for (j = i + 1; j < COORD_NUM; j++)
+			{
+				if (matrix[i][j] == 0)
+				{
+					continue;
+				}
+				// the rotation that zeroes matrix[i][j], in the stable form
+				theta = (matrix[j][j] - matrix[i][i]) / (2 * matrix[i][j]);
+				t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+				c = 1 / sqrt(t * t + 1);
+				s = t * c;
+				tau = s / (1 + c);
+				p = matrix[i][j];
+				matrix[i][i] -= t * p;
+				matrix[j][j] += t * p;
+				matrix[i][j] = matrix[j][i] = 0;
+				for (k = 0; k < COORD_NUM; k++)
+				{
+					if (k != i && k != j)
+					{
+						p = matrix[k][i];
+						q = matrix[k][j];
+						matrix[k][i] = matrix[i][k] = p - s * (q + tau * p);
+						matrix[k][j] = matrix[j][k] = q + s * (p - tau * q);
+					}
+					p = vectors[k][i];
+					q = vectors[k][j];
+					vectors[k][i] = p - s * (q + tau * p);
+					vectors[k][j] = q + s * (p - tau * q);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Copies an eigenvector into a principal axis, pointing its largest coordinate up
+ * so the axes don't flip from one run to the next.
+ *
+ * @param vectors the eigenvectors, by columns.
+ * @param column the column of the eigenvector.
+ * @param axis the output principal axis.
+ */
+static void storeAxis(double vectors[COORD_NUM][COORD_NUM], int column, float axis[COORD_NUM])
+{
+	int largest = X_POS;
+	int i;
+
+	for (i = Y_POS; i < COORD_NUM; i++)
+	{
+		if (fabs(vectors[i][column]) > fabs(vectors[largest][column]))
+		{
+			largest = i;
+		}
+	}
+	for (i = 0; i < COORD_NUM; i++)
+	{
+		axis[i] = (float) (vectors[largest][column] < 0 ? -vectors[i][column] : vectors[i][column]);
+	}
+}
+
+void findShape(const struct CoordMoments* moments, int numOfPoints, struct ShapeStats* shape)
+{
+	double tensor[COORD_NUM][COORD_NUM];
+	double vectors[COORD_NUM][COORD_NUM];
+	int order[COORD_NUM] = {X_POS, Y_POS, Z_POS};
+	double trace;
+	int i, j, swap;
+
+	trace = moments->covariance[0] + moments->covariance[COORD_NUM + 1] + moments->covariance[2 * COORD_NUM + 2];
+	for (i = 0; i < COORD_NUM; i++)
+	{
+		shape->boxMinimum[i] = moments->minimum[i];
+		shape->boxMaximum[i] = moments->maximum[i];
+		shape->orientedBoxMinimum[i] = shape->orientedBoxMaximum[i] = 0;
+		for (j = 0; j < COORD_NUM; j++)
+		{
+			tensor[i][j] = moments->covariance[COORD_NUM * i + j] / numOfPoints;
+			shape->gyrationTensor[COORD_NUM * i + j] = (float) tensor[i][j];
+			shape->inertiaTensor[COORD_NUM * i + j] = (float) ((i == j ? trace : 0) -
+			                                                  moments->covariance[COORD_NUM * i + j]);
+		}
+	}
+
+	jacobiEigen(tensor, vectors);
+	// an insertion sort of the three eigenvalues, from the largest
+	for (i = 1; i < COORD_NUM; i++)
+	{
+		for (j = i; j > 0 && tensor[order[j]][order[j]] > tensor[order[j - 1]][order[j - 1]]; j--)
+		{
+			swap = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = swap;
+		}
+	}
+	for (i = 0; i < COORD_NUM; i++)
+	{
+		// rounding may leave a flat shape with a tiny negative moment
+		shape->principalMoments[i] = (float) fmax(tensor[order[i]][order[i]], 0);
+		storeAxis(vectors, order[i], shape->principalAxes + COORD_NUM * i);
+	}
+	shape->asphericity = shape->principalMoments[0] -
+	                     (shape->principalMoments[1] + shape->principalMoments[2]) / 2;
+}
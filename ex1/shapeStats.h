@@ -0,0 +1,31 @@
+/**
+ * @file shapeStats.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the shape of a set of points, from their second moments.
+ * The principal axes are the eigenvectors of the gyration tensor, found with
+ * Jacobi rotations, which are exact enough for a 3x3 symmetric matrix.
+ */
+
+#ifndef SHAPE_STATS_H
+#define SHAPE_STATS_H
+
+
+/* --- Includes --- */
+
+#include "coordKernels.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the shape of points from their moments about their center of gravity.
+ * Everything but the oriented bounding box is found, it is left empty.
+ *
+ * @param moments the moments of the points, see sumMoments.
+ * @param numOfPoints how many points there are, at least 1.
+ * @param shape the output shape.
+ */
+void findShape(const struct CoordMoments* moments, int numOfPoints, struct ShapeStats* shape);
+
+#endif
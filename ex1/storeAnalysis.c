@@ -0,0 +1,218 @@
+/**
+ * @file storeAnalysis.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the statistics of the atoms in a coordinate store.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "storeAnalysis.h"
+#include "allocator.h"
+#include "convexHull.h"
+#include "tiledDistance.h"
+#include "diameterCoreset.h"
+#include "shapeStats.h"
+
+
+/* --- Functions --- */
+
+void calculateCenterOfGravity(const struct CoordKernels* kernels, const struct CoordStore* store,
+                              float centerOfGravity[COORD_NUM])
+{
+	double sums[COORD_NUM];
+
+	if (store->size == 0)
+	{
+		centerOfGravity[X_POS] = 0.0f;
+		centerOfGravity[Y_POS] = 0.0f;
+		centerOfGravity[Z_POS] = 0.0f;
+		return;
+	}
+
+	kernels->sumCoords(store->x, store->y, store->z, store->size, sums);
+
+	centerOfGravity[X_POS] = (float) (sums[X_POS] / store->size);
+	centerOfGravity[Y_POS] = (float) (sums[Y_POS] / store->size);
+	centerOfGravity[Z_POS] = (float) (sums[Z_POS] / store->size);
+}
+
+float calculateTurnRadius(const struct CoordKernels* kernels, const struct CoordStore* store,
+                          const float centerOfGravity[COORD_NUM])
+{
+	double sum;
+
+	if (store->size == 0)
+	{
+		return 0;
+	}
+	sum = kernels->sumSquaredDistances(store->x, store->y, store->z, store->size, centerOfGravity);
+	return (float) sqrt(sum / store->size);
+}
+
+float calculateTurnRadiusShape(const struct CoordKernels* kernels, const struct CoordStore* store,
+                               const float centerOfGravity[COORD_NUM], struct ShapeStats* shape)
+{
+	struct CoordMoments moments;
+
+	if (store->size == 0)
+	{
+		memset(shape, 0, sizeof(struct ShapeStats));
+		return 0;
+	}
+	kernels->sumMoments(store->x, store->y, store->z, store->size, centerOfGravity, &moments);
+	findShape(&moments, store->size, shape);
+	return (float) sqrt(moments.squaredDistances / store->size);
+}
+
+void calculateOrientedBox(const struct CoordStore* points, const float centerOfGravity[COORD_NUM],
+                          struct ShapeStats* shape)
+{
+	const float* axis;
+	float projection;
+	int k, i;
+
+	for (k = 0; k < COORD_NUM; k++)
+	{
+		// the center of gravity is inside the points, so the box always reaches it
+		axis = shape->principalAxes + COORD_NUM * k;
+		shape->orientedBoxMinimum[k] = shape->orientedBoxMaximum[k] = 0;
+		for (i = 0; i < points->size; i++)
+		{
+			projection = (points->x[i] - centerOfGravity[X_POS]) * axis[X_POS] +
+			             (points->y[i] - centerOfGravity[Y_POS]) * axis[Y_POS] +
+			             (points->z[i] - centerOfGravity[Z_POS]) * axis[Z_POS];
+			shape->orientedBoxMinimum[k] = fminf(shape->orientedBoxMinimum[k], projection);
+			shape->orientedBoxMaximum[k] = fmaxf(shape->orientedBoxMaximum[k], projection);
+		}
+	}
+}
+
+float calculateMaxDistance(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                           const struct CoordStore* store)
+{
+	return sqrtf(tiledMaxSquaredDistance(pool, kernels, store->x, store->y, store->z, store->size));
+}
+
+float calculateMaxDistanceHull(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                               const struct CoordStore* store, struct CoordStore* hullStore)
+{
+	int* hullIndices;
+	int numOfHullPoints;
+	int i;
+
+	hullIndices = allocateMemory(hullStore->allocator, sizeof(int) * store->size);
+	if (!hullIndices)
+	{
+		clearCoordStore(hullStore);
+		return calculateMaxDistance(pool, kernels, store);
+	}
+	numOfHullPoints = findHullPoints(hullStore->allocator, store->x, store->y, store->z, store->size, hullIndices);
+	clearCoordStore(hullStore);
+	if (numOfHullPoints <= 0 || reserveCoords(hullStore, numOfHullPoints) < 0)
+	{
+		releaseMemory(hullStore->allocator, hullIndices);
+		return calculateMaxDistance(pool, kernels, store);
+	}
+
+	for(i = 0; i < numOfHullPoints; i++)
+	{
+		appendCoord(hullStore, store->x[hullIndices[i]], store->y[hullIndices[i]], store->z[hullIndices[i]]);
+	}
+	releaseMemory(hullStore->allocator, hullIndices);
+	return calculateMaxDistance(pool, kernels, hullStore);
+}
+
+float calculateMaxDistanceApprox(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                                 const struct CoordStore* store, struct CoordStore* hullStore, float epsilon,
+                                 float* bound)
+{
+	struct CoordStore* coreset;
+	float maxDistance;
+	float maxError = 0;
+	int ret;
+
+	coreset = coordStoreAlloc(hullStore->allocator);
+	ret = coreset ? findDiameterCoreset(store, epsilon, coreset, &maxError) : -ENOMEM;
+	if (ret <= 0)
+	{
+		freeCoordStore(&coreset);
+		*bound = calculateMaxDistanceHull(pool, kernels, store, hullStore);
+		return *bound;
+	}
+	maxDistance = calculateMaxDistanceHull(pool, kernels, coreset, hullStore);
+	freeCoordStore(&coreset);
+	*bound = maxDistance + maxError;
+	return maxDistance;
+}
+
+/**
+ * Counts the pairs of n points.
+ *
+ * @param numOfPoints how many points there are.
+ * @return How many pairs of them there are.
+ */
+static long long countPairs(int numOfPoints)
+{
+	return (long long) numOfPoints * (numOfPoints - 1) / 2;
+}
+
+void calculateStoreTurnRadius(const struct AnalysisOptions* options, const struct CoordStore* store,
+                              struct ProteinStats* stats)
+{
+	stats->hasShape = options->useShape;
+	if (options->useShape)
+	{
+		// the moments hold the squared distances of Rg, so there's no separate pass for it
+		stats->turnRadius = calculateTurnRadiusShape(options->kernels, store, stats->centerOfGravity, &stats->shape);
+	}
+	else
+	{
+		stats->turnRadius = calculateTurnRadius(options->kernels, store, stats->centerOfGravity);
+	}
+}
+
+void calculateStoreMaxDistance(const struct AnalysisOptions* options, const struct CoordStore* store,
+                               struct CoordStore* hullStore, struct ProteinStats* stats)
+{
+	// the hull searches compare the points they leave in the hull store, which is empty if they fell back
+	const struct CoordStore* compared = store;
+
+	if (options->dmaxEpsilon > 0)
+	{
+		stats->maxDistance = calculateMaxDistanceApprox(options->pool, options->kernels, store, hullStore,
+		                                                options->dmaxEpsilon, &stats->maxDistanceBound);
+		compared = hullStore->size > 0 ? hullStore : store;
+	}
+	else if (options->useHull)
+	{
+		stats->maxDistance = calculateMaxDistanceHull(options->pool, options->kernels, store, hullStore);
+		stats->maxDistanceBound = stats->maxDistance;
+		compared = hullStore->size > 0 ? hullStore : store;
+	}
+	else
+	{
+		stats->maxDistance = calculateMaxDistance(options->pool, options->kernels, store);
+		stats->maxDistanceBound = stats->maxDistance;
+	}
+	stats->numOfPairs = countPairs(compared->size);
+	if (stats->hasShape)
+	{
+		// the farthest points along any axis are on the hull, unless the hull is of the coreset
+		calculateOrientedBox(options->useHull && options->dmaxEpsilon == 0 && hullStore->size > 0 ? hullStore : store,
+		                     stats->centerOfGravity, &stats->shape);
+	}
+}
+
+void analyzeStore(const struct AnalysisOptions* options, const struct CoordStore* store,
+                  struct CoordStore* hullStore, struct ProteinStats* stats)
+{
+	stats->numOfAtoms = store->size;
+	calculateCenterOfGravity(options->kernels, store, stats->centerOfGravity);
+	calculateStoreTurnRadius(options, store, stats);
+	calculateStoreMaxDistance(options, store, hullStore, stats);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file storeAnalysis.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the statistics of the atoms in a coordinate store.
+ * Not part of the libpdbstats interface, the handle functions of pdbStats.h
+ * are built on these, and the programs use them directly on their own stores.
+ */
+
+#ifndef STORE_ANALYSIS_H
+#define STORE_ANALYSIS_H
+
+
+/* --- Includes --- */
+
+#include "pdbStats.h"
+#include "coordStore.h"
+#include "coordKernels.h"
+#include "threadPool.h"
+
+
+/* --- Structs --- */
+
+/** How the files are analyzed. */
+struct AnalysisOptions
+{
+	const struct CoordKernels* kernels;
+	// threads for the Dmax search, NULL to search on the calling thread
+	struct ThreadPool* pool;
+	int useHull;
+	// the relative error allowed in Dmax, 0 for the exact value
+	float dmaxEpsilon;
+	// read the atoms from the binary cache when it is valid, and write it otherwise
+	int useCache;
+	// also find the shape of the atoms, in the same pass as Rg
+	int useShape;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Calcualtes the center of gravity of the given points.
+ *
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @param centerOfGravity the output array, representing (x, y, z).
+ */
+void calculateCenterOfGravity(const struct CoordKernels* kernels, const struct CoordStore* store,
+                              float centerOfGravity[COORD_NUM]);
+
+/**
+ * Calcualtes the turn radius of the given points.
+ *
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @param centerOfGravity the center of gravity of the points.
+ * @return The turn radius.
+ */
+float calculateTurnRadius(const struct CoordKernels* kernels, const struct CoordStore* store,
+                          const float centerOfGravity[COORD_NUM]);
+
+/**
+ * Calcualtes the turn radius and the shape of the given points in a single pass.
+ * Everything but the oriented bounding box is found, see calculateOrientedBox.
+ *
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @param centerOfGravity the center of gravity of the points.
+ * @param shape the output shape.
+ * @return The turn radius, the same as calculateTurnRadius returns.
+ */
+float calculateTurnRadiusShape(const struct CoordKernels* kernels, const struct CoordStore* store,
+                               const float centerOfGravity[COORD_NUM], struct ShapeStats* shape);
+
+/**
+ * Calculates the oriented bounding box of a shape found by calculateTurnRadiusShape.
+ * Only the extreme points matter, so the hull points may be given instead of all the points.
+ *
+ * @param points the points, or their convex hull.
+ * @param centerOfGravity the center of gravity of all the points.
+ * @param shape the shape, receives the box.
+ */
+void calculateOrientedBox(const struct CoordStore* points, const float centerOfGravity[COORD_NUM],
+                          struct ShapeStats* shape);
+
+/**
+ * Calcualtes the maximum distance between all given points.
+ * Squared distances are compared, and the root is taken once at the end.
+ *
+ * @param pool the threads to calculate on, NULL to calculate on this thread.
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @return The maxium distance between the points.
+ */
+float calculateMaxDistance(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                           const struct CoordStore* store);
+
+/**
+ * Calcualtes the maximum distance between all given points.
+ * The two farthest points are always on the convex hull, so only the hull
+ * points are compared. Falls back to comparing all the points if the hull
+ * can't be built.
+ *
+ * @param pool the threads to calculate on, NULL to calculate on this thread.
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @param hullStore a scratch store, receives the hull points.
+ * @return The maxium distance between the points.
+ */
+float calculateMaxDistanceHull(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                               const struct CoordStore* store, struct CoordStore* hullStore);
+
+/**
+ * Approximates the maximum distance between all given points in about linear time.
+ * Only the points of a diameter coreset are compared, see diameterCoreset.h.
+ * Falls back to the exact search if the coreset isn't smaller than the points.
+ *
+ * @param pool the threads to calculate on, NULL to calculate on this thread.
+ * @param kernels the kernels to calculate with.
+ * @param store the points.
+ * @param hullStore a scratch store, receives the hull points of the coreset.
+ * @param epsilon the relative error allowed, between 0 and 1.
+ * @param bound the output, the true maximum distance is at most this.
+ * @return A maximum distance at least (1 - epsilon) times the true one, and at most it.
+ */
+float calculateMaxDistanceApprox(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                                 const struct CoordStore* store, struct CoordStore* hullStore, float epsilon,
+                                 float* bound);
+
+/**
+ * Calculates Rg of the atoms in a store, as analyzeStore does.
+ * Sets turnRadius, hasShape and shape of the statistics, from their center of gravity.
+ *
+ * @param options how to calculate.
+ * @param store the atoms.
+ * @param stats the statistics, receives the output.
+ */
+void calculateStoreTurnRadius(const struct AnalysisOptions* options, const struct CoordStore* store,
+                              struct ProteinStats* stats);
+
+/**
+ * Calculates Dmax of the atoms in a store, as analyzeStore does.
+ * Sets maxDistance, maxDistanceBound and numOfPairs of the statistics, and
+ * the oriented box of their shape if they have one.
+ *
+ * @param options how to calculate.
+ * @param store the atoms.
+ * @param hullStore a scratch store for the hull points.
+ * @param stats the output statistics.
+ */
+void calculateStoreMaxDistance(const struct AnalysisOptions* options, const struct CoordStore* store,
+                               struct CoordStore* hullStore, struct ProteinStats* stats);
+
+/**
+ * Calculates the statistics of the atoms in a store.
+ *
+ * @param options how to calculate.
+ * @param store the atoms, must not be empty.
+ * @param hullStore a scratch store for the hull points.
+ * @param stats the output statistics.
+ */
+void analyzeStore(const struct AnalysisOptions* options, const struct CoordStore* store,
+                  struct CoordStore* hullStore, struct ProteinStats* stats);
+
+/**
+ * Gets the atoms of the last parse.
+ *
+ * @param handle the handle.
+ * @return The atoms, owned by the handle and valid until the next parse.
+ */
+const struct CoordStore* getPdbAtoms(const struct PdbStats* handle);
+
+#endif
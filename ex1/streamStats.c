@@ -0,0 +1,198 @@
+/**
+ * @file streamStats.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the stream statistics.
+ */
+
+
+/* --- Includes --- */
+
+#include <errno.h>
+#include <math.h>
+#include "streamStats.h"
+
+
+/* --- Constants --- */
+
+/** The seed of the sampling, fixed so runs are repeatable. */
+#define RANDOM_SEED 0x9E3779B97F4A7C15ULL
+
+
+/* --- Functions --- */
+
+/**
+ * Draws the next random number, xorshift64.
+ *
+ * @param stats the statistics holding the random state.
+ * @return A random number.
+ */
+static unsigned long long nextRandom(struct StreamStats* stats)
+{
+	stats->randomState ^= stats->randomState << 13;
+	stats->randomState ^= stats->randomState >> 7;
+	stats->randomState ^= stats->randomState << 17;
+	return stats->randomState;
+}
+
+int initStreamStats(struct StreamStats* stats, int sampleSize)
+{
+	stats->sampleSize = sampleSize;
+	stats->sample = NULL;
+	if (sampleSize > 0)
+	{
+		stats->sample = coordStoreAlloc(NULL);
+		if (!stats->sample || reserveCoords(stats->sample, sampleSize) < 0)
+		{
+			freeCoordStore(&stats->sample);
+			return -ENOMEM;
+		}
+	}
+	resetStreamStats(stats);
+	return 0;
+}
+
+void cleanupStreamStats(struct StreamStats* stats)
+{
+	freeCoordStore(&stats->sample);
+}
+
+void resetStreamStats(struct StreamStats* stats)
+{
+	int axis;
+
+	stats->numOfAtoms = 0;
+	stats->sumOfSquares = 0;
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		stats->mean[axis] = 0;
+	}
+	if (stats->sample)
+	{
+		clearCoordStore(stats->sample);
+	}
+	stats->randomState = RANDOM_SEED;
+}
+
+int addStreamAtom(void* context, const char* line, float x, float y, float z)
+{
+	struct StreamStats* stats = context;
+	double point[COORD_NUM];
+	double delta[COORD_NUM];
+	unsigned long long slot;
+	int axis;
+
+	(void) line;
+	point[X_POS] = x;
+	point[Y_POS] = y;
+	point[Z_POS] = z;
+	stats->numOfAtoms++;
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		delta[axis] = point[axis] - stats->mean[axis];
+		stats->mean[axis] += delta[axis] / stats->numOfAtoms;
+		// the old delta times the new one, Welford's update
+		stats->sumOfSquares += delta[axis] * (point[axis] - stats->mean[axis]);
+	}
+
+	if (stats->sampleSize == 0)
+	{
+		return 0;
+	}
+	for (axis = 0; axis < COORD_NUM; axis++)
+	{
+		if (stats->numOfAtoms == 1 || point[axis] < stats->extremes[2 * axis][axis])
+		{
+			stats->extremes[2 * axis][X_POS] = x;
+			stats->extremes[2 * axis][Y_POS] = y;
+			stats->extremes[2 * axis][Z_POS] = z;
+		}
+		if (stats->numOfAtoms == 1 || point[axis] > stats->extremes[2 * axis + 1][axis])
+		{
+			stats->extremes[2 * axis + 1][X_POS] = x;
+			stats->extremes[2 * axis + 1][Y_POS] = y;
+			stats->extremes[2 * axis + 1][Z_POS] = z;
+		}
+	}
+	if (stats->sample->size < stats->sampleSize)
+	{
+		// there is room, appending never grows the store
+		appendCoord(stats->sample, x, y, z);
+		return 0;
+	}
+	slot = nextRandom(stats) % (unsigned long long) stats->numOfAtoms;
+	if (slot < (unsigned long long) stats->sampleSize)
+	{
+		stats->sample->x[slot] = x;
+		stats->sample->y[slot] = y;
+		stats->sample->z[slot] = z;
+	}
+	return 0;
+}
+
+void streamCenterOfGravity(const struct StreamStats* stats, float centerOfGravity[COORD_NUM])
+{
+	centerOfGravity[X_POS] = (float) stats->mean[X_POS];
+	centerOfGravity[Y_POS] = (float) stats->mean[Y_POS];
+	centerOfGravity[Z_POS] = (float) stats->mean[Z_POS];
+}
+
+float streamTurnRadius(const struct StreamStats* stats)
+{
+	if (stats->numOfAtoms == 0)
+	{
+		return 0;
+	}
+	return (float) sqrt(stats->sumOfSquares / stats->numOfAtoms);
+}
+
+/**
+ * Checks if a store holds a point.
+ *
+ * @param store the store.
+ * @param point the point.
+ * @return 1 if it does, 0 otherwise.
+ */
+static int containsCoord(const struct CoordStore* store, const float point[COORD_NUM])
+{
+	int i;
+
+	for (i = 0; i < store->size; i++)
+	{
+		if (store->x[i] == point[X_POS] && store->y[i] == point[Y_POS] && store->z[i] == point[Z_POS])
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int copyStreamSample(const struct StreamStats* stats, struct CoordStore* store)
+{
+	int ret;
+	int i;
+
+	clearCoordStore(store);
+	if (!stats->sample || stats->numOfAtoms == 0)
+	{
+		return 0;
+	}
+	ret = reserveCoords(store, stats->sample->size + 2 * COORD_NUM);
+	if (ret < 0)
+	{
+		return ret;
+	}
+	for (i = 0; i < stats->sample->size; i++)
+	{
+		appendCoord(store, stats->sample->x[i], stats->sample->y[i], stats->sample->z[i]);
+	}
+	// a sample of every atom holds the extremes already, and an atom may be the extreme of several axes
+	for (i = 0; i < 2 * COORD_NUM && stats->numOfAtoms > stats->sample->size; i++)
+	{
+		if (!containsCoord(store, stats->extremes[i]))
+		{
+			appendCoord(store, stats->extremes[i][X_POS], stats->extremes[i][Y_POS], stats->extremes[i][Z_POS]);
+		}
+	}
+	return store->size;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file streamStats.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for single pass statistics that don't keep the atoms.
+ */
+
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+
+
+/* --- Includes --- */
+
+#include "coordStore.h"
+
+
+/* --- Constants --- */
+
+/** Default number of atoms sampled for Dmax. */
+#define DEFAULT_SAMPLE_SIZE 4096
+
+
+/* --- Structs --- */
+
+/**
+ * Running statistics of a stream of atoms.
+ * The center of gravity and the sum of squared distances from it are
+ * updated with Welford's method, so the error doesn't grow with the number
+ * of atoms. A bounded sample of the atoms is kept for estimating Dmax:
+ * a uniform reservoir sample, plus the extreme atoms on every axis.
+ */
+struct StreamStats
+{
+	long numOfAtoms;
+	double mean[COORD_NUM];
+	double sumOfSquares;
+	int sampleSize;
+	struct CoordStore* sample;
+	float extremes[2 * COORD_NUM][COORD_NUM];
+	unsigned long long randomState;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Initializes empty statistics.
+ *
+ * @param stats the statistics to initialize.
+ * @param sampleSize how many atoms to sample for Dmax, 0 for no sample.
+ * @return 0 on success, an error code otherwise. Free with cleanupStreamStats.
+ */
+int initStreamStats(struct StreamStats* stats, int sampleSize);
+
+/**
+ * Frees the memory of the statistics.
+ *
+ * @param stats the statistics.
+ */
+void cleanupStreamStats(struct StreamStats* stats);
+
+/**
+ * Empties the statistics, keeping their memory.
+ *
+ * @param stats the statistics.
+ */
+void resetStreamStats(struct StreamStats* stats);
+
+/**
+ * Adds an atom to the statistics. Can be used as the addAtom of an AtomSink.
+ *
+ * @param context the StreamStats.
+ * @param line the ATOM line.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return Always 0.
+ */
+int addStreamAtom(void* context, const char* line, float x, float y, float z);
+
+/**
+ * Gets the center of gravity of the atoms so far.
+ *
+ * @param stats the statistics.
+ * @param centerOfGravity the output array, representing (x, y, z).
+ */
+void streamCenterOfGravity(const struct StreamStats* stats, float centerOfGravity[COORD_NUM]);
+
+/**
+ * Gets the turn radius of the atoms so far.
+ *
+ * @param stats the statistics.
+ * @return The turn radius.
+ */
+float streamTurnRadius(const struct StreamStats* stats);
+
+/**
+ * Copies the sampled atoms into a store, with the atoms at the extremes of
+ * every axis that aren't in the sample already.
+ * The maximum distance in the sample is a lower bound of Dmax.
+ *
+ * @param stats the statistics.
+ * @param store the output store.
+ * @return How many atoms were copied, or a negative error code.
+ */
+int copyStreamSample(const struct StreamStats* stats, struct CoordStore* store);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file superposition.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the optimal superposition.
+ */
+
+
+/* --- Includes --- */
+
+#include <math.h>
+#include "superposition.h"
+
+
+/* --- Constants --- */
+
+/** The size of the quaternion matrix. */
+#define QUATERNION_SIZE 4
+
+/** Maximum number of Jacobi sweeps, it converges in far fewer. */
+#define MAX_SWEEPS 50
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the eigenvalues and eigenvectors of a symmetric matrix with Jacobi rotations.
+ *
+ * @param matrix the matrix, its diagonal receives the eigenvalues.
+ * @param vectors the output eigenvectors, column k belongs to eigenvalue k.
+ */
+static void jacobiEigen(double matrix[QUATERNION_SIZE][QUATERNION_SIZE],
+                        double vectors[QUATERNION_SIZE][QUATERNION_SIZE])
+{
+	double offDiagonal, theta, t, c, s, tau, p, q;
+	int sweep, i, j, k;
+
+	for (i = 0; i < QUATERNION_SIZE; i++)
+	{
+		for (j = 0; j < QUATERNION_SIZE; j++)
+		{
+			vectors[i][j] = i == j;
+		}
+	}
+	for (sweep = 0; sweep < MAX_SWEEPS; sweep++)
+	{
+		offDiagonal = 0;
+		for (i = 0; i < QUATERNION_SIZE; i++)
+		{
+			for (j = i + 1; j < QUATERNION_SIZE; j++)
+			{
+				offDiagonal += fabs(matrix[i][j]);
+			}
+		}
+		if (offDiagonal == 0)
+		{
+			return;
+		}
+		for (i = 0; i < QUATERNION_SIZE; i++)
+		{
+			for (j = i + 1; j < QUATERNION_SIZE; j++)
+			{
+				if (matrix[i][j] == 0)
+				{
+					continue;
+				}
+				// the rotation that zeroes matrix[i][j], in the stable form
+				theta = (matrix[j][j] - matrix[i][i]) / (2 * matrix[i][j]);
+				t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+				c = 1 / sqrt(t * t + 1);
+				s = t * c;
+				tau = s / (1 + c);
+				p = matrix[i][j];
+				matrix[i][i] -= t * p;
+				matrix[j][j] += t * p;
+				matrix[i][j] = matrix[j][i] = 0;
+				for (k = 0; k < QUATERNION_SIZE; k++)
+				{
+					if (k != i && k != j)
+					{
+						p = matrix[k][i];
+						q = matrix[k][j];
+						matrix[k][i] = matrix[i][k] = p - s * (q + tau * p);
+						matrix[k][j] = matrix[j][k] = q + s * (p - tau * q);
+					}
+					p = vectors[k][i];
+					q = vectors[k][j];
+					vectors[k][i] = p - s * (q + tau * p);
+					vectors[k][j] = q + s * (p - tau * q);
+				}
+			}
+		}
+	}
+}
+
+double superpose(const double covariance[COORD_NUM * COORD_NUM], double sumOfSquares, int numOfPoints,
+                 double rotation[COORD_NUM * COORD_NUM])
+{
+	double sxx = covariance[0], sxy = covariance[1], sxz = covariance[2];
+	double syx = covariance[3], syy = covariance[4], syz = covariance[5];
+	double szx = covariance[6], szy = covariance[7], szz = covariance[8];
+	double matrix[QUATERNION_SIZE][QUATERNION_SIZE] = {
+		{sxx + syy + szz, syz - szy, szx - sxz, sxy - syx},
+		{syz - szy, sxx - syy - szz, sxy + syx, szx + sxz},
+		{szx - sxz, sxy + syx, -sxx + syy - szz, syz + szy},
+		{sxy - syx, szx + sxz, syz + szy, -sxx - syy + szz}
+	};
+	double vectors[QUATERNION_SIZE][QUATERNION_SIZE];
+	double q0, q1, q2, q3;
+	double squaredDeviation;
+	int best = 0;
+	int i;
+
+	if (numOfPoints == 0)
+	{
+		return 0;
+	}
+	jacobiEigen(matrix, vectors);
+	for (i = 1; i < QUATERNION_SIZE; i++)
+	{
+		if (matrix[i][i] > matrix[best][best])
+		{
+			best = i;
+		}
+	}
+
+	if (rotation)
+	{
+		// the unit quaternion of the largest eigenvalue, as a rotation matrix
+		q0 = vectors[0][best];
+		q1 = vectors[1][best];
+		q2 = vectors[2][best];
+		q3 = vectors[3][best];
+		rotation[0] = q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3;
+		rotation[1] = 2 * (q1 * q2 + q0 * q3);
+		rotation[2] = 2 * (q1 * q3 - q0 * q2);
+		rotation[3] = 2 * (q1 * q2 - q0 * q3);
+		rotation[4] = q0 * q0 - q1 * q1 + q2 * q2 - q3 * q3;
+		rotation[5] = 2 * (q2 * q3 + q0 * q1);
+		rotation[6] = 2 * (q1 * q3 + q0 * q2);
+		rotation[7] = 2 * (q2 * q3 - q0 * q1);
+		rotation[8] = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+	}
+
+	squaredDeviation = (sumOfSquares - 2 * matrix[best][best]) / numOfPoints;
+	// rounding can push a perfect fit slightly below zero
+	return squaredDeviation > 0 ? sqrt(squaredDeviation) : 0;
+}
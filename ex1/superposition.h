@@ -0,0 +1,36 @@
+/**
+ * @file superposition.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the optimal superposition of two sets of matching points.
+ * The rotation that minimizes the RMSD (the Kabsch problem) is found with
+ * Horn's quaternion method, from the largest eigenvalue of a 4x4 symmetric
+ * matrix built from the cross covariance of the two sets.
+ */
+
+#ifndef SUPERPOSITION_H
+#define SUPERPOSITION_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the optimal superposition of two centered sets of matching points.
+ *
+ * @param covariance the cross covariance of the sets, covariance[COORD_NUM * i + j]
+ *        is the sum of a_i * b_j, see crossCovariance.
+ * @param sumOfSquares the sum of the squared norms of all the points of both sets.
+ * @param numOfPoints how many points there are in each set.
+ * @param rotation the output 3x3 rotation, row major, that best moves the second
+ *        set onto the first. May be NULL.
+ * @return The RMSD of the sets after the rotation.
+ */
+double superpose(const double covariance[COORD_NUM * COORD_NUM], double sumOfSquares, int numOfPoints,
+                 double rotation[COORD_NUM * COORD_NUM]);
+
+#endif
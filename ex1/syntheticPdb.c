@@ -0,0 +1,313 @@
+/**
+ * @file syntheticPdb.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the synthetic pdb files.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "syntheticPdb.h"
+
+
+/* --- Constants --- */
+
+/** Pi, which C99 doesn't define. */
+#define PI 3.14159265358979323846
+
+/** The volume of an atom in a folded protein, in cubic angstroms. */
+#define ATOM_VOLUME 12.0
+
+/** How many times longer than its radius a fibril is. */
+#define FIBRIL_ASPECT 10.0
+
+/** How far an atom may move between models, in angstroms. */
+#define MODEL_JITTER 0.5
+
+/** The most atoms in a model, so all the coordinates fit their columns. */
+#define MAX_SYNTHETIC_ATOMS 20000000L
+
+/** The most models in a file, so the model numbers fit their columns. */
+#define MAX_SYNTHETIC_MODELS 9999
+
+/** How many residues a chain has before the next chain starts. */
+#define RESIDUES_PER_CHAIN 1000
+
+/** How many chain IDs there are before they repeat. */
+#define NUM_OF_CHAINS 26
+
+/** A MODEL record before its number is filled. */
+#define MODEL_LINE_TEMPLATE "MODEL         \n"
+
+/** The length of a MODEL record, with its new line. */
+#define MODEL_LINE_LENGTH 15
+
+/** The columns of the model number. */
+#define MODEL_NUMBER_START 10
+#define MODEL_NUMBER_LENGTH 4
+
+/** An ATOM line before its fields are filled. */
+#define ATOM_LINE_TEMPLATE "ATOM                                                    1.00  0.00           C  \n"
+
+/** The columns of the ATOM fields. */
+#define SERIAL_START 6
+#define SERIAL_LENGTH 5
+#define NAME_START 12
+#define NAME_LENGTH 4
+#define RESIDUE_NAME_START 17
+#define RESIDUE_NAME_LENGTH 3
+#define CHAIN_START 21
+#define RESIDUE_START 22
+#define RESIDUE_LENGTH 4
+#define COORDS_START 30
+#define COORD_LENGTH 8
+#define ELEMENT_START 77
+
+/** Serial numbers start over after this, so they fit their columns. */
+#define MAX_SERIAL 100000
+
+/** The ENDMDL record. */
+#define ENDMDL_LINE "ENDMDL\n"
+
+/** The END record. */
+#define END_LINE "END\n"
+
+/** Mixes the seed into a random state, the golden ratio. */
+#define SEED_MIX 0x9E3779B97F4A7C15ULL
+
+/** The atoms of a residue backbone. */
+static const char* const ATOM_NAMES[] = {" N  ", " CA ", " C  ", " O  "};
+
+/** The elements of the atoms of a residue backbone. */
+static const char ATOM_ELEMENTS[] = {'N', 'C', 'C', 'O'};
+
+/** How many atoms each residue has. */
+#define ATOMS_PER_RESIDUE 4
+
+/** The residue names, used in turn. */
+static const char* const RESIDUE_NAMES[] = {"ALA", "ARG", "ASN", "ASP", "CYS", "GLN", "GLU", "GLY", "HIS", "ILE",
+                                            "LEU", "LYS", "MET", "PHE", "PRO", "SER", "THR", "TRP", "TYR", "VAL"};
+
+/** How many residue names there are. */
+#define NUM_OF_RESIDUE_NAMES 20
+
+
+/* --- Functions --- */
+
+/**
+ * Makes a random state from a seed. The state of xorshift must not be 0.
+ *
+ * @param seed the seed.
+ * @return The state.
+ */
+static unsigned long long seedState(unsigned long long seed)
+{
+	unsigned long long state = (seed + 1) * SEED_MIX;
+	return state ? state : SEED_MIX;
+}
+
+/**
+ * Draws the next random number in [-1, 1), xorshift64.
+ *
+ * @param state the random state.
+ * @return A random number.
+ */
+static double nextUniform(unsigned long long* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	// the top 53 bits fill the mantissa of a double
+	return (double) (*state >> 11) / (1ULL << 52) - 1;
+}
+
+/**
+ * Draws the next atom of the shape, uniform in its volume.
+ *
+ * @param pdb the generator.
+ * @param coords the output coordinates.
+ */
+static void nextShapeAtom(struct SyntheticPdb* pdb, double coords[3])
+{
+	do
+	{
+		coords[0] = nextUniform(&pdb->shapeState);
+		coords[1] = nextUniform(&pdb->shapeState);
+		coords[2] = pdb->isFibril ? 0 : nextUniform(&pdb->shapeState);
+	}
+	while (coords[0] * coords[0] + coords[1] * coords[1] + coords[2] * coords[2] > 1);
+
+	coords[0] *= pdb->radius;
+	coords[1] *= pdb->radius;
+	coords[2] = pdb->isFibril ? nextUniform(&pdb->shapeState) * pdb->length / 2 : coords[2] * pdb->radius;
+}
+
+int initSyntheticPdb(struct SyntheticPdb* pdb, const char* shape, long numOfAtoms, int numOfModels,
+                     unsigned long long seed)
+{
+	double volume = ATOM_VOLUME * numOfAtoms;
+
+	if (strcmp(shape, SHAPE_BLOB) == 0)
+	{
+		pdb->isFibril = 0;
+		pdb->radius = cbrt(volume * 3 / (4 * PI));
+		pdb->length = 2 * pdb->radius;
+	}
+	else if (strcmp(shape, SHAPE_FIBRIL) == 0)
+	{
+		pdb->isFibril = 1;
+		pdb->radius = cbrt(volume / (FIBRIL_ASPECT * PI));
+		pdb->length = FIBRIL_ASPECT * pdb->radius;
+	}
+	else
+	{
+		return -EINVAL;
+	}
+	if (numOfAtoms < 1 || numOfAtoms > MAX_SYNTHETIC_ATOMS || numOfModels < 1 || numOfModels > MAX_SYNTHETIC_MODELS)
+	{
+		return -EINVAL;
+	}
+
+	pdb->numOfAtoms = numOfAtoms;
+	pdb->numOfModels = numOfModels;
+	pdb->seed = seed;
+	pdb->model = 0;
+	pdb->atom = 0;
+	pdb->isModelOpen = 0;
+	pdb->isDone = 0;
+	return 0;
+}
+
+size_t syntheticPdbSize(const struct SyntheticPdb* pdb)
+{
+	size_t modelSize = (size_t) pdb->numOfAtoms * SYNTHETIC_LINE_LENGTH;
+	if (pdb->numOfModels > 1)
+	{
+		modelSize += MODEL_LINE_LENGTH + sizeof(ENDMDL_LINE) - 1;
+	}
+	return modelSize * pdb->numOfModels + sizeof(END_LINE) - 1;
+}
+
+/**
+ * Formats a number right aligned in a field, padded with spaces.
+ * The number must fit the field.
+ *
+ * @param field the output field, not null terminated.
+ * @param width the width of the field.
+ * @param value the number, times 10 to the power of decimals.
+ * @param decimals how many digits follow the decimal point.
+ */
+static void formatNumber(char* field, int width, long long value, int decimals)
+{
+	unsigned long long digits = value < 0 ? -(unsigned long long) value : (unsigned long long) value;
+	int position = width - 1;
+	int i;
+
+	for (i = 0; i < decimals; i++)
+	{
+		field[position--] = (char) ('0' + digits % 10);
+		digits /= 10;
+	}
+	if (decimals > 0)
+	{
+		field[position--] = '.';
+	}
+	do
+	{
+		field[position--] = (char) ('0' + digits % 10);
+		digits /= 10;
+	}
+	while (digits > 0);
+	if (value < 0)
+	{
+		field[position--] = '-';
+	}
+	while (position >= 0)
+	{
+		field[position--] = ' ';
+	}
+}
+
+/**
+ * Writes the next ATOM line.
+ * The line is built by hand, printf is many times slower for big files.
+ *
+ * @param pdb the generator.
+ * @param line the output, SYNTHETIC_LINE_LENGTH long.
+ */
+static void writeAtomLine(struct SyntheticPdb* pdb, char* line)
+{
+	double coords[3];
+	long residue = pdb->atom / ATOMS_PER_RESIDUE;
+	int i;
+
+	nextShapeAtom(pdb, coords);
+	if (pdb->numOfModels > 1)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			coords[i] += nextUniform(&pdb->jitterState) * MODEL_JITTER;
+		}
+	}
+	memcpy(line, ATOM_LINE_TEMPLATE, SYNTHETIC_LINE_LENGTH);
+	formatNumber(line + SERIAL_START, SERIAL_LENGTH, (pdb->atom + 1) % MAX_SERIAL, 0);
+	memcpy(line + NAME_START, ATOM_NAMES[pdb->atom % ATOMS_PER_RESIDUE], NAME_LENGTH);
+	memcpy(line + RESIDUE_NAME_START, RESIDUE_NAMES[residue % NUM_OF_RESIDUE_NAMES], RESIDUE_NAME_LENGTH);
+	line[CHAIN_START] = (char) ('A' + residue / RESIDUES_PER_CHAIN % NUM_OF_CHAINS);
+	formatNumber(line + RESIDUE_START, RESIDUE_LENGTH, residue % RESIDUES_PER_CHAIN + 1, 0);
+	for (i = 0; i < 3; i++)
+	{
+		formatNumber(line + COORDS_START + i * COORD_LENGTH, COORD_LENGTH, llround(coords[i] * 1000), 3);
+	}
+	line[ELEMENT_START] = ATOM_ELEMENTS[pdb->atom % ATOMS_PER_RESIDUE];
+	pdb->atom++;
+}
+
+size_t writeSyntheticLines(struct SyntheticPdb* pdb, char* buffer, size_t capacity)
+{
+	size_t size = 0;
+
+	while (!pdb->isDone && capacity - size >= SYNTHETIC_LINE_LENGTH)
+	{
+		if (!pdb->isModelOpen)
+		{
+			// every model starts from the same atoms
+			pdb->shapeState = seedState(pdb->seed);
+			pdb->jitterState = seedState(pdb->seed ^ ((unsigned long long) (pdb->model + 1) << 32));
+			pdb->isModelOpen = 1;
+			if (pdb->numOfModels > 1)
+			{
+				memcpy(buffer + size, MODEL_LINE_TEMPLATE, MODEL_LINE_LENGTH);
+				formatNumber(buffer + size + MODEL_NUMBER_START, MODEL_NUMBER_LENGTH, pdb->model + 1, 0);
+				size += MODEL_LINE_LENGTH;
+			}
+		}
+		else if (pdb->atom < pdb->numOfAtoms)
+		{
+			writeAtomLine(pdb, buffer + size);
+			size += SYNTHETIC_LINE_LENGTH;
+		}
+		else
+		{
+			if (pdb->numOfModels > 1)
+			{
+				memcpy(buffer + size, ENDMDL_LINE, sizeof(ENDMDL_LINE) - 1);
+				size += sizeof(ENDMDL_LINE) - 1;
+			}
+			pdb->model++;
+			pdb->atom = 0;
+			pdb->isModelOpen = 0;
+			if (pdb->model == pdb->numOfModels)
+			{
+				memcpy(buffer + size, END_LINE, sizeof(END_LINE) - 1);
+				size += sizeof(END_LINE) - 1;
+				pdb->isDone = 1;
+			}
+		}
+	}
+	return size;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file syntheticPdb.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for generating synthetic pdb files of any size.
+ * The atoms fill a shape at about the density of a folded protein, and the
+ * same seed always gives the same file.
+ */
+
+#ifndef SYNTHETIC_PDB_H
+#define SYNTHETIC_PDB_H
+
+
+/* --- Includes --- */
+
+#include <stddef.h>
+
+
+/* --- Constants --- */
+
+/** A round blob, like a globular protein. */
+#define SHAPE_BLOB "blob"
+
+/** A long thin cylinder, like a fibril. */
+#define SHAPE_FIBRIL "fibril"
+
+/** The length of an ATOM line, with its new line. */
+#define SYNTHETIC_LINE_LENGTH 81
+
+
+/* --- Structs --- */
+
+/** A synthetic file being generated. */
+struct SyntheticPdb
+{
+	int isFibril;
+	long numOfAtoms;
+	int numOfModels;
+	unsigned long long seed;
+	// the radius of the blob or the fibril, and the length of the fibril
+	double radius;
+	double length;
+	// how far the generation got
+	int model;
+	long atom;
+	int isModelOpen;
+	int isDone;
+	unsigned long long shapeState;
+	unsigned long long jitterState;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Starts generating a synthetic file.
+ * Every model holds the same atoms, each moved a little at random.
+ * Files with more than one model have MODEL and ENDMDL records.
+ *
+ * @param pdb the output generator.
+ * @param shape SHAPE_BLOB or SHAPE_FIBRIL.
+ * @param numOfAtoms how many atoms each model has, positive.
+ * @param numOfModels how many models there are, positive.
+ * @param seed the seed of the random atoms.
+ * @return 0 on success, -EINVAL if an argument is invalid.
+ */
+int initSyntheticPdb(struct SyntheticPdb* pdb, const char* shape, long numOfAtoms, int numOfModels,
+                     unsigned long long seed);
+
+/**
+ * Calculates the size of the whole file.
+ *
+ * @param pdb the generator.
+ * @return The size of the file in bytes.
+ */
+size_t syntheticPdbSize(const struct SyntheticPdb* pdb);
+
+/**
+ * Writes the next lines of the file to a buffer.
+ * Only whole lines are written, and the buffer isn't null terminated.
+ *
+ * @param pdb the generator.
+ * @param buffer the output buffer.
+ * @param capacity the size of the buffer, at least SYNTHETIC_LINE_LENGTH.
+ * @return How many bytes were written, 0 once the file is done.
+ */
+size_t writeSyntheticLines(struct SyntheticPdb* pdb, char* buffer, size_t capacity);
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file threadPool.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the thread pool.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include "threadPool.h"
+
+
+/* --- Structs --- */
+
+/** The pool, tasks are kept in a FIFO linked list. */
+struct ThreadPool
+{
+	pthread_t* threads;
+	int numOfThreads;
+	struct PoolTask* head;
+	struct PoolTask* tail;
+	// tasks submitted and not finished yet
+	int pending;
+	int isStopping;
+	pthread_mutex_t lock;
+	pthread_cond_t hasTask;
+	pthread_cond_t allDone;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * The main loop of a worker thread.
+ *
+ * @param arg the pool.
+ * @return Always NULL.
+ */
+static void* workerMain(void* arg)
+{
+	struct ThreadPool* pool = arg;
+	struct PoolTask* task;
+
+	pthread_mutex_lock(&pool->lock);
+	while (1)
+	{
+		while (!pool->head && !pool->isStopping)
+		{
+			pthread_cond_wait(&pool->hasTask, &pool->lock);
+		}
+		if (!pool->head)
+		{
+			break;
+		}
+		task = pool->head;
+		pool->head = task->next;
+		if (!pool->head)
+		{
+			pool->tail = NULL;
+		}
+		pthread_mutex_unlock(&pool->lock);
+
+		task->function(task->arg);
+		free(task);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->pending--;
+		if (pool->pending == 0)
+		{
+			pthread_cond_broadcast(&pool->allDone);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+struct ThreadPool* threadPoolAlloc(int numOfThreads)
+{
+	struct ThreadPool* pool;
+	int i;
+
+	if (numOfThreads < 1)
+	{
+		return NULL;
+	}
+	pool = malloc(sizeof(struct ThreadPool));
+	if (!pool)
+	{
+		return NULL;
+	}
+	pool->threads = malloc(sizeof(pthread_t) * numOfThreads);
+	if (!pool->threads)
+	{
+		free(pool);
+		return NULL;
+	}
+	pool->numOfThreads = 0;
+	pool->head = NULL;
+	pool->tail = NULL;
+	pool->pending = 0;
+	pool->isStopping = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->hasTask, NULL);
+	pthread_cond_init(&pool->allDone, NULL);
+
+	for (i = 0; i < numOfThreads; i++)
+	{
+		if (pthread_create(&pool->threads[i], NULL, workerMain, pool) != 0)
+		{
+			freeThreadPool(&pool);
+			return NULL;
+		}
+		pool->numOfThreads++;
+	}
+	return pool;
+}
+
+void freeThreadPool(struct ThreadPool** pool)
+{
+	int i;
+
+	if (*pool == NULL)
+	{
+		return;
+	}
+	threadPoolWait(*pool);
+	pthread_mutex_lock(&(*pool)->lock);
+	(*pool)->isStopping = 1;
+	pthread_cond_broadcast(&(*pool)->hasTask);
+	pthread_mutex_unlock(&(*pool)->lock);
+	for (i = 0; i < (*pool)->numOfThreads; i++)
+	{
+		pthread_join((*pool)->threads[i], NULL);
+	}
+	pthread_mutex_destroy(&(*pool)->lock);
+	pthread_cond_destroy(&(*pool)->hasTask);
+	pthread_cond_destroy(&(*pool)->allDone);
+	free((*pool)->threads);
+	free(*pool);
+	*pool = NULL;
+}
+
+int threadPoolSize(struct ThreadPool* pool)
+{
+	return pool->numOfThreads;
+}
+
+int threadPoolSubmit(struct ThreadPool* pool, void (*function)(void* arg), void* arg)
+{
+	struct PoolTask* task = malloc(sizeof(struct PoolTask));
+	if (!task)
+	{
+		return -ENOMEM;
+	}
+	task->function = function;
+	task->arg = arg;
+	task->next = NULL;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->tail)
+	{
+		pool->tail->next = task;
+	}
+	else
+	{
+		pool->head = task;
+	}
+	pool->tail = task;
+	pool->pending++;
+	pthread_cond_signal(&pool->hasTask);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+void threadPoolWait(struct ThreadPool* pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0)
+	{
+		pthread_cond_wait(&pool->allDone, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file threadPool.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for a fixed size pool of worker threads.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+
+/* --- Structs --- */
+
+/** A task to run on the pool. */
+struct PoolTask
+{
+	void (*function)(void* arg);
+	void* arg;
+	struct PoolTask* next;
+};
+
+/** A pool of threads, opaque. */
+struct ThreadPool;
+
+
+/* --- Functions --- */
+
+/**
+ * Allocates a pool and starts its threads.
+ *
+ * @param numOfThreads how many threads to start, at least 1.
+ * @return The new pool, or NULL on error. Free with freeThreadPool.
+ */
+struct ThreadPool* threadPoolAlloc(int numOfThreads);
+
+/**
+ * Waits for all the tasks, stops the threads and frees the pool.
+ * Sets the pool to NULL.
+ *
+ * @param pool a pointer to the pool to free.
+ */
+void freeThreadPool(struct ThreadPool** pool);
+
+/**
+ * Gets the number of threads in the pool.
+ *
+ * @param pool the pool.
+ * @return The number of threads.
+ */
+int threadPoolSize(struct ThreadPool* pool);
+
+/**
+ * Adds a task to the pool's queue. Tasks start in the order they were added.
+ *
+ * @param pool the pool.
+ * @param function the function to run.
+ * @param arg the argument to pass to the function.
+ * @return 0 on success, an error code otherwise.
+ */
+int threadPoolSubmit(struct ThreadPool* pool, void (*function)(void* arg), void* arg);
+
+/**
+ * Waits until all the submitted tasks are done.
+ *
+ * @param pool the pool.
+ */
+void threadPoolWait(struct ThreadPool* pool);
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file tiledDistance.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the multithreaded maximum distance search.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "tiledDistance.h"
+
+
+/* --- Structs --- */
+
+/** A search shared by all the threads. */
+struct DistanceSearch
+{
+	const struct CoordKernels* kernels;
+	const float* x;
+	const float* y;
+	const float* z;
+	int numOfPoints;
+	int numOfTiles;
+	// the next tile to hand out, always nextRow <= nextColumn
+	int nextRow;
+	int nextColumn;
+	pthread_mutex_t lock;
+};
+
+/** The part of one thread in a search. */
+struct DistanceWorker
+{
+	struct DistanceSearch* search;
+	float maxDistance;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Takes the next tile of a search.
+ *
+ * @param search the search.
+ * @param row the output tile row.
+ * @param column the output tile column.
+ * @return 1 if a tile was taken, 0 if all the tiles were taken.
+ */
+static int takeTile(struct DistanceSearch* search, int* row, int* column)
+{
+	int isTaken = 0;
+
+	pthread_mutex_lock(&search->lock);
+	if (search->nextRow < search->numOfTiles)
+	{
+		*row = search->nextRow;
+		*column = search->nextColumn;
+		isTaken = 1;
+		search->nextColumn++;
+		if (search->nextColumn == search->numOfTiles)
+		{
+			search->nextRow++;
+			search->nextColumn = search->nextRow;
+		}
+	}
+	pthread_mutex_unlock(&search->lock);
+	return isTaken;
+}
+
+/**
+ * Runs tiles until there are no more, a pool task.
+ *
+ * @param arg the DistanceWorker of this thread.
+ */
+static void runDistanceWorker(void* arg)
+{
+	struct DistanceWorker* worker = arg;
+	struct DistanceSearch* search = worker->search;
+	int row, column;
+	int firstRow, lastRow, firstColumn, lastColumn;
+	float distance;
+
+	while (takeTile(search, &row, &column))
+	{
+		firstRow = row * DISTANCE_TILE_SIZE;
+		lastRow = firstRow + DISTANCE_TILE_SIZE < search->numOfPoints ?
+		          firstRow + DISTANCE_TILE_SIZE : search->numOfPoints;
+		firstColumn = column * DISTANCE_TILE_SIZE;
+		lastColumn = firstColumn + DISTANCE_TILE_SIZE < search->numOfPoints ?
+		             firstColumn + DISTANCE_TILE_SIZE : search->numOfPoints;
+		distance = search->kernels->maxSquaredDistance(search->x, search->y, search->z,
+		                                               firstRow, lastRow, firstColumn, lastColumn);
+		if (distance > worker->maxDistance)
+		{
+			worker->maxDistance = distance;
+		}
+	}
+}
+
+float tiledMaxSquaredDistance(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                              const float* x, const float* y, const float* z, int numOfPoints)
+{
+	struct DistanceSearch search;
+	struct DistanceWorker* workers;
+	int numOfWorkers;
+	float maxDistance = 0;
+	int i;
+
+	if (!pool || numOfPoints <= DISTANCE_TILE_SIZE)
+	{
+		return kernels->maxSquaredDistance(x, y, z, 0, numOfPoints, 0, numOfPoints);
+	}
+
+	numOfWorkers = threadPoolSize(pool);
+	workers = malloc(sizeof(struct DistanceWorker) * numOfWorkers);
+	if (!workers)
+	{
+		return kernels->maxSquaredDistance(x, y, z, 0, numOfPoints, 0, numOfPoints);
+	}
+
+	search.kernels = kernels;
+	search.x = x;
+	search.y = y;
+	search.z = z;
+	search.numOfPoints = numOfPoints;
+	search.numOfTiles = (numOfPoints + DISTANCE_TILE_SIZE - 1) / DISTANCE_TILE_SIZE;
+	search.nextRow = 0;
+	search.nextColumn = 0;
+	pthread_mutex_init(&search.lock, NULL);
+
+	for (i = 0; i < numOfWorkers; i++)
+	{
+		workers[i].search = &search;
+		workers[i].maxDistance = 0;
+		if (threadPoolSubmit(pool, runDistanceWorker, &workers[i]) != 0)
+		{
+			// no memory for the task, this thread takes its share instead
+			runDistanceWorker(&workers[i]);
+		}
+	}
+	threadPoolWait(pool);
+
+	for (i = 0; i < numOfWorkers; i++)
+	{
+		if (workers[i].maxDistance > maxDistance)
+		{
+			maxDistance = workers[i].maxDistance;
+		}
+	}
+	pthread_mutex_destroy(&search.lock);
+	free(workers);
+	return maxDistance;
+}
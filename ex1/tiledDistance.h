@@ -0,0 +1,43 @@
+/**
+ * @file tiledDistance.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the multithreaded maximum distance search.
+ */
+
+#ifndef TILED_DISTANCE_H
+#define TILED_DISTANCE_H
+
+
+/* --- Includes --- */
+
+#include "coordKernels.h"
+#include "threadPool.h"
+
+
+/* --- Constants --- */
+
+/** How many points are in each side of a tile, small enough for two tiles to stay in cache. */
+#define DISTANCE_TILE_SIZE 1024
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the maximum squared distance between all pairs of points.
+ * The i < j triangle of pairs is split into square tiles, that are handed
+ * to the pool's threads. Each thread keeps its own maximum, and the maximums
+ * are combined at the end, so the result is identical to the serial kernel.
+ *
+ * @param pool the pool to run on, NULL to run serially.
+ * @param kernels the kernels to calculate with.
+ * @param x the x coordinates.
+ * @param y the y coordinates.
+ * @param z the z coordinates.
+ * @param numOfPoints how many points there are.
+ * @return The maximum squared distance, 0 if there are less than 2 points.
+ */
+float tiledMaxSquaredDistance(struct ThreadPool* pool, const struct CoordKernels* kernels,
+                              const float* x, const float* y, const float* z, int numOfPoints);
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file trajectory.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the per model analysis.
+ */
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "trajectory.h"
+#include "pdbReader.h"
+
+
+/* --- Structs --- */
+
+/** The smallest, largest and mean of a value over the models. */
+struct ValueSummary
+{
+	double sum;
+	float min;
+	float max;
+	int minModel;
+	int maxModel;
+};
+
+/** The state of reading a trajectory, the context of its atom sink. */
+struct Trajectory
+{
+	const struct AnalysisOptions* options;
+	struct CoordStore* store;
+	struct CoordStore* hullStore;
+	int numOfModels;
+	struct ValueSummary turnRadius;
+	struct ValueSummary maxDistance;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Adds the value of a model to a summary.
+ *
+ * @param summary the summary.
+ * @param value the value.
+ * @param model the number of the model, 1 for the first.
+ */
+static void addToSummary(struct ValueSummary* summary, float value, int model)
+{
+	if (model == 1 || value < summary->min)
+	{
+		summary->min = value;
+		summary->minModel = model;
+	}
+	if (model == 1 || value > summary->max)
+	{
+		summary->max = value;
+		summary->maxModel = model;
+	}
+	summary->sum += value;
+}
+
+/**
+ * Prints a summary.
+ *
+ * @param name the name of the value.
+ * @param summary the summary.
+ * @param numOfModels how many models were summarized.
+ */
+static void printSummary(const char* name, const struct ValueSummary* summary, int numOfModels)
+{
+	printf("%s mean = %.3f, min = %.3f (model %d), max = %.3f (model %d)\n", name, summary->sum / numOfModels,
+	       summary->min, summary->minModel, summary->max, summary->maxModel);
+}
+
+/**
+ * Adds an atom to the current model, the addAtom of the trajectory sink.
+ *
+ * @param context the Trajectory.
+ * @param line the ATOM line.
+ * @param x the x coordinate.
+ * @param y the y coordinate.
+ * @param z the z coordinate.
+ * @return 0 on success, an error code otherwise.
+ */
+static int addModelAtom(void* context, const char* line, float x, float y, float z)
+{
+	struct Trajectory* trajectory = context;
+	int ret = appendCoord(trajectory->store, x, y, z);
+	(void) line;
+	if (ret < 0)
+	{
+		fprintf(stderr, "Not enough memory for %d atoms\n", trajectory->store->size + 1);
+	}
+	return ret;
+}
+
+/**
+ * Analyzes the current model and clears it, the endModel of the trajectory sink.
+ * Empty models are skipped.
+ *
+ * @param context the Trajectory.
+ * @return Always 0.
+ */
+static int endModel(void* context)
+{
+	struct Trajectory* trajectory = context;
+	struct ProteinStats stats;
+
+	if (trajectory->store->size == 0)
+	{
+		return 0;
+	}
+	trajectory->numOfModels++;
+	analyzeStore(trajectory->options, trajectory->store, trajectory->hullStore, &stats);
+	printf("Model %d, %d atoms: Cg = %.3f %.3f %.3f, Rg = %.3f, Dmax = %.3f\n", trajectory->numOfModels,
+	       stats.numOfAtoms, stats.centerOfGravity[X_POS], stats.centerOfGravity[Y_POS],
+	       stats.centerOfGravity[Z_POS], stats.turnRadius, stats.maxDistance);
+	addToSummary(&trajectory->turnRadius, stats.turnRadius, trajectory->numOfModels);
+	addToSummary(&trajectory->maxDistance, stats.maxDistance, trajectory->numOfModels);
+	clearCoordStore(trajectory->store);
+	return 0;
+}
+
+int analyzeTrajectory(const struct AnalysisOptions* options, const char* path,
+                      struct CoordStore* store, struct CoordStore* hullStore)
+{
+	FILE* file;
+	struct Trajectory trajectory;
+	struct AtomSink sink = {addModelAtom, endModel, &trajectory, 0};
+	long ret;
+
+	file = fopen(path, "r");
+	if(!file)
+	{
+		ret = errno;
+		fprintf(stderr, "Error opening file: %s\n", path);
+		return (int) ret;
+	}
+
+	memset(&trajectory, 0, sizeof(trajectory));
+	trajectory.options = options;
+	trajectory.store = store;
+	trajectory.hullStore = hullStore;
+	clearCoordStore(store);
+
+	ret = streamValues(file, &sink, stderr);
+	fclose(file);
+	if (ret < 0)
+	{
+		return (int) -ret;
+	}
+	// atoms after the last ENDMDL, or a file without models
+	endModel(&trajectory);
+	if (trajectory.numOfModels == 0)
+	{
+		fprintf(stderr, "Error - 0 atoms were found in the file %s\n", path);
+		return 1;
+	}
+
+	printf("PDB file %s, %d models, %ld atoms were read\n", path, trajectory.numOfModels, ret);
+	printSummary("Rg", &trajectory.turnRadius, trajectory.numOfModels);
+	printSummary("Dmax", &trajectory.maxDistance, trajectory.numOfModels);
+	return 0;
+}
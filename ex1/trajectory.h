@@ -0,0 +1,35 @@
+/**
+ * @file trajectory.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for analyzing pdb files with many models, such as NMR ensembles
+ * and molecular dynamics trajectories, one model at a time.
+ */
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+
+/* --- Includes --- */
+
+#include "AnalyzeProtein.h"
+#include "coordStore.h"
+
+
+/* --- Functions --- */
+
+/**
+ * Analyzes every model of a pdb file and prints its statistics, then
+ * prints a summary of all the models. Atoms outside of MODEL/ENDMDL blocks
+ * are taken as one more model. Only one model is kept in memory at a time.
+ *
+ * @param options how to calculate.
+ * @param path the path of the file.
+ * @param store a scratch store for the atoms of a model.
+ * @param hullStore a scratch store for the hull points.
+ * @return 0 on success, the exit code otherwise.
+ */
+int analyzeTrajectory(const struct AnalysisOptions* options, const char* path,
+                      struct CoordStore* store, struct CoordStore* hullStore);
+
+#endif
@@ -6,6 +6,8 @@
  * and gives them comparision score.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 
 /* --- Includes --- */
 
@@ -13,7 +15,17 @@
 #include <string.h>
 #include <stdlib.h>
 #include <libgen.h>
+#include <stdint.h>
+#include <limits.h>
 #include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include "CompareSequences.h"
+#include "editDistance.h"
+#include "pruning.h"
+#include "pairScheduler.h"
+#include "wavefront.h"
+#include "alignment.h"
 
 
 /* --- Constants --- */
@@ -24,50 +36,19 @@
 /** How a sequence name line starts. */
 #define SEQUENCE_NAME_LINE_START '>'
 
+/** The names of the paths. */
+static const char* const PATH_NAMES[NUM_OF_PATHS] = {"8-bit lanes", "16-bit lanes", "32-bit lanes", "scalar",
+                                                     "bit-parallel"};
 
-/* --- Structs --- */
+/** The alignment of the buffer, enough for every vector. */
+#define BUFFER_ALIGNMENT 64
 
-/** A single table cell. */
-struct Cell
-{
-	long value;
-	int isInitialized;
-};
-
-/** A sequence. */
-struct Sequence
-{
-	char* name;
-	char* sequence;
-};
+/** The largest number of threads. */
+#define MAX_THREADS 1024
 
 
 /* --- Functions --- */
 
-/**
- * Frees the given table with given number of rows.
- *
- * @param table The table to free.
- * @param rows How many rows are in the table.
- */
-void cleanupTable(struct Cell **table, size_t rows)
-{
-	size_t i;
-	if(!table)
-	{
-		// table isn't allocated
-		return;
-	}
-	for(i = 0; i < rows; i++)
-	{
-		if(table[i])
-		{
-			free(table[i]);
-		}
-	}
-	free(table);
-}
-
 /**
  * Frees all the sequences in the array.
  *
@@ -90,138 +71,349 @@ void cleanupSequences(struct Sequence* sequences, int numOfSequences)
 }
 
 /**
- * Creates an empty sequences table with given rows and columns.
+ * Defines a function that calculates the comparision score of two sequences
+ * in linear memory, with scores of the given integer type.
+ * Only one row of the table is kept. Every cell of it is overwritten by the
+ * cell below it, and the cell that was above and to the left of the current
+ * cell is kept aside. A cell needs only those two and the cell to its left.
  *
- * @param rows How many rows.
- * @param columns How many columns.
- * @return A pointer to the allocated table, needs to be free with cleanupTable.
+ * The defined function gets:
+ * str1 The first sequence, along the rows, the outer sequence.
+ * str1Len The length of the first sequence.
+ * str2 The second sequence, along the row, the inner sequence.
+ * str2Len The length of the second sequence.
+ * matchScore, mismatchScore, gapScore The scores, every score of the sequences must fit the type.
+ * edges The edges of the table, NULL if it's the whole table.
+ * buffer A buffer of at least str2Len + 1 values of the type.
+ * and returns the score.
  */
-struct Cell** createEmptyScoreTable(size_t rows, size_t columns)
+#define DEFINE_CALCULATE_SCORE(name, type) \
+long name(const char* str1, size_t str1Len, const char* str2, size_t str2Len, \
+          long matchScore, long mismatchScore, long gapScore, const struct TableEdges* edges, void* buffer) \
+{ \
+	type* row = buffer; \
+	type diagonal; \
+	type value; \
+	type gapValue; \
+	size_t i; \
+	size_t j; \
+\
+	for(j = 0; j <= str2Len; j++) \
+	{ \
+		row[j] = (type) (edges ? edges->top[j] : gapScore * (long) j); \
+	} \
+	for(i = 1; i <= str1Len; i++) \
+	{ \
+		diagonal = row[0]; \
+		row[0] = (type) (edges ? edges->left[i - 1] : gapScore * (long) i); \
+		for(j = 1; j <= str2Len; j++) \
+		{ \
+			if(str1[i - 1] == str2[j - 1]) \
+			{ \
+				value = (type) (diagonal + matchScore); \
+			} \
+			else \
+			{ \
+				value = (type) (diagonal + mismatchScore); \
+			} \
+			diagonal = row[j]; \
+			gapValue = (type) (row[j - 1] + gapScore); \
+			if(gapValue > value) \
+			{ \
+				value = gapValue; \
+			} \
+			gapValue = (type) (diagonal + gapScore); \
+			if(gapValue > value) \
+			{ \
+				value = gapValue; \
+			} \
+			row[j] = value; \
+		} \
+		if(edges) \
+		{ \
+			edges->right[i - 1] = row[str2Len]; \
+		} \
+	} \
+	for(j = 0; edges && j < str2Len; j++) \
+	{ \
+		edges->bottom[j] = row[j + 1]; \
+	} \
+	return row[str2Len]; \
+}
+
+DEFINE_CALCULATE_SCORE(calculateScoreShort, int16_t)
+DEFINE_CALCULATE_SCORE(calculateScoreInt, int32_t)
+DEFINE_CALCULATE_SCORE(calculateScoreLong, long)
+
+unsigned long getLargestScore(long matchScore, long mismatchScore, long gapScore)
 {
-	struct Cell** scoreTable;
-	size_t row;
-	size_t column;
-	scoreTable = malloc(sizeof(struct Cell*) * rows);
-	if(!scoreTable)
-	{
-		cleanupTable(scoreTable, rows);
-		return NULL;
-	}
-	for(row = 0; row < rows; row++)
+	long scores[] = {matchScore, mismatchScore, gapScore};
+	unsigned long largestScore = 0;
+	unsigned long score;
+	int i;
+
+	for(i = 0; i < 3; i++)
 	{
-		scoreTable[row] = malloc(sizeof(struct Cell) * columns);
-		if(!scoreTable[row])
+		// the magnitude of LONG_MIN doesn't fit a long
+		score = scores[i] < 0 ? 0UL - (unsigned long) scores[i] : (unsigned long) scores[i];
+		if(score > largestScore)
 		{
-			cleanupTable(scoreTable, rows);
-			return NULL;
-		}
-		for(column = 0; column < columns; column++)
-		{
-			scoreTable[row][column].isInitialized = 0;
+			largestScore = score;
 		}
 	}
-	return scoreTable;
+	return largestScore;
 }
 
-/**
- * Initializes the given table with starting values.
- *
- * @param gapScore The gap score, used to initialize the cells.
- * @param table The table to initialize.
- * @param rows How many rows are in the table.
- * @param columns How many columns are in the table.
- */
-void initializeTable(long gapScore, struct Cell** table, size_t rows, size_t columns)
+size_t selectScoreSize(size_t lengths, long matchScore, long mismatchScore, long gapScore)
 {
-	size_t i;
-	for(i = 0; i < rows; i++)
+	unsigned long largestScore = getLargestScore(matchScore, mismatchScore, gapScore);
+
+	if(largestScore == 0 || lengths + 1 <= INT16_MAX / largestScore)
 	{
-		table[i][0].value = gapScore * i;
-		table[i][0].isInitialized = 1;
+		return sizeof(int16_t);
 	}
-	for(i = 1; i < columns; i++)
+	if(lengths + 1 <= INT32_MAX / largestScore)
 	{
-		table[0][i].value = gapScore * i;
-		table[0][i].isInitialized = 1;
+		return sizeof(int32_t);
 	}
+	return sizeof(long);
 }
 
-/**
- * Calculates the sequences comparision value.
- * Fills up the table with the results.
- *
- * @param str1 The first sequence.
- * @param str2  The second sequence.
- * @param table The values table.
- * @param str1Index What index are we calculating in the first string.
- * @param str2Index What index are we calculating in the second string.
- * @param matchScore The match score.
- * @param mismatchScore The mismatch score.
- * @param gapScore The gape score.
- */
-void calculateValue(char* str1, char* str2, struct Cell** table,
-                    size_t str1Index, size_t str2Index, long matchScore, long mismatchScore, long gapScore)
+long calculateScalarScore(size_t scoreSize, const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                          long matchScore, long mismatchScore, long gapScore, const struct TableEdges* edges,
+                          void* buffer)
 {
-	long matchValue;
-	long firstStrGapValue;
-	long secondStrGapValue;
+	if(scoreSize == sizeof(int16_t))
+	{
+		return calculateScoreShort(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, edges, buffer);
+	}
+	if(scoreSize == sizeof(int32_t))
+	{
+		return calculateScoreInt(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, edges, buffer);
+	}
+	return calculateScoreLong(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, edges, buffer);
+}
 
-	// Those vars are necessary because the table has another row and column
-	size_t tableRow = str1Index + 1;
-	size_t tableColumn = str2Index + 1;
+double getSeconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + now.tv_nsec / 1e9;
+}
 
-	if(table[tableRow][tableColumn].isInitialized)
+void* reserveBuffer(struct ScoreContext* context, size_t size)
+{
+	if(size <= context->bufferSize)
 	{
-		return;
+		return context->buffer;
 	}
+	free(context->buffer);
+	context->bufferSize = 0;
+	if(posix_memalign(&context->buffer, BUFFER_ALIGNMENT, size) != 0)
+	{
+		context->buffer = NULL;
+		return NULL;
+	}
+	context->bufferSize = size;
+	return context->buffer;
+}
 
-	// string indexes at this point are always larger than 0,
-	// because we assume the table is initialized by initializeTable
-
-	calculateValue(str1, str2, table, str1Index - 1, str2Index - 1, matchScore, mismatchScore, gapScore);
-	calculateValue(str1, str2, table, str1Index, str2Index - 1, matchScore, mismatchScore, gapScore);
-	calculateValue(str1, str2, table, str1Index - 1, str2Index, matchScore, mismatchScore, gapScore);
+int mapLetters(const char* sequence, size_t length, unsigned char letters[UCHAR_MAX + 1])
+{
+	int numOfLetters = 1;
+	size_t i;
 
-	matchValue = table[tableRow - 1][tableColumn - 1].value;
-	if(str1[str1Index] == str2[str2Index])
+	memset(letters, 0, UCHAR_MAX + 1);
+	for(i = 0; i < length; i++)
 	{
-		matchValue += matchScore;
+		if(!letters[(unsigned char) sequence[i]])
+		{
+			letters[(unsigned char) sequence[i]] = (unsigned char) numOfLetters++;
+		}
 	}
-	else
+	return numOfLetters;
+}
+
+void initScoreContext(struct ScoreContext* context, const struct StripedEngine* engine, int measure)
+{
+	memset(context, 0, sizeof(struct ScoreContext));
+	context->engine = engine;
+	context->measure = measure;
+}
+
+void cleanupScoreContext(struct ScoreContext* context)
+{
+	free(context->buffer);
+	context->buffer = NULL;
+	context->bufferSize = 0;
+}
+
+int calculateScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                   long matchScore, long mismatchScore, long gapScore, struct ScoreContext* context, long* score)
+{
+	unsigned long largestScore;
+	struct PathStats* path;
+	size_t scoreSize;
+	size_t distance;
+	long editScore;
+	void* buffer;
+	double start = 0;
+	int width;
+	int ret;
+
+	if(str2Len > str1Len)
 	{
-		matchValue += mismatchScore;
+		// the score doesn't depend on the order of the sequences
+		return calculateScore(str2, str2Len, str1, str1Len, matchScore, mismatchScore, gapScore, context, score);
 	}
 
-	firstStrGapValue = table[tableRow][tableColumn - 1].value + gapScore;
-	secondStrGapValue = table[tableRow - 1][tableColumn].value + gapScore;
+	if(isEditDistanceScore(str1Len + str2Len, matchScore, mismatchScore, gapScore, &editScore))
+	{
+		if(context->measure)
+		{
+			start = getSeconds();
+		}
+		distance = 0;
+		if(editScore > 0)
+		{
+			ret = calculateEditDistance(str2, str2Len, str1, str1Len, context, &distance);
+			if(ret < 0)
+			{
+				return ret;
+			}
+		}
+		*score = (editScore + gapScore) * (long) (str1Len + str2Len) - editScore * (long) distance;
+		path = &context->paths[PATH_BIT_PARALLEL];
+		if(context->measure)
+		{
+			path->seconds += getSeconds() - start;
+		}
+		path->numOfPairs++;
+		path->numOfCells += (double) str1Len * (double) str2Len;
+		return 0;
+	}
 
-	if(matchValue > firstStrGapValue)
+	largestScore = getLargestScore(matchScore, mismatchScore, gapScore);
+	for(width = 0; width < NUM_OF_STRIPED_WIDTHS && str2Len > 0; width++)
 	{
-		if(matchValue > secondStrGapValue)
+		if(!context->engine->kernels[width] || !fitsLanes(width, str2Len, str1Len, largestScore))
 		{
-			// matchValue > firstStrGapValue, secondStrGapValue
-			table[tableRow][tableColumn].value = matchValue;
+			continue;
 		}
-		else
+		if(context->measure)
+		{
+			start = getSeconds();
+		}
+		ret = context->engine->kernels[width](str2, str2Len, str1, str1Len, matchScore, mismatchScore, gapScore,
+		                                      NULL, context, score);
+		if(ret < 0)
+		{
+			return ret;
+		}
+		path = &context->paths[width];
+		if(context->measure)
+		{
+			if(ret == STRIPED_OVERFLOW)
+			{
+				path->overflowSeconds += getSeconds() - start;
+			}
+			else
+			{
+				path->seconds += getSeconds() - start;
+			}
+		}
+		if(ret == STRIPED_OVERFLOW)
 		{
-			// secondStrGapValue > matchValue > firstStrGapValue
-			table[tableRow][tableColumn].value = secondStrGapValue;
+			path->numOfOverflows++;
+			continue;
 		}
+		path->numOfPairs++;
+		path->numOfCells += (double) str1Len * (double) str2Len;
+		return 0;
 	}
-	else
+
+	buffer = reserveBuffer(context, sizeof(long) * (str2Len + 1));
+	if(!buffer)
+	{
+		return -ENOMEM;
+	}
+	if(context->measure)
+	{
+		start = getSeconds();
+	}
+	scoreSize = selectScoreSize(str1Len + str2Len, matchScore, mismatchScore, gapScore);
+	*score = calculateScalarScore(scoreSize, str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore,
+	                              NULL, buffer);
+	path = &context->paths[PATH_SCALAR];
+	if(context->measure)
+	{
+		path->seconds += getSeconds() - start;
+	}
+	path->numOfPairs++;
+	path->numOfCells += (double) str1Len * (double) str2Len;
+	return 0;
+}
+
+/**
+ * Prints how fast every path of a context calculated, in billions of cells per second.
+ *
+ * @param context The context.
+ * @param output The stream to print to.
+ */
+void printPathStats(const struct ScoreContext* context, FILE* output)
+{
+	const struct PathStats* path;
+	int i;
+
+	fprintf(output, "Engine %s:\n", context->engine->name);
+	for(i = 0; i < NUM_OF_PATHS; i++)
 	{
-		if (firstStrGapValue > secondStrGapValue)
+		path = &context->paths[i];
+		if(path->numOfPairs == 0 && path->numOfOverflows == 0)
 		{
-			// firstStrGapValue > matchValue, secondStrGapValue
-			table[tableRow][tableColumn].value = firstStrGapValue;
+			continue;
 		}
-		else
+		fprintf(output, "  %s: %ld pairs, %.0f cells, %.6f seconds, %.3f GCUPS", PATH_NAMES[i], path->numOfPairs,
+		        path->numOfCells, path->seconds, path->seconds > 0 ? path->numOfCells / path->seconds / 1e9 : 0.0);
+		if(path->numOfOverflows > 0)
 		{
-			// secondStrGapValue > firstStrGapValue > secondStrGapValue
-			table[tableRow][tableColumn].value = secondStrGapValue;
+			fprintf(output, ", %ld overflowed in %.6f seconds", path->numOfOverflows, path->overflowSeconds);
 		}
+		fprintf(output, "\n");
 	}
-	table[tableRow][tableColumn].isInitialized = 1;
+}
+
+void addPathStats(struct ScoreContext* context, const struct ScoreContext* other)
+{
+	int i;
+
+	for(i = 0; i < NUM_OF_PATHS; i++)
+	{
+		context->paths[i].numOfPairs += other->paths[i].numOfPairs;
+		context->paths[i].numOfCells += other->paths[i].numOfCells;
+		context->paths[i].seconds += other->paths[i].seconds;
+		context->paths[i].numOfOverflows += other->paths[i].numOfOverflows;
+		context->paths[i].overflowSeconds += other->paths[i].overflowSeconds;
+	}
+	context->pruningStats.numOfPairs += other->pruningStats.numOfPairs;
+	context->pruningStats.numOfCells += other->pruningStats.numOfCells;
+	context->pruningStats.numOfTableCells += other->pruningStats.numOfTableCells;
+	context->pruningStats.numOfWidenings += other->pruningStats.numOfWidenings;
+	context->pruningStats.numOfFallbacks += other->pruningStats.numOfFallbacks;
+}
+
+/**
+ * Sets the letters of a sequence. A name line with no lines after it is an empty sequence.
+ * @param sequence The sequence.
+ * @param sequenceString The letters that were read, NULL if there were none.
+ *			The sequence keeps it.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int setSequenceString(struct Sequence* sequence, char* sequenceString)
+{
+	sequence->sequence = sequenceString ? sequenceString : calloc(1, 1);
+	return sequence->sequence ? 0 : -ENOMEM;
 }
 
 /**
@@ -240,6 +432,10 @@ int readSequences(FILE* file, struct Sequence** sequencesPtr)
 	char *newlineIndex;
 	char* sequenceString = NULL;
 	char* newSequenceString = NULL;
+	// the sequence is kept with its length and capacity, so a line is appended in its own length
+	size_t sequenceLength = 0;
+	size_t sequenceSize = 0;
+	size_t lineLength;
 
 	numOfSequences = 0;
 	while(fgets(line, MAX_LINE_SIZE, file) != NULL)
@@ -252,9 +448,11 @@ int readSequences(FILE* file, struct Sequence** sequencesPtr)
 		{
 			if (numOfSequences > 0)
 			{
-				sequences[numOfSequences - 1].sequence = malloc(strlen(sequenceString) + 1);
-				strcpy(sequences[numOfSequences - 1].sequence, sequenceString);
-				free(sequenceString);
+				if(setSequenceString(&sequences[numOfSequences - 1], sequenceString) != 0)
+				{
+					cleanupSequences(sequences, numOfSequences);
+					return -ENOMEM;
+				}
 				newSequences = realloc(sequences, sizeof(struct Sequence) * (numOfSequences + 1));
 				if (!newSequences)
 				{
@@ -265,12 +463,15 @@ int readSequences(FILE* file, struct Sequence** sequencesPtr)
 			}
 			else
 			{
+				// the lines before the first name aren't of any sequence
+				free(sequenceString);
 				sequences = malloc(sizeof(struct Sequence));
 				if(!sequences)
 				{
 					return -ENOMEM;
 				}
 			}
+			sequences[numOfSequences].sequence = NULL;
 			sequences[numOfSequences].name = malloc(strlen(line) + 1);
 			strcpy(sequences[numOfSequences].name, line + 1);
 			numOfSequences++;
@@ -281,18 +482,15 @@ int readSequences(FILE* file, struct Sequence** sequencesPtr)
 		{
 			if (!sequenceString)
 			{
-				sequenceString = malloc(strlen(line) + 1);
-				if(!sequenceString)
-				{
-					cleanupSequences(sequences, numOfSequences);
-					return -ENOMEM;
-				}
-				strcpy(sequenceString, line);
-
+				sequenceLength = 0;
+				sequenceSize = 0;
 			}
-			else
+			lineLength = strlen(line);
+			if (sequenceLength + lineLength + 1 > sequenceSize)
 			{
-				newSequenceString = realloc(sequenceString, strlen(sequenceString) + strlen(line) + 1);
+				sequenceSize = 2 * sequenceSize > sequenceLength + lineLength + 1 ?
+				               2 * sequenceSize : sequenceLength + lineLength + 1;
+				newSequenceString = realloc(sequenceString, sequenceSize);
 				if(!newSequenceString)
 				{
 					free(sequenceString);
@@ -300,18 +498,22 @@ int readSequences(FILE* file, struct Sequence** sequencesPtr)
 					return -ENOMEM;
 				}
 				sequenceString = newSequenceString;
-				strcat(sequenceString, line);
 			}
+			memcpy(sequenceString + sequenceLength, line, lineLength + 1);
+			sequenceLength += lineLength;
 		}
 	}
 	if(!sequences)
 	{
+		free(sequenceString);
 		*sequencesPtr = NULL;
 		return 0;
 	}
-	sequences[numOfSequences - 1].sequence = malloc(strlen(sequenceString) + 1);
-	strcpy(sequences[numOfSequences - 1].sequence, sequenceString);
-	free(sequenceString);
+	if(setSequenceString(&sequences[numOfSequences - 1], sequenceString) != 0)
+	{
+		cleanupSequences(sequences, numOfSequences);
+		return -ENOMEM;
+	}
 	*sequencesPtr = sequences;
 	return numOfSequences;
 }
@@ -335,6 +537,205 @@ long parseValue(char* arg)
 	return value;
 }
 
+/**
+ * Prints the score and an optimal alignment of every pair of sequences, one pair after the other.
+ * The score is the score of the alignment, the same one printScores prints.
+ *
+ * @param sequences The sequences.
+ * @param lengths The lengths of the sequences.
+ * @param numOfSequences How many sequences there are.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param numOfThreads How many threads to align every pair on.
+ * @param format How to print the alignments, an ALIGNMENT_FORMAT constant.
+ * @param context How to calculate.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int printAlignments(const struct Sequence* sequences, const size_t* lengths, int numOfSequences,
+                    long matchScore, long mismatchScore, long gapScore, int numOfThreads, int format,
+                    struct ScoreContext* context)
+{
+	char* operations;
+	size_t numOfOperations;
+	int ret;
+	int i, j;
+
+	for(i = 0; i < numOfSequences; i++)
+	{
+		for(j = i + 1; j < numOfSequences; j++)
+		{
+			operations = malloc(lengths[i] + lengths[j] + 1);
+			if(!operations)
+			{
+				return -ENOMEM;
+			}
+			ret = alignSequences(sequences[i].sequence, lengths[i], sequences[j].sequence, lengths[j], matchScore,
+			                     mismatchScore, gapScore, numOfThreads, context, operations, &numOfOperations);
+			if(ret < 0)
+			{
+				free(operations);
+				return ret;
+			}
+			printf("Score for alignment of %s to %s is %ld\n", sequences[i].name, sequences[j].name,
+			       scoreAlignment(operations, numOfOperations, matchScore, mismatchScore, gapScore));
+			if(format == ALIGNMENT_FORMAT_CIGAR)
+			{
+				printCigar(operations, numOfOperations, stdout);
+			}
+			else
+			{
+				printGappedAlignment(sequences[i].sequence, sequences[j].sequence, operations, numOfOperations,
+				                     stdout);
+			}
+			free(operations);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Prints the score of every pair of sequences, calculating them one after the other.
+ * With several threads, every pair is calculated by all of them, see
+ * calculateWavefront, unless the tables are pruned, see calculatePrunedScore.
+ *
+ * @param sequences The sequences.
+ * @param lengths The lengths of the sequences.
+ * @param numOfSequences How many sequences there are.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param numOfThreads How many threads to calculate on.
+ * @param context How to calculate, receives the paths.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int printScores(const struct Sequence* sequences, const size_t* lengths, int numOfSequences,
+                long matchScore, long mismatchScore, long gapScore, int numOfThreads, struct ScoreContext* context)
+{
+	long score;
+	int ret;
+	int i, j;
+
+	for(i = 0; i < numOfSequences; i++)
+	{
+		for(j = i + 1; j < numOfSequences; j++)
+		{
+			if(numOfThreads > 1 && context->pruning == PRUNING_NONE)
+			{
+				ret = calculateWavefront(sequences[i].sequence, lengths[i], sequences[j].sequence, lengths[j],
+				                         matchScore, mismatchScore, gapScore, numOfThreads, context, &score);
+			}
+			else
+			{
+				ret = calculatePrunedScore(sequences[i].sequence, lengths[i], sequences[j].sequence, lengths[j],
+				                           matchScore, mismatchScore, gapScore, context, &score);
+			}
+			if(ret < 0)
+			{
+				return ret;
+			}
+			printf("Score for alignment of %s to %s is %ld\n", sequences[i].name, sequences[j].name, score);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Prints the score of every pair of sequences in the same order printScores
+ * does, calculating them on several threads first.
+ *
+ * @param sequences The sequences.
+ * @param lengths The lengths of the sequences.
+ * @param numOfSequences How many sequences there are.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param numOfThreads How many threads to calculate on.
+ * @param context How to calculate, receives the paths of all the threads.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int printScoresParallel(const struct Sequence* sequences, const size_t* lengths, int numOfSequences,
+                        long matchScore, long mismatchScore, long gapScore, int numOfThreads,
+                        struct ScoreContext* context)
+{
+	struct Pair* pairs;
+	size_t numOfPairs = (size_t) numOfSequences * (numOfSequences - 1) / 2;
+	size_t pairIndex;
+	int ret = 0;
+
+	if(calculateAllPairs(sequences, lengths, numOfSequences, matchScore, mismatchScore, gapScore, context->engine,
+	                     numOfThreads, context, &pairs) != 0)
+	{
+		return -ENOMEM;
+	}
+	for(pairIndex = 0; pairIndex < numOfPairs; pairIndex++)
+	{
+		if(pairs[pairIndex].ret < 0)
+		{
+			ret = pairs[pairIndex].ret;
+			break;
+		}
+		printf("Score for alignment of %s to %s is %ld\n", sequences[pairs[pairIndex].first].name,
+		       sequences[pairs[pairIndex].second].name, pairs[pairIndex].score);
+	}
+	free(pairs);
+	return ret;
+}
+
+/**
+ * Prints the usage message and exits.
+ *
+ * @param programPath the path of the program, argv[0].
+ */
+void printUsage(char* programPath)
+{
+	fprintf(stderr, "Usage: %s [-j threads] [--engine=%s|%s|%s|%s] [--gcups] "
+	        "[--band k | --xdrop x | --align[=text|cigar]] <path_to_sequences_file> <m> <s> <g>\n",
+	        basename(programPath), ENGINE_AVX512, ENGINE_AVX2, ENGINE_SSE41, ENGINE_SCALAR);
+	exit(1);
+}
+
+/**
+ * Parses a number of threads argument.
+ *
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The number of threads. Exits on invalid arguments.
+ */
+int parseThreads(char* arg, char* programPath)
+{
+	char* endPtr;
+	long numOfThreads;
+
+	numOfThreads = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || numOfThreads < 1 || numOfThreads > MAX_THREADS)
+	{
+		printUsage(programPath);
+	}
+	return (int) numOfThreads;
+}
+
+/**
+ * Parses the band or the drop argument of a pruned table.
+ *
+ * @param arg the argument.
+ * @param programPath the path of the program, for the usage message.
+ * @return The limit, at least 0. Exits on invalid arguments.
+ */
+long parseLimit(char* arg, char* programPath)
+{
+	char* endPtr;
+	long limit;
+
+	errno = 0;
+	limit = strtol(arg, &endPtr, 10);
+	if (endPtr == arg || *endPtr != '\0' || limit < 0 || errno)
+	{
+		printUsage(programPath);
+	}
+	return limit;
+}
+
 /**
  * The main function.
  *
@@ -343,54 +744,103 @@ long parseValue(char* arg)
  * @return 0 in a succesful execution, 1 in case of file error,
  *		other in case of a different error.
  */
-int main(int argc, char *argv[]) 
+int main(int argc, char *argv[])
 {
 	FILE* file;
 	struct Sequence* sequences;
 	int numOfSequences;
 
-	char* str1;
-	char* str2;
+	size_t* lengths;
 
 	long matchScore;
 	long mismatchScore;
 	long gapScore;
 
-	size_t str1Len;
-	size_t str2Len;
-
-	size_t rows;
-	size_t columns;
-
-	struct Cell** scoreTable;
-
-	int i, j;
+	const struct StripedEngine* engine = selectEngine();
+	struct ScoreContext context;
+	int numOfThreads = 1;
+	int isGcups = 0;
+	int alignmentFormat = ALIGNMENT_FORMAT_NONE;
+	int pruning = PRUNING_NONE;
+	long pruningLimit = 0;
+	int option;
+	static struct option longOptions[] = {
+		{"engine", required_argument, NULL, 'e'},
+		{"gcups", no_argument, NULL, 'G'},
+		{"threads", required_argument, NULL, 'j'},
+		{"align", optional_argument, NULL, 'a'},
+		{"band", required_argument, NULL, 'b'},
+		{"xdrop", required_argument, NULL, 'x'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int ret;
+	int i;
 
-	if (argc != 5)
+	// the scores may be negative, so the options end at the first argument that isn't one
+	while ((option = getopt_long(argc, argv, "+j:", longOptions, NULL)) != -1)
 	{
-		fprintf(stderr, "Usage: %s <path_to_sequences_file> <m> <s> <g>\n", basename(argv[0]));
-		exit(1);
+		if (option == 'e' && findEngine(optarg) != NULL)
+		{
+			engine = findEngine(optarg);
+		}
+		else if (option == 'G')
+		{
+			isGcups = 1;
+		}
+		else if (option == 'j')
+		{
+			numOfThreads = parseThreads(optarg, argv[0]);
+		}
+		else if (option == 'a' && (!optarg || strcmp(optarg, "text") == 0))
+		{
+			alignmentFormat = ALIGNMENT_FORMAT_TEXT;
+		}
+		else if (option == 'a' && strcmp(optarg, "cigar") == 0)
+		{
+			alignmentFormat = ALIGNMENT_FORMAT_CIGAR;
+		}
+		else if (option == 'b' && pruning == PRUNING_NONE)
+		{
+			pruning = PRUNING_BAND;
+			pruningLimit = parseLimit(optarg, argv[0]);
+		}
+		else if (option == 'x' && pruning == PRUNING_NONE)
+		{
+			pruning = PRUNING_X_DROP;
+			pruningLimit = parseLimit(optarg, argv[0]);
+		}
+		else
+		{
+			printUsage(argv[0]);
+		}
 	}
 
-	file = fopen(argv[1], "r");
+	// the alignments take their own time, apart from the paths of the scores, on the whole table
+	if (argc - optind != 4 ||
+	    ((isGcups || pruning != PRUNING_NONE) && alignmentFormat != ALIGNMENT_FORMAT_NONE))
+	{
+		printUsage(argv[0]);
+	}
+	file = fopen(argv[optind], "r");
 
 	if(!file)
 	{
-		fprintf(stderr, "ERROR opening file: %s\n", argv[1]);
+		fprintf(stderr, "ERROR opening file: %s\n", argv[optind]);
 		return errno;
 	}
 
-	matchScore = parseValue(argv[2]);
+	matchScore = parseValue(argv[optind + 1]);
 	if (errno)
 	{
 		return errno;
 	}
-	mismatchScore = parseValue(argv[3]);
+	mismatchScore = parseValue(argv[optind + 2]);
 	if (errno)
 	{
 		return errno;
 	}
-	gapScore = parseValue(argv[4]);
+	gapScore = parseValue(argv[optind + 3]);
 	if (errno)
 	{
 		return errno;
@@ -406,34 +856,54 @@ int main(int argc, char *argv[])
 		return -numOfSequences;
 	}
 
+	lengths = malloc(sizeof(size_t) * (numOfSequences + 1));
+	if(!lengths)
+	{
+		fprintf(stderr, "ERROR while creating table\n");
+		cleanupSequences(sequences, numOfSequences);
+		return 1;
+	}
 	for(i = 0; i < numOfSequences; i++)
 	{
-		for(j = i + 1; j < numOfSequences; j++)
-		{
-			str1 = sequences[i].sequence;
-			str2 = sequences[j].sequence;
-
-			str1Len = strlen(str1);
-			str2Len = strlen(str2);
-			rows = str1Len + 1;
-			columns = str2Len + 1;
-
-			scoreTable = createEmptyScoreTable(rows, columns);
-
-			if(!scoreTable)
-			{
-				fprintf(stderr, "ERROR while creating table\n");
-				return 1;
-			}
-			initializeTable(gapScore, scoreTable, rows, columns);
-
-			calculateValue(str1, str2, scoreTable, str1Len - 1, str2Len - 1, matchScore, mismatchScore, gapScore);
-
-			printf("Score for alignment of %s to %s is %ld\n",
-					sequences[i].name, sequences[j].name, scoreTable[str1Len][str2Len].value);
+		lengths[i] = strlen(sequences[i].sequence);
+	}
 
-			cleanupTable(scoreTable, rows);
+	initScoreContext(&context, engine, isGcups);
+	context.pruning = pruning;
+	context.pruningLimit = pruningLimit;
+	if(alignmentFormat != ALIGNMENT_FORMAT_NONE)
+	{
+		ret = printAlignments(sequences, lengths, numOfSequences, matchScore, mismatchScore, gapScore, numOfThreads,
+		                      alignmentFormat, &context);
+	}
+	else if(numOfThreads > 1 && (size_t) numOfSequences * (numOfSequences - 1) / 2 >= (size_t) numOfThreads)
+	{
+		// with fewer pairs than threads, the threads are better spent inside the pairs
+		ret = printScoresParallel(sequences, lengths, numOfSequences, matchScore, mismatchScore, gapScore,
+		                          numOfThreads, &context);
+	}
+	else
+	{
+		ret = printScores(sequences, lengths, numOfSequences, matchScore, mismatchScore, gapScore, numOfThreads,
+		                  &context);
+	}
+	if(ret < 0)
+	{
+		fprintf(stderr, "ERROR while creating table\n");
+	}
+	else
+	{
+		if(isGcups)
+		{
+			printPathStats(&context, stderr);
+		}
+		if(pruning != PRUNING_NONE)
+		{
+			printPruningStats(&context, stderr);
 		}
 	}
+	cleanupScoreContext(&context);
+	free(lengths);
 	cleanupSequences(sequences, numOfSequences);
+	return ret < 0 ? 1 : 0;
 }
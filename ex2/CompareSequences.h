@@ -0,0 +1,212 @@
+/**
+ * @file CompareSequences.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Shared definitions for the sequence comparison program.
+ */
+
+#ifndef COMPARE_SEQUENCES_H
+#define COMPARE_SEQUENCES_H
+
+
+/* --- Includes --- */
+
+#include <stddef.h>
+#include <limits.h>
+#include "stripedKernels.h"
+
+
+/* --- Constants --- */
+
+/** The paths a score is calculated on, the lane widths, the scalar kernels and the edit distance. */
+#define PATH_SCALAR NUM_OF_STRIPED_WIDTHS
+#define PATH_BIT_PARALLEL (NUM_OF_STRIPED_WIDTHS + 1)
+#define NUM_OF_PATHS (NUM_OF_STRIPED_WIDTHS + 2)
+
+
+/* --- Structs --- */
+
+/** A sequence. */
+struct Sequence
+{
+	char* name;
+	char* sequence;
+};
+
+/**
+ * The edges of a part of the table, when it is calculated apart from the rest.
+ * The rows of the part are the letters of the outer sequence, and the columns
+ * are the letters of the inner sequence, see the kernels.
+ */
+struct TableEdges
+{
+	// the cells above the part, from the one above its first column on the left
+	const long* top;
+	// the cells to the left of the part, one per row
+	const long* left;
+	// the output last row, one cell per column
+	long* bottom;
+	// the output last column, one cell per row, may be the same as left
+	long* right;
+};
+
+/** The pairs calculated on a path. */
+struct PathStats
+{
+	long numOfPairs;
+	double numOfCells;
+	double seconds;
+	// pairs that didn't fit the lanes, and were calculated again on a wider path
+	long numOfOverflows;
+	double overflowSeconds;
+};
+
+/** The pairs calculated on a pruned table. */
+struct PruningStats
+{
+	long numOfPairs;
+	// the cells calculated, and the cells of the whole tables of the pairs
+	double numOfCells;
+	double numOfTableCells;
+	// tries whose score couldn't be proven, and were tried again with a wider limit
+	long numOfWidenings;
+	// pairs calculated on the whole table in the end
+	long numOfFallbacks;
+};
+
+/** How the scores are calculated, and the memory they are calculated in. */
+struct ScoreContext
+{
+	const struct StripedEngine* engine;
+	// reused by every pair, aligned to BUFFER_ALIGNMENT
+	void* buffer;
+	size_t bufferSize;
+	// 1 to time the paths
+	int measure;
+	struct PathStats paths[NUM_OF_PATHS];
+	// a PRUNING constant, and the band or the drop it starts with
+	int pruning;
+	long pruningLimit;
+	struct PruningStats pruningStats;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Finds the largest magnitude of the scores.
+ *
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @return The largest magnitude.
+ */
+unsigned long getLargestScore(long matchScore, long mismatchScore, long gapScore);
+
+/**
+ * Finds the narrowest score type that holds every score of two sequences.
+ * A cell is the sum of at most str1Len + str2Len scores, and a candidate
+ * for it adds one more score, so the largest score times that many is enough.
+ *
+ * @param lengths The sum of the lengths of the sequences.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @return The size of the type, sizeof(int16_t), sizeof(int32_t) or sizeof(long).
+ */
+size_t selectScoreSize(size_t lengths, long matchScore, long mismatchScore, long gapScore);
+
+/**
+ * Calculates the comparision score of two sequences with the scalar kernel of a score type.
+ *
+ * @param scoreSize The size of the score type, see selectScoreSize.
+ * @param str1 The outer sequence.
+ * @param str1Len The length of the outer sequence.
+ * @param str2 The inner sequence.
+ * @param str2Len The length of the inner sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param edges The edges of the table, NULL if it's the whole table.
+ * @param buffer A buffer of at least one long more than the inner sequence.
+ * @return The score.
+ */
+long calculateScalarScore(size_t scoreSize, const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                          long matchScore, long mismatchScore, long gapScore, const struct TableEdges* edges,
+                          void* buffer);
+
+/**
+ * Gets the current time.
+ *
+ * @return The seconds since some fixed point.
+ */
+double getSeconds(void);
+
+/**
+ * Gets a buffer of the context that is at least the given size.
+ * The buffer is aligned for every vector type, and is kept for the next pair.
+ *
+ * @param context The context.
+ * @param size The size needed.
+ * @return The buffer, or NULL if there's no memory.
+ */
+void* reserveBuffer(struct ScoreContext* context, size_t size);
+
+/**
+ * Numbers the different letters of a sequence from 1. Every other letter is 0.
+ *
+ * @param sequence The sequence.
+ * @param length The length of the sequence.
+ * @param letters The output number of every letter.
+ * @return How many numbers were given, counting 0.
+ */
+int mapLetters(const char* sequence, size_t length, unsigned char letters[UCHAR_MAX + 1]);
+
+/**
+ * Initializes a score context.
+ *
+ * @param context The context to initialize. Free with cleanupScoreContext.
+ * @param engine The engine to calculate with.
+ * @param measure 1 to time the paths, 0 otherwise.
+ */
+void initScoreContext(struct ScoreContext* context, const struct StripedEngine* engine, int measure);
+
+/**
+ * Frees the memory of a score context.
+ *
+ * @param context The context.
+ */
+void cleanupScoreContext(struct ScoreContext* context);
+
+/**
+ * Calculates the comparision score of two sequences in linear memory.
+ * If the scores are like the edit distance, the edit distance is calculated
+ * instead, see isEditDistanceScore. Otherwise the shorter sequence is the
+ * query of the striped kernels, from the narrowest lanes that hold the
+ * scores. If the scores overflow the lanes, the next wider lanes are tried,
+ * and the scalar kernels after the widest. The scalar kernels put the
+ * shorter sequence along the row, with the narrowest type that holds every score.
+ *
+ * @param str1 The first sequence.
+ * @param str1Len The length of the first sequence.
+ * @param str2 The second sequence.
+ * @param str2Len The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param context How to calculate, and the memory to calculate in.
+ * @param score The output score.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int calculateScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                   long matchScore, long mismatchScore, long gapScore, struct ScoreContext* context, long* score);
+
+/**
+ * Adds the paths and the pruning stats of one context to another.
+ *
+ * @param context The context to add to.
+ * @param other The context whose paths are added.
+ */
+void addPathStats(struct ScoreContext* context, const struct ScoreContext* other);
+
+#endif
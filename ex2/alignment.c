@@ -0,0 +1,527 @@
+/**
+ * @file alignment.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the optimal alignment of two sequences in linear memory.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "alignment.h"
+
+
+/* --- Constants --- */
+
+/** The marks of the gapped text of an alignment. */
+#define ALIGNMENT_MATCH_MARK '|'
+#define ALIGNMENT_MISMATCH_MARK '.'
+#define ALIGNMENT_GAP '-'
+
+/** The number of columns of a line of the gapped text of an alignment. */
+#define ALIGNMENT_LINE_LENGTH 60
+
+/** The smallest number of cells of a part of an alignment that is split between threads. */
+#define ALIGNMENT_PARALLEL_CELLS (1 << 20)
+
+
+/* --- Structs --- */
+
+/** Two sequences aligned in linear memory, see alignSequences. */
+struct Aligner
+{
+	const char* first;
+	const char* firstReversed;
+	size_t firstLen;
+	const char* second;
+	const char* secondReversed;
+	size_t secondLen;
+	long matchScore;
+	long mismatchScore;
+	long gapScore;
+	const struct StripedEngine* engine;
+	// the striped kernel of the last rows, NULL for the scalar kernel of scoreSize
+	int (*kernel)(const char* query, size_t queryLen, const char* database, size_t databaseLen, long matchScore,
+	              long mismatchScore, long gapScore, const struct TableEdges* edges, struct ScoreContext* context,
+	              long* score);
+	size_t scoreSize;
+};
+
+/** The last row of the table of two parts of the sequences, see calculateLastRow. */
+struct RowPass
+{
+	const struct Aligner* aligner;
+	// along the rows
+	const char* outer;
+	size_t outerLen;
+	// along the columns
+	const char* inner;
+	size_t innerLen;
+	struct ScoreContext* context;
+	// innerLen + 1 cells
+	long* row;
+	int ret;
+};
+
+/** A part of an alignment, the letters [start, end) of both sequences, see alignPart. */
+struct AlignmentPart
+{
+	const struct Aligner* aligner;
+	size_t firstStart;
+	size_t firstEnd;
+	size_t secondStart;
+	size_t secondEnd;
+	int numOfThreads;
+	struct ScoreContext* context;
+	// room for the letters of both parts
+	char* operations;
+	size_t numOfOperations;
+	int ret;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the last row of the table of two sequences, the score of the
+ * whole outer sequence against every prefix of the inner one.
+ * If the lanes overflow the row is calculated again with the scalar kernel.
+ *
+ * @param pass The pass, its row receives the output.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+static int calculateLastRow(struct RowPass* pass)
+{
+	const struct Aligner* aligner = pass->aligner;
+	struct TableEdges edges;
+	long* top;
+	long* left;
+	long score;
+	void* buffer;
+	size_t i;
+	int ret = 0;
+
+	pass->row[0] = aligner->gapScore * (long) pass->outerLen;
+	if(pass->outerLen == 0 || pass->innerLen == 0)
+	{
+		for(i = 1; i <= pass->innerLen; i++)
+		{
+			pass->row[i] = aligner->gapScore * (long) (i + pass->outerLen);
+		}
+		return 0;
+	}
+
+	top = malloc(sizeof(long) * (pass->innerLen + 1));
+	// the left edge, and the last column after it
+	left = malloc(sizeof(long) * 2 * pass->outerLen);
+	if(!top || !left)
+	{
+		free(top);
+		free(left);
+		return -ENOMEM;
+	}
+	for(i = 0; i <= pass->innerLen; i++)
+	{
+		top[i] = aligner->gapScore * (long) i;
+	}
+	for(i = 0; i < pass->outerLen; i++)
+	{
+		left[i] = aligner->gapScore * (long) (i + 1);
+	}
+	edges.top = top;
+	edges.left = left;
+	edges.bottom = pass->row + 1;
+	// kept apart from the left edge, which is read again if the lanes overflow
+	edges.right = left + pass->outerLen;
+
+	if(aligner->kernel)
+	{
+		ret = aligner->kernel(pass->inner, pass->innerLen, pass->outer, pass->outerLen, aligner->matchScore,
+		                      aligner->mismatchScore, aligner->gapScore, &edges, pass->context, &score);
+	}
+	if(!aligner->kernel || ret == STRIPED_OVERFLOW)
+	{
+		buffer = reserveBuffer(pass->context, sizeof(long) * (pass->innerLen + 1));
+		if(buffer)
+		{
+			calculateScalarScore(aligner->scoreSize, pass->outer, pass->outerLen, pass->inner, pass->innerLen,
+			                     aligner->matchScore, aligner->mismatchScore, aligner->gapScore, &edges, buffer);
+			ret = 0;
+		}
+		else
+		{
+			ret = -ENOMEM;
+		}
+	}
+	free(top);
+	free(left);
+	return ret;
+}
+
+/**
+ * The main function of a thread that calculates a last row, with a context of its own.
+ *
+ * @param arg The pass.
+ * @return Always NULL.
+ */
+static void* rowPassMain(void* arg)
+{
+	struct RowPass* pass = arg;
+	struct ScoreContext context;
+
+	initScoreContext(&context, pass->aligner->engine, 0);
+	pass->context = &context;
+	pass->ret = calculateLastRow(pass);
+	cleanupScoreContext(&context);
+	return NULL;
+}
+
+/**
+ * Aligns a single letter of the first sequence to a part of the second one.
+ * The letter either faces the letter of the second sequence that scores best
+ * with it, or a gap.
+ *
+ * @param part The part, its first sequence is one letter long.
+ */
+static void alignLetter(struct AlignmentPart* part)
+{
+	const struct Aligner* aligner = part->aligner;
+	char letter = aligner->first[part->firstStart];
+	size_t secondLen = part->secondEnd - part->secondStart;
+	size_t best = secondLen;
+	long bestScore = aligner->gapScore;
+	long score;
+	size_t i;
+
+	for(i = 0; i < secondLen; i++)
+	{
+		score = letter == aligner->second[part->secondStart + i] ? aligner->matchScore : aligner->mismatchScore;
+		if(score - aligner->gapScore > bestScore)
+		{
+			best = i;
+			bestScore = score - aligner->gapScore;
+		}
+	}
+
+	part->numOfOperations = 0;
+	if(best == secondLen)
+	{
+		part->operations[part->numOfOperations++] = OPERATION_FIRST_ONLY;
+	}
+	for(i = 0; i < secondLen; i++)
+	{
+		if(i != best)
+		{
+			part->operations[part->numOfOperations++] = OPERATION_SECOND_ONLY;
+		}
+		else if(letter == aligner->second[part->secondStart + i])
+		{
+			part->operations[part->numOfOperations++] = OPERATION_MATCH;
+		}
+		else
+		{
+			part->operations[part->numOfOperations++] = OPERATION_MISMATCH;
+		}
+	}
+}
+
+/**
+ * The main function of a thread that aligns a part, with a context of its own.
+ *
+ * @param arg The part.
+ * @return Always NULL.
+ */
+static void* alignmentPartMain(void* arg);
+
+/**
+ * Finds an optimal alignment of a part of the sequences in linear memory, see
+ * Hirschberg, "A linear space algorithm for computing maximal common
+ * subsequences" (1975).
+ * The first sequence is cut in the middle. The last row of its first half
+ * against the second sequence, and the last row of its second half against
+ * the second sequence with both reversed, give the best score of every place
+ * to cut the second sequence at. The halves before and after the best place
+ * are then aligned on their own, on two threads if there are enough.
+ *
+ * @param part The part, receives the operations.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+static int alignPart(struct AlignmentPart* part)
+{
+	const struct Aligner* aligner = part->aligner;
+	size_t firstLen = part->firstEnd - part->firstStart;
+	size_t secondLen = part->secondEnd - part->secondStart;
+	size_t middle = part->firstStart + firstLen / 2;
+	struct RowPass forward;
+	struct RowPass backward;
+	struct AlignmentPart halves[2];
+	pthread_t thread;
+	int isParallel;
+	size_t best = 0;
+	size_t i;
+
+	part->numOfOperations = 0;
+	if(firstLen == 0 || secondLen == 0)
+	{
+		for(i = 0; i < firstLen; i++)
+		{
+			part->operations[part->numOfOperations++] = OPERATION_FIRST_ONLY;
+		}
+		for(i = 0; i < secondLen; i++)
+		{
+			part->operations[part->numOfOperations++] = OPERATION_SECOND_ONLY;
+		}
+		return 0;
+	}
+	if(firstLen == 1)
+	{
+		alignLetter(part);
+		return 0;
+	}
+
+	isParallel = part->numOfThreads > 1 && (double) firstLen * (double) secondLen >= ALIGNMENT_PARALLEL_CELLS;
+	forward.aligner = aligner;
+	forward.outer = aligner->first + part->firstStart;
+	forward.outerLen = middle - part->firstStart;
+	forward.inner = aligner->second + part->secondStart;
+	forward.innerLen = secondLen;
+	forward.context = part->context;
+	backward = forward;
+	backward.outer = aligner->firstReversed + (aligner->firstLen - part->firstEnd);
+	backward.outerLen = part->firstEnd - middle;
+	backward.inner = aligner->secondReversed + (aligner->secondLen - part->secondEnd);
+	forward.row = malloc(sizeof(long) * (secondLen + 1));
+	backward.row = malloc(sizeof(long) * (secondLen + 1));
+	if(!forward.row || !backward.row)
+	{
+		free(forward.row);
+		free(backward.row);
+		return -ENOMEM;
+	}
+	if(isParallel && pthread_create(&thread, NULL, rowPassMain, &backward) == 0)
+	{
+		forward.ret = calculateLastRow(&forward);
+		pthread_join(thread, NULL);
+	}
+	else
+	{
+		forward.ret = calculateLastRow(&forward);
+		backward.ret = forward.ret < 0 ? forward.ret : calculateLastRow(&backward);
+	}
+	if(forward.ret < 0 || backward.ret < 0)
+	{
+		free(forward.row);
+		free(backward.row);
+		return -ENOMEM;
+	}
+	for(i = 1; i <= secondLen; i++)
+	{
+		if(forward.row[i] + backward.row[secondLen - i] > forward.row[best] + backward.row[secondLen - best])
+		{
+			best = i;
+		}
+	}
+	free(forward.row);
+	free(backward.row);
+
+	halves[0] = *part;
+	halves[0].firstEnd = middle;
+	halves[0].secondEnd = part->secondStart + best;
+	halves[0].numOfThreads = part->numOfThreads / 2;
+	halves[1] = *part;
+	halves[1].firstStart = middle;
+	halves[1].secondStart = halves[0].secondEnd;
+	halves[1].numOfThreads = part->numOfThreads - halves[0].numOfThreads;
+	// the first half takes at most as many operations as it has letters
+	halves[1].operations = part->operations + (middle - part->firstStart) + best;
+	if(isParallel && pthread_create(&thread, NULL, alignmentPartMain, &halves[0]) == 0)
+	{
+		halves[1].ret = alignPart(&halves[1]);
+		pthread_join(thread, NULL);
+	}
+	else
+	{
+		halves[0].ret = alignPart(&halves[0]);
+		halves[1].ret = halves[0].ret < 0 ? halves[0].ret : alignPart(&halves[1]);
+	}
+	if(halves[0].ret < 0 || halves[1].ret < 0)
+	{
+		return -ENOMEM;
+	}
+	memmove(part->operations + halves[0].numOfOperations, halves[1].operations, halves[1].numOfOperations);
+	part->numOfOperations = halves[0].numOfOperations + halves[1].numOfOperations;
+	return 0;
+}
+
+static void* alignmentPartMain(void* arg)
+{
+	struct AlignmentPart* part = arg;
+	struct ScoreContext context;
+
+	initScoreContext(&context, part->aligner->engine, 0);
+	part->context = &context;
+	part->ret = alignPart(part);
+	cleanupScoreContext(&context);
+	return NULL;
+}
+
+/**
+ * Copies a sequence in reverse.
+ *
+ * @param sequence The sequence.
+ * @param length The length of the sequence.
+ * @return The reversed copy, or NULL if there's no memory. Free with free.
+ */
+static char* reverseSequence(const char* sequence, size_t length)
+{
+	char* reversed = malloc(length + 1);
+	size_t i;
+
+	if(!reversed)
+	{
+		return NULL;
+	}
+	for(i = 0; i < length; i++)
+	{
+		reversed[i] = sequence[length - 1 - i];
+	}
+	reversed[length] = '\0';
+	return reversed;
+}
+
+int alignSequences(const char* first, size_t firstLen, const char* second, size_t secondLen,
+                   long matchScore, long mismatchScore, long gapScore, int numOfThreads,
+                   struct ScoreContext* context, char* operations, size_t* numOfOperations)
+{
+	struct Aligner aligner;
+	struct AlignmentPart part;
+	int ret;
+
+	aligner.first = first;
+	aligner.firstLen = firstLen;
+	aligner.second = second;
+	aligner.secondLen = secondLen;
+	aligner.matchScore = matchScore;
+	aligner.mismatchScore = mismatchScore;
+	aligner.gapScore = gapScore;
+	aligner.engine = context->engine;
+	aligner.kernel = context->engine->kernels[STRIPED_WIDTH_32];
+	if(!fitsLanes(STRIPED_WIDTH_32, secondLen, firstLen, getLargestScore(matchScore, mismatchScore, gapScore)))
+	{
+		aligner.kernel = NULL;
+	}
+	aligner.scoreSize = selectScoreSize(firstLen + secondLen, matchScore, mismatchScore, gapScore);
+	aligner.firstReversed = reverseSequence(first, firstLen);
+	aligner.secondReversed = reverseSequence(second, secondLen);
+	if(!aligner.firstReversed || !aligner.secondReversed)
+	{
+		free((char*) aligner.firstReversed);
+		free((char*) aligner.secondReversed);
+		return -ENOMEM;
+	}
+
+	part.aligner = &aligner;
+	part.firstStart = 0;
+	part.firstEnd = firstLen;
+	part.secondStart = 0;
+	part.secondEnd = secondLen;
+	part.numOfThreads = numOfThreads;
+	part.context = context;
+	part.operations = operations;
+	ret = alignPart(&part);
+	*numOfOperations = part.numOfOperations;
+	free((char*) aligner.firstReversed);
+	free((char*) aligner.secondReversed);
+	return ret;
+}
+
+long scoreAlignment(const char* operations, size_t numOfOperations, long matchScore, long mismatchScore,
+                    long gapScore)
+{
+	long score = 0;
+	size_t i;
+
+	for(i = 0; i < numOfOperations; i++)
+	{
+		if(operations[i] == OPERATION_MATCH)
+		{
+			score += matchScore;
+		}
+		else if(operations[i] == OPERATION_MISMATCH)
+		{
+			score += mismatchScore;
+		}
+		else
+		{
+			score += gapScore;
+		}
+	}
+	return score;
+}
+
+void printCigar(const char* operations, size_t numOfOperations, FILE* output)
+{
+	size_t runStart = 0;
+	size_t i;
+
+	for(i = 1; i <= numOfOperations; i++)
+	{
+		if(i == numOfOperations || operations[i] != operations[runStart])
+		{
+			fprintf(output, "%zu%c", i - runStart, operations[runStart]);
+			runStart = i;
+		}
+	}
+	fprintf(output, "\n");
+}
+
+void printGappedAlignment(const char* first, const char* second, const char* operations, size_t numOfOperations,
+                          FILE* output)
+{
+	char lines[3][ALIGNMENT_LINE_LENGTH + 1];
+	size_t lineStart;
+	size_t column;
+	int line;
+
+	for(lineStart = 0; lineStart < numOfOperations; lineStart += ALIGNMENT_LINE_LENGTH)
+	{
+		for(column = 0; column < ALIGNMENT_LINE_LENGTH && lineStart + column < numOfOperations; column++)
+		{
+			switch(operations[lineStart + column])
+			{
+				case OPERATION_MATCH:
+					lines[0][column] = *first++;
+					lines[1][column] = ALIGNMENT_MATCH_MARK;
+					lines[2][column] = *second++;
+					break;
+				case OPERATION_MISMATCH:
+					lines[0][column] = *first++;
+					lines[1][column] = ALIGNMENT_MISMATCH_MARK;
+					lines[2][column] = *second++;
+					break;
+				case OPERATION_FIRST_ONLY:
+					lines[0][column] = *first++;
+					lines[1][column] = ' ';
+					lines[2][column] = ALIGNMENT_GAP;
+					break;
+				default:
+					lines[0][column] = ALIGNMENT_GAP;
+					lines[1][column] = ' ';
+					lines[2][column] = *second++;
+					break;
+			}
+		}
+		for(line = 0; line < 3; line++)
+		{
+			lines[line][column] = '\0';
+			fprintf(output, "%s\n", lines[line]);
+		}
+		fprintf(output, "\n");
+	}
+}
@@ -0,0 +1,93 @@
+/**
+ * @file alignment.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the optimal alignment of two sequences in linear memory.
+ */
+
+#ifndef ALIGNMENT_H
+#define ALIGNMENT_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include "CompareSequences.h"
+
+
+/* --- Constants --- */
+
+/** The operations of an alignment, as in a CIGAR string. */
+#define OPERATION_MATCH '='
+#define OPERATION_MISMATCH 'X'
+// a letter of the first sequence against a gap
+#define OPERATION_FIRST_ONLY 'I'
+// a letter of the second sequence against a gap
+#define OPERATION_SECOND_ONLY 'D'
+
+/** The formats of the alignments. */
+#define ALIGNMENT_FORMAT_NONE 0
+#define ALIGNMENT_FORMAT_TEXT 1
+#define ALIGNMENT_FORMAT_CIGAR 2
+
+
+/* --- Functions --- */
+
+/**
+ * Finds an optimal alignment of two sequences in linear memory, see alignPart.
+ * The alignment is a list of OPERATION constants, one per column of it.
+ *
+ * @param first The first sequence.
+ * @param firstLen The length of the first sequence.
+ * @param second The second sequence.
+ * @param secondLen The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param numOfThreads How many threads to align on.
+ * @param context How to calculate, its buffer is used.
+ * @param operations The output operations, room for firstLen + secondLen.
+ * @param numOfOperations The output number of operations.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int alignSequences(const char* first, size_t firstLen, const char* second, size_t secondLen,
+                   long matchScore, long mismatchScore, long gapScore, int numOfThreads,
+                   struct ScoreContext* context, char* operations, size_t* numOfOperations);
+
+/**
+ * Calculates the score of an alignment.
+ *
+ * @param operations The operations of the alignment.
+ * @param numOfOperations How many operations there are.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @return The score.
+ */
+long scoreAlignment(const char* operations, size_t numOfOperations, long matchScore, long mismatchScore,
+                    long gapScore);
+
+/**
+ * Prints an alignment as a CIGAR string, every run of the same operation as its length and the operation.
+ *
+ * @param operations The operations of the alignment.
+ * @param numOfOperations How many operations there are.
+ * @param output The stream to print to.
+ */
+void printCigar(const char* operations, size_t numOfOperations, FILE* output);
+
+/**
+ * Prints an alignment as the two sequences with their gaps, one above the
+ * other, and a line between them that marks the matches and the mismatches.
+ * The lines are cut every ALIGNMENT_LINE_LENGTH columns, and every block of lines ends with an empty line.
+ *
+ * @param first The first sequence.
+ * @param second The second sequence.
+ * @param operations The operations of the alignment.
+ * @param numOfOperations How many operations there are.
+ * @param output The stream to print to.
+ */
+void printGappedAlignment(const char* first, const char* second, const char* operations, size_t numOfOperations,
+                          FILE* output);
+
+#endif
@@ -0,0 +1,101 @@
+# Runs CompareSequences on ex2/inputs with every engine and compares what it prints to ex2/outputs.
+# Usage: cmake -DPROGRAM=<CompareSequences> -DSOURCE_DIR=<ex2> -P checkOutputs.cmake
+
+set(ENGINES avx512 avx2 sse4.1 scalar)
+
+# runs the program on an input and fails the check if it doesn't print the expected output,
+# options is a list of more options, or "" for none
+function(check_output engine threads options input expected)
+    execute_process(
+            COMMAND ${PROGRAM} --engine=${engine} -j ${threads} ${options} ${SOURCE_DIR}/inputs/${input} ${ARGN}
+            OUTPUT_VARIABLE actual
+            ERROR_VARIABLE errors
+            RESULT_VARIABLE result)
+    list(JOIN options " " run)
+    list(JOIN ARGN " " scores)
+    set(run "--engine=${engine} -j ${threads} ${run} ${input} ${scores}")
+    if(NOT result EQUAL 0)
+        message(SEND_ERROR "${run} failed: ${errors}")
+    elseif(NOT actual STREQUAL expected)
+        message(SEND_ERROR "${run} doesn't match the expected output")
+    endif()
+endfunction()
+
+# same, with the expected output read from ex2/outputs
+function(check_output_file engine threads options input output)
+    file(READ ${SOURCE_DIR}/outputs/${output} expected)
+    check_output(${engine} ${threads} "${options}" ${input} "${expected}" ${ARGN})
+endfunction()
+
+# runs the program with an alignment option and fails the check if the scores it prints above the alignments
+# aren't the expected output read from ex2/outputs
+function(check_alignment_scores engine threads options input output)
+    file(READ ${SOURCE_DIR}/outputs/${output} expected)
+    execute_process(
+            COMMAND ${PROGRAM} --engine=${engine} -j ${threads} ${options} ${SOURCE_DIR}/inputs/${input} ${ARGN}
+            OUTPUT_VARIABLE actual
+            ERROR_VARIABLE errors
+            RESULT_VARIABLE result)
+    string(REGEX MATCHALL "Score for alignment[^\n]*\n" scoreLines "${actual}")
+    list(JOIN scoreLines "" scoreLines)
+    list(JOIN options " " run)
+    list(JOIN ARGN " " scores)
+    set(run "--engine=${engine} -j ${threads} ${run} ${input} ${scores}")
+    if(NOT result EQUAL 0)
+        message(SEND_ERROR "${run} failed: ${errors}")
+    elseif(NOT scoreLines STREQUAL expected)
+        message(SEND_ERROR "${run} doesn't print the scores of the expected output")
+    endif()
+endfunction()
+
+foreach(engine ${ENGINES})
+    # an engine the processor can't run isn't accepted at all
+    execute_process(
+            COMMAND ${PROGRAM} --engine=${engine} ${SOURCE_DIR}/inputs/empty.txt 1 0 -2
+            OUTPUT_QUIET
+            ERROR_QUIET
+            RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(STATUS "Skipping --engine=${engine}, the processor doesn't support it")
+        continue()
+    endif()
+    message(STATUS "Checking --engine=${engine}")
+
+    # on one thread, and with the pairs shared by several threads
+    foreach(threads 1 4)
+        # the scores fit 8-bit and 16-bit lanes up front
+        check_output_file(${engine} ${threads} "" 100e.txt 100eout.txt 1 0 -2)
+        check_output_file(${engine} ${threads} "" 100h.txt 100h2out.txt 1 0 -2)
+        # positive gaps overflow 8-bit lanes to 16-bit ones, and 16-bit lanes to 32-bit ones
+        check_output_file(${engine} ${threads} "" 100h.txt 100h3out.txt -1 2 3)
+        check_output_file(${engine} ${threads} "" 100h.txt 100h4out.txt 0 1 250)
+        # scores that don't fit any lanes are calculated without them
+        check_output_file(${engine} ${threads} "" 100h.txt 100h5out.txt 100000000 -1 -1)
+        # scores that rank like the edit distance are calculated 64 cells at once
+        check_output_file(${engine} ${threads} "" 100h.txt 100h6out.txt 0 -1 -1)
+        # with more threads than pairs, the long sequences are split to tiles along their edges
+        check_output_file(${engine} ${threads} "" long.txt longout.txt 1 0 -2)
+        # and so are the blocks of words of the edit distance
+        check_output_file(${engine} ${threads} "" long.txt long2out.txt 0 -1 -1)
+        # positive gaps take the cells to the top of 32-bit lanes, tiles that overflow are calculated again
+        check_output_file(${engine} ${threads} "" gaps.txt gapsout.txt -1 -1 100000)
+        # nothing to compare
+        check_output(${engine} ${threads} "" one.txt "" 1 0 -2)
+        check_output(${engine} ${threads} "" empty.txt "" 1 0 -2)
+        # a band or an x-drop that's too narrow is widened until the score is the same as the whole table's
+        foreach(pruning "--band;3" "--xdrop;10")
+            check_output_file(${engine} ${threads} "${pruning}" 100e.txt 100eout.txt 1 0 -2)
+            check_output_file(${engine} ${threads} "${pruning}" 100h.txt 100h2out.txt 1 0 -2)
+            check_output_file(${engine} ${threads} "${pruning}" 100h.txt 100h6out.txt 0 -1 -1)
+            # positive gaps can't be pruned, the whole table is calculated
+            check_output_file(${engine} ${threads} "${pruning}" 100h.txt 100h3out.txt -1 2 3)
+        endforeach()
+        # the alignments are found in linear space, and score what the whole table does
+        foreach(alignment "--align" "--align=cigar")
+            check_alignment_scores(${engine} ${threads} ${alignment} 100e.txt 100eout.txt 1 0 -2)
+            check_alignment_scores(${engine} ${threads} ${alignment} 100h.txt 100h2out.txt 1 0 -2)
+            check_alignment_scores(${engine} ${threads} ${alignment} 100h.txt 100h3out.txt -1 2 3)
+            check_alignment_scores(${engine} ${threads} ${alignment} 100h.txt 100h6out.txt 0 -1 -1)
+        endforeach()
+    endforeach()
+endforeach()
@@ -0,0 +1,172 @@
+/**
+ * @file editDistance.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the bit-parallel edit distance.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <errno.h>
+#include "editDistance.h"
+
+
+/* --- Constants --- */
+
+/** The last bit of a word. */
+#define WORD_LAST_BIT ((uint64_t) 1 << (WORD_BITS - 1))
+
+
+/* --- Functions --- */
+
+int isEditDistanceScore(size_t lengths, long matchScore, long mismatchScore, long gapScore, long* editScore)
+{
+	unsigned long largestScore = getLargestScore(matchScore, mismatchScore, gapScore);
+
+	// k and the whole score are then at most 4 times the largest score for every letter
+	if(largestScore > (unsigned long) LONG_MAX / 8 / (lengths + 1))
+	{
+		return 0;
+	}
+	*editScore = mismatchScore - 2 * gapScore;
+	return *editScore >= 0 && matchScore - 2 * gapScore == 2 * *editScore;
+}
+
+/**
+ * Moves a word of the bit-parallel edit distance to the next column.
+ *
+ * @param plus The rows of the word where the column goes up from the row above, updated.
+ * @param minus The rows of the word where the column goes down from the row above, updated.
+ * @param match The rows of the word whose letter is the letter of the column.
+ * @param carryPlus 1 if the row above the word goes up from the last column, receives the same for lastRow.
+ * @param carryMinus 1 if the row above the word goes down from the last column, receives the same for lastRow.
+ * @param lastRow The row of the word that the word below it continues.
+ */
+static void advanceWord(uint64_t* plus, uint64_t* minus, uint64_t match, uint64_t* carryPlus,
+                        uint64_t* carryMinus, int lastRow)
+{
+	uint64_t verticalChange = match | *minus;
+	uint64_t horizontalChange;
+	uint64_t horizontalPlus;
+	uint64_t horizontalMinus;
+
+	match |= *carryMinus;
+	horizontalChange = (((match & *plus) + *plus) ^ *plus) | match;
+	horizontalPlus = *minus | ~(horizontalChange | *plus);
+	horizontalMinus = *plus & horizontalChange;
+	*plus = (horizontalMinus << 1 | *carryMinus) | ~(verticalChange | (horizontalPlus << 1 | *carryPlus));
+	*minus = (horizontalPlus << 1 | *carryPlus) & verticalChange;
+	*carryPlus = horizontalPlus >> lastRow & 1;
+	*carryMinus = horizontalMinus >> lastRow & 1;
+}
+
+int initEditDistance(struct EditDistance* editDistance, const char* pattern, size_t patternLen, const char* text,
+                     struct ScoreContext* context)
+{
+	size_t numOfWords = (patternLen + WORD_BITS - 1) / WORD_BITS;
+	int numOfLetters = mapLetters(pattern, patternLen, editDistance->letters);
+	uint64_t* matches;
+	size_t i;
+	size_t word;
+
+	matches = reserveBuffer(context, sizeof(uint64_t) * numOfWords * (numOfLetters + 2));
+	if(!matches)
+	{
+		return -ENOMEM;
+	}
+	editDistance->text = text;
+	editDistance->patternLen = patternLen;
+	editDistance->numOfWords = numOfWords;
+	editDistance->matches = matches;
+	editDistance->plus = matches + numOfWords * numOfLetters;
+	editDistance->minus = editDistance->plus + numOfWords;
+	editDistance->carries = NULL;
+	memset(matches, 0, sizeof(uint64_t) * numOfWords * numOfLetters);
+	for(i = 0; i < patternLen; i++)
+	{
+		matches[numOfWords * editDistance->letters[(unsigned char) pattern[i]] + i / WORD_BITS] |=
+				(uint64_t) 1 << (i % WORD_BITS);
+	}
+	for(word = 0; word < numOfWords; word++)
+	{
+		// the first column is the distance from the empty text, it goes up in every row
+		editDistance->plus[word] = ~(uint64_t) 0;
+		editDistance->minus[word] = 0;
+	}
+	return 0;
+}
+
+long advanceEditDistance(struct EditDistance* editDistance, size_t firstRow, size_t endRow, size_t firstColumn,
+                         size_t endColumn)
+{
+	const char* text = editDistance->text;
+	const unsigned char* letters = editDistance->letters;
+	const uint64_t* matches = editDistance->matches;
+	const uint64_t* letterMatches;
+	uint64_t* plus = editDistance->plus;
+	uint64_t* minus = editDistance->minus;
+	unsigned char* carries = editDistance->carries;
+	size_t numOfWords = editDistance->numOfWords;
+	int endsPattern = endRow == editDistance->patternLen;
+	int lastRow = (int) ((editDistance->patternLen - 1) % WORD_BITS);
+	size_t firstWord = firstRow / WORD_BITS;
+	// the last word of the pattern is moved on its own, its last row may be cut short
+	size_t endWord = endsPattern ? numOfWords - 1 : endRow / WORD_BITS;
+	uint64_t carryPlus;
+	uint64_t carryMinus;
+	long change = 0;
+	size_t j;
+	size_t word;
+
+	for(j = firstColumn; j < endColumn; j++)
+	{
+		letterMatches = matches + numOfWords * letters[(unsigned char) text[j]];
+		if(firstWord == 0)
+		{
+			// the first row goes up by one in every column
+			carryPlus = 1;
+			carryMinus = 0;
+		}
+		else
+		{
+			carryPlus = carries[j] & 1;
+			carryMinus = carries[j] >> 1;
+		}
+		for(word = firstWord; word < endWord; word++)
+		{
+			advanceWord(&plus[word], &minus[word], letterMatches[word], &carryPlus, &carryMinus, WORD_BITS - 1);
+		}
+		if(endsPattern)
+		{
+			advanceWord(&plus[word], &minus[word], letterMatches[word], &carryPlus, &carryMinus, lastRow);
+			change += (long) carryPlus - (long) carryMinus;
+		}
+		else
+		{
+			carries[j] = (unsigned char) (carryPlus | carryMinus << 1);
+		}
+	}
+	return change;
+}
+
+int calculateEditDistance(const char* pattern, size_t patternLen, const char* text, size_t textLen,
+                          struct ScoreContext* context, size_t* distance)
+{
+	struct EditDistance editDistance;
+	int ret;
+
+	if(patternLen == 0)
+	{
+		*distance = textLen;
+		return 0;
+	}
+	ret = initEditDistance(&editDistance, pattern, patternLen, text, context);
+	if(ret < 0)
+	{
+		return ret;
+	}
+	*distance = (size_t) ((long) patternLen + advanceEditDistance(&editDistance, 0, patternLen, 0, textLen));
+	return 0;
+}
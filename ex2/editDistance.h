@@ -0,0 +1,114 @@
+/**
+ * @file editDistance.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the bit-parallel edit distance, for the scores that rank the
+ * alignments like it does.
+ */
+
+#ifndef EDIT_DISTANCE_H
+#define EDIT_DISTANCE_H
+
+
+/* --- Includes --- */
+
+#include <stdint.h>
+#include <limits.h>
+#include "CompareSequences.h"
+
+
+/* --- Constants --- */
+
+/** The bits of a word of the bit-parallel edit distance. */
+#define WORD_BITS 64
+
+
+/* --- Structs --- */
+
+/** The bit-parallel edit distance of two sequences, calculated a block of words and columns at a time. */
+struct EditDistance
+{
+	const char* text;
+	size_t patternLen;
+	size_t numOfWords;
+	unsigned char letters[UCHAR_MAX + 1];
+	// the rows of every word whose letter is every letter, numOfWords per letter
+	uint64_t* matches;
+	// where the last column done of every word goes up and down from the row above
+	uint64_t* plus;
+	uint64_t* minus;
+	// whether the last row of the last word done in every column goes up (bit 0) and down (bit 1), set by the caller
+	unsigned char* carries;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Checks if the scores rank the alignments of two sequences like the edit distance does.
+ * An alignment with M matches, S mismatches and G gaps has 2(M + S) + G = n
+ * letters, where n is the sum of the lengths. So its score is
+ * (m - 2g)M + (s - 2g)S + gn, and when m - 2g = 2(s - 2g) = 2k that is
+ * gn + 2kM + kS = (k + g)n - k(S + G). For k >= 0 the best score is the one
+ * with the fewest edits, like match 0, mismatch -1 and gap -1.
+ *
+ * @param lengths The sum of the lengths of the sequences.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param editScore The output k, what every edit costs.
+ * @return 1 if they do, 0 otherwise.
+ */
+int isEditDistanceScore(size_t lengths, long matchScore, long mismatchScore, long gapScore, long* editScore);
+
+/**
+ * Prepares the edit distance of two sequences, from the first column of its table.
+ * The carries aren't set, they're only needed when the words are cut into blocks.
+ *
+ * @param editDistance The edit distance.
+ * @param pattern The pattern, along the columns, not empty.
+ * @param patternLen The length of the pattern.
+ * @param text The text, every letter of it is a step to the next column.
+ * @param context The context, its buffer is used.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int initEditDistance(struct EditDistance* editDistance, const char* pattern, size_t patternLen, const char* text,
+                     struct ScoreContext* context);
+
+/**
+ * Moves a block of words of the edit distance across a block of columns.
+ * The block above it in the same columns must be done already, and the block
+ * to its left in the same words. A block that doesn't end the pattern leaves
+ * the carries of its last row to the block below it.
+ *
+ * @param editDistance The edit distance.
+ * @param firstRow The first row of the block, a multiple of WORD_BITS.
+ * @param endRow The row after the block, a multiple of WORD_BITS or the length of the pattern.
+ * @param firstColumn The first column of the block.
+ * @param endColumn The column after the block.
+ * @return How much the distance changes across the block if it ends the pattern, 0 otherwise.
+ */
+long advanceEditDistance(struct EditDistance* editDistance, size_t firstRow, size_t endRow, size_t firstColumn,
+                         size_t endColumn);
+
+/**
+ * Calculates the edit distance of two sequences, 64 cells at once, see
+ * Myers, "A fast bit-vector algorithm for approximate string matching based
+ * on dynamic programming" (1999).
+ * A column of the table is kept as the bits of where it goes up and where it
+ * goes down from one row to the next. The pattern is cut into words, and a
+ * word passes to the word below it whether its last row went up or down.
+ * The first row goes up by one in every column, since the distance is global.
+ *
+ * @param pattern The pattern, along the columns.
+ * @param patternLen The length of the pattern.
+ * @param text The text, every letter of it is a step to the next column.
+ * @param textLen The length of the text.
+ * @param context The context, its buffer is used.
+ * @param distance The output edit distance.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int calculateEditDistance(const char* pattern, size_t patternLen, const char* text, size_t textLen,
+                          struct ScoreContext* context, size_t* distance);
+
+#endif
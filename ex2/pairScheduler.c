@@ -0,0 +1,275 @@
+/**
+ * @file pairScheduler.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the scores of every pair of sequences, on several threads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include "pairScheduler.h"
+#include "pruning.h"
+
+
+/* --- Structs --- */
+
+/** The pairs a worker has yet to calculate, the largest at the head. */
+struct PairQueue
+{
+	struct Pair** pairs;
+	size_t head;
+	size_t tail;
+	pthread_mutex_t lock;
+};
+
+/** The pairs of all the workers, and what they calculate with. */
+struct PairScheduler
+{
+	const struct Sequence* sequences;
+	const size_t* lengths;
+	long matchScore;
+	long mismatchScore;
+	long gapScore;
+	int numOfWorkers;
+	// by worker
+	struct PairQueue* queues;
+	struct ScoreContext* contexts;
+};
+
+/** A worker thread. */
+struct PairWorker
+{
+	struct PairScheduler* scheduler;
+	int index;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Compares two pairs by their number of cells, the larger first, and then by their order.
+ *
+ * @param first A pointer to the first pair.
+ * @param second A pointer to the second pair.
+ * @return Negative if the first goes first, positive otherwise.
+ */
+static int comparePairs(const void* first, const void* second)
+{
+	const struct Pair* pair1 = *(const struct Pair* const*) first;
+	const struct Pair* pair2 = *(const struct Pair* const*) second;
+
+	if(pair1->numOfCells != pair2->numOfCells)
+	{
+		return pair1->numOfCells > pair2->numOfCells ? -1 : 1;
+	}
+	return pair1 < pair2 ? -1 : 1;
+}
+
+/**
+ * Takes the next pair of a worker, from the front of its own queue, or
+ * from the back of the queue of another worker once its own one is empty.
+ *
+ * @param scheduler The scheduler.
+ * @param worker The index of the worker.
+ * @return The pair, or NULL if every pair was taken.
+ */
+static struct Pair* takePair(struct PairScheduler* scheduler, int worker)
+{
+	struct PairQueue* queue;
+	struct Pair* pair = NULL;
+	int i;
+
+	queue = &scheduler->queues[worker];
+	pthread_mutex_lock(&queue->lock);
+	if(queue->head < queue->tail)
+	{
+		pair = queue->pairs[queue->head++];
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	// the back holds the shortest pairs, which even out the end of the run best
+	for(i = 1; !pair && i < scheduler->numOfWorkers; i++)
+	{
+		queue = &scheduler->queues[(worker + i) % scheduler->numOfWorkers];
+		pthread_mutex_lock(&queue->lock);
+		if(queue->head < queue->tail)
+		{
+			pair = queue->pairs[--queue->tail];
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+	return pair;
+}
+
+/**
+ * Calculates pairs until every pair was taken.
+ *
+ * @param scheduler The scheduler.
+ * @param worker The index of the worker.
+ */
+static void runWorker(struct PairScheduler* scheduler, int worker)
+{
+	const struct Sequence* sequences = scheduler->sequences;
+	const size_t* lengths = scheduler->lengths;
+	struct Pair* pair;
+
+	while((pair = takePair(scheduler, worker)) != NULL)
+	{
+		pair->ret = calculatePrunedScore(sequences[pair->first].sequence, lengths[pair->first],
+		                                 sequences[pair->second].sequence, lengths[pair->second],
+		                                 scheduler->matchScore, scheduler->mismatchScore, scheduler->gapScore,
+		                                 &scheduler->contexts[worker], &pair->score);
+	}
+}
+
+/**
+ * The main function of a worker thread.
+ *
+ * @param arg The worker.
+ * @return Always NULL.
+ */
+static void* workerMain(void* arg)
+{
+	struct PairWorker* worker = arg;
+
+	runWorker(worker->scheduler, worker->index);
+	return NULL;
+}
+
+/**
+ * Calculates the score of every pair of sequences on several threads.
+ * The pairs are sorted by their number of cells and dealt to the queues of
+ * the workers from the largest, so the run doesn't end on a large pair.
+ * Every worker has its own context, and the calling thread is the first worker.
+ *
+ * @param scheduler The scheduler, everything but the workers is set.
+ * @return 0 on success, ENOMEM if there's not enough memory.
+ */
+static int runWorkers(struct PairScheduler* scheduler)
+{
+	struct PairWorker* workers;
+	pthread_t* threads;
+	int numOfThreads;
+	int i;
+
+	workers = malloc(sizeof(struct PairWorker) * scheduler->numOfWorkers);
+	threads = malloc(sizeof(pthread_t) * scheduler->numOfWorkers);
+	if(!workers || !threads)
+	{
+		free(workers);
+		free(threads);
+		return ENOMEM;
+	}
+	for(numOfThreads = 1; numOfThreads < scheduler->numOfWorkers; numOfThreads++)
+	{
+		workers[numOfThreads].scheduler = scheduler;
+		workers[numOfThreads].index = numOfThreads;
+		if(pthread_create(&threads[numOfThreads], NULL, workerMain, &workers[numOfThreads]) != 0)
+		{
+			// the started workers and this thread still take every pair
+			break;
+		}
+	}
+	runWorker(scheduler, 0);
+	for(i = 1; i < numOfThreads; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	free(workers);
+	free(threads);
+	return 0;
+}
+
+int calculateAllPairs(const struct Sequence* sequences, const size_t* lengths, int numOfSequences,
+                      long matchScore, long mismatchScore, long gapScore, const struct StripedEngine* engine,
+                      int numOfWorkers, struct ScoreContext* context, struct Pair** pairsPtr)
+{
+	struct PairScheduler scheduler;
+	struct Pair* pairs;
+	struct Pair** order;
+	struct Pair** dealt;
+	size_t numOfPairs = (size_t) numOfSequences * (numOfSequences - 1) / 2;
+	size_t pairIndex = 0;
+	size_t queueStart = 0;
+	int worker;
+	int ret;
+	int i, j;
+
+	pairs = malloc(sizeof(struct Pair) * (numOfPairs + 1));
+	order = malloc(sizeof(struct Pair*) * (numOfPairs + 1));
+	dealt = malloc(sizeof(struct Pair*) * (numOfPairs + 1));
+	scheduler.queues = malloc(sizeof(struct PairQueue) * numOfWorkers);
+	scheduler.contexts = malloc(sizeof(struct ScoreContext) * numOfWorkers);
+	if(!pairs || !order || !dealt || !scheduler.queues || !scheduler.contexts)
+	{
+		free(pairs);
+		free(order);
+		free(dealt);
+		free(scheduler.queues);
+		free(scheduler.contexts);
+		return ENOMEM;
+	}
+
+	for(i = 0; i < numOfSequences; i++)
+	{
+		for(j = i + 1; j < numOfSequences; j++)
+		{
+			pairs[pairIndex].first = i;
+			pairs[pairIndex].second = j;
+			pairs[pairIndex].numOfCells = (double) lengths[i] * (double) lengths[j];
+			pairs[pairIndex].ret = 0;
+			order[pairIndex] = &pairs[pairIndex];
+			pairIndex++;
+		}
+	}
+	qsort(order, numOfPairs, sizeof(struct Pair*), comparePairs);
+
+	// worker w gets the pairs w, w + numOfWorkers, ... of the order, so every queue is sorted too
+	for(worker = 0; worker < numOfWorkers; worker++)
+	{
+		scheduler.queues[worker].pairs = dealt + queueStart;
+		scheduler.queues[worker].head = 0;
+		scheduler.queues[worker].tail = numOfPairs / numOfWorkers + ((size_t) worker < numOfPairs % numOfWorkers);
+		queueStart += scheduler.queues[worker].tail;
+		pthread_mutex_init(&scheduler.queues[worker].lock, NULL);
+		initScoreContext(&scheduler.contexts[worker], engine, context->measure);
+		scheduler.contexts[worker].pruning = context->pruning;
+		scheduler.contexts[worker].pruningLimit = context->pruningLimit;
+	}
+	for(pairIndex = 0; pairIndex < numOfPairs; pairIndex++)
+	{
+		scheduler.queues[pairIndex % numOfWorkers].pairs[pairIndex / numOfWorkers] = order[pairIndex];
+	}
+
+	scheduler.sequences = sequences;
+	scheduler.lengths = lengths;
+	scheduler.matchScore = matchScore;
+	scheduler.mismatchScore = mismatchScore;
+	scheduler.gapScore = gapScore;
+	scheduler.numOfWorkers = numOfWorkers;
+	ret = runWorkers(&scheduler);
+
+	for(worker = 0; worker < numOfWorkers; worker++)
+	{
+		addPathStats(context, &scheduler.contexts[worker]);
+		cleanupScoreContext(&scheduler.contexts[worker]);
+		pthread_mutex_destroy(&scheduler.queues[worker].lock);
+	}
+	free(order);
+	free(dealt);
+	free(scheduler.queues);
+	free(scheduler.contexts);
+	if(ret != 0)
+	{
+		free(pairs);
+		return ret;
+	}
+	*pairsPtr = pairs;
+	return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file pairScheduler.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the scores of every pair of sequences, on several threads.
+ */
+
+#ifndef PAIR_SCHEDULER_H
+#define PAIR_SCHEDULER_H
+
+
+/* --- Includes --- */
+
+#include "CompareSequences.h"
+
+
+/* --- Structs --- */
+
+/** A pair of sequences to compare. */
+struct Pair
+{
+	// the indices of the sequences, first < second
+	int first;
+	int second;
+	double numOfCells;
+	long score;
+	// the return value of calculateScore
+	int ret;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the score of every pair of sequences, on the given number of threads.
+ * The pairs are returned in the order of the sequences, first by the first
+ * sequence and then by the second one.
+ *
+ * @param sequences The sequences.
+ * @param lengths The lengths of the sequences.
+ * @param numOfSequences How many sequences there are.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param engine The engine to calculate with.
+ * @param numOfWorkers How many threads to calculate on.
+ * @param context The pruning of the workers, and the output paths of all of them, see initScoreContext.
+ * @param pairsPtr The output pairs, free with free.
+ * @return 0 on success, an error code otherwise. The scores of the pairs are only valid where ret is 0.
+ */
+int calculateAllPairs(const struct Sequence* sequences, const size_t* lengths, int numOfSequences,
+                      long matchScore, long mismatchScore, long gapScore, const struct StripedEngine* engine,
+                      int numOfWorkers, struct ScoreContext* context, struct Pair** pairsPtr);
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ * @file pruning.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the comparison score on a pruned table.
+ */
+
+
+/* --- Includes --- */
+
+#include <errno.h>
+#include "pruning.h"
+
+
+/* --- Constants --- */
+
+/** The names of the ways to prune. */
+static const char* const PRUNING_NAMES[] = {"full", "band", "x-drop"};
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the best score of the alignments of two sequences that stay in
+ * a band of diagonals of the table. Diagonal d holds the cells (i, i + d).
+ * Only the cells of the band are calculated, and the cells around it are PRUNED_SCORE.
+ *
+ * @param str1 The first sequence, along the rows.
+ * @param str1Len The length of the first sequence.
+ * @param str2 The second sequence, along the row.
+ * @param str2Len The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param lowest The lowest diagonal of the band, at most 0 and at most str2Len - str1Len.
+ * @param highest The highest diagonal of the band, at least 0 and at least str2Len - str1Len.
+ * @param row A buffer of str2Len + 1 longs.
+ * @param score The output score.
+ * @return How many cells were calculated.
+ */
+static double calculateBandScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                                 long matchScore, long mismatchScore, long gapScore, long lowest, long highest,
+                                 long* row, long* score)
+{
+	double numOfCells = 0;
+	long diagonal;
+	long value;
+	size_t first;
+	size_t last;
+	size_t i;
+	size_t j;
+
+	for(j = 0; j <= str2Len; j++)
+	{
+		row[j] = (long) j <= highest ? gapScore * (long) j : PRUNED_SCORE;
+	}
+	for(i = 1; i <= str1Len; i++)
+	{
+		first = (long) i + lowest > 0 ? i + lowest : 0;
+		last = (long) i + highest < (long) str2Len ? i + highest : str2Len;
+		if(first == 0)
+		{
+			diagonal = row[0];
+			row[0] = gapScore * (long) i;
+			j = 1;
+		}
+		else
+		{
+			// the cell before the band was in the band of the row above
+			diagonal = row[first - 1];
+			row[first - 1] = PRUNED_SCORE;
+			j = first;
+		}
+		for(; j <= last; j++)
+		{
+			value = diagonal + (str1[i - 1] == str2[j - 1] ? matchScore : mismatchScore);
+			diagonal = row[j];
+			if(diagonal + gapScore > value)
+			{
+				value = diagonal + gapScore;
+			}
+			if(row[j - 1] + gapScore > value)
+			{
+				value = row[j - 1] + gapScore;
+			}
+			row[j] = value;
+		}
+		numOfCells += last - first + 1;
+	}
+	*score = row[str2Len];
+	return numOfCells;
+}
+
+/**
+ * Finds the highest score the alignments of the rest of two sequences may
+ * have, with as many pairs of letters and as few gaps as there can be.
+ * Only holds when a pair of letters scores more than two gaps.
+ *
+ * @param str1Len The length of the rest of the first sequence.
+ * @param str2Len The length of the rest of the second sequence.
+ * @param pairScore The higher of the match score and the mismatch score.
+ * @param gapScore The gap score.
+ * @return The highest score.
+ */
+static long getHighestScore(size_t str1Len, size_t str2Len, long pairScore, long gapScore)
+{
+	if(str1Len < str2Len)
+	{
+		return pairScore * (long) str1Len + gapScore * (long) (str2Len - str1Len);
+	}
+	return pairScore * (long) str2Len + gapScore * (long) (str1Len - str2Len);
+}
+
+/**
+ * Calculates the best score of the alignments of two sequences whose cells
+ * never drop more than a limit below the best cell calculated before them.
+ * The rows are calculated from the first cell left in the row above, and
+ * end after the last one unless the cells to their left are still left.
+ * Every cell that drops is kept out of the cells after it, and the highest
+ * score an alignment through it may have is kept as the bound.
+ *
+ * @param str1 The first sequence, along the rows.
+ * @param str1Len The length of the first sequence.
+ * @param str2 The second sequence, along the row.
+ * @param str2Len The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score, less than half of the higher of the other scores.
+ * @param xDrop How far below the best cell a cell may drop.
+ * @param row A buffer of str2Len + 1 longs.
+ * @param score The output score, PRUNED_SCORE if the last cell dropped.
+ * @param bound The output bound, PRUNED_SCORE if no cell dropped.
+ * @return How many cells were calculated.
+ */
+static double calculateXDropScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                                  long matchScore, long mismatchScore, long gapScore, long xDrop,
+                                  long* row, long* score, long* bound)
+{
+	long pairScore = matchScore > mismatchScore ? matchScore : mismatchScore;
+	double numOfCells = 0;
+	long best = 0;
+	long diagonal;
+	long value;
+	size_t first = 0;
+	size_t last = 0;
+	size_t nextFirst;
+	size_t nextLast = 0;
+	size_t i;
+	size_t j;
+
+	*bound = PRUNED_SCORE;
+	for(j = 0; j <= str2Len; j++)
+	{
+		row[j] = PRUNED_SCORE;
+	}
+	for(j = 0; j <= str2Len; j++)
+	{
+		value = gapScore * (long) j;
+		numOfCells++;
+		if(value < best - xDrop)
+		{
+			// the rest of the row is only reached through this cell
+			*bound = value + getHighestScore(str1Len, str2Len - j, pairScore, gapScore);
+			break;
+		}
+		row[j] = value;
+		last = j;
+	}
+
+	for(i = 1; i <= str1Len && first <= last; i++)
+	{
+		nextFirst = str2Len + 1;
+		if(first == 0)
+		{
+			diagonal = row[0];
+			value = gapScore * (long) i;
+			numOfCells++;
+			if(value < best - xDrop)
+			{
+				if(value + getHighestScore(str1Len - i, str2Len, pairScore, gapScore) > *bound)
+				{
+					*bound = value + getHighestScore(str1Len - i, str2Len, pairScore, gapScore);
+				}
+				row[0] = PRUNED_SCORE;
+			}
+			else
+			{
+				row[0] = value;
+				nextFirst = 0;
+				nextLast = 0;
+			}
+			j = 1;
+		}
+		else
+		{
+			// left of the first cell of the row above, so it dropped
+			diagonal = row[first - 1];
+			j = first;
+		}
+		// past the cell below and to the right of the last cell, only the cell to the left may be left
+		for(; j <= str2Len && (j <= last + 1 || row[j - 1] > PRUNED_SCORE); j++)
+		{
+			value = diagonal + (str1[i - 1] == str2[j - 1] ? matchScore : mismatchScore);
+			diagonal = row[j];
+			if(diagonal + gapScore > value)
+			{
+				value = diagonal + gapScore;
+			}
+			if(row[j - 1] + gapScore > value)
+			{
+				value = row[j - 1] + gapScore;
+			}
+			numOfCells++;
+			if(value < best - xDrop)
+			{
+				if(value + getHighestScore(str1Len - i, str2Len - j, pairScore, gapScore) > *bound)
+				{
+					*bound = value + getHighestScore(str1Len - i, str2Len - j, pairScore, gapScore);
+				}
+				row[j] = PRUNED_SCORE;
+				continue;
+			}
+			row[j] = value;
+			if(value > best)
+			{
+				best = value;
+			}
+			if(nextFirst > str2Len)
+			{
+				nextFirst = j;
+			}
+			nextLast = j;
+		}
+		if(nextFirst > str2Len)
+		{
+			// every cell of the row dropped
+			*score = PRUNED_SCORE;
+			return numOfCells;
+		}
+		first = nextFirst;
+		last = nextLast;
+	}
+	*score = row[str2Len];
+	return numOfCells;
+}
+
+int calculatePrunedScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                         long matchScore, long mismatchScore, long gapScore, struct ScoreContext* context,
+                         long* score)
+{
+	struct PruningStats* stats = &context->pruningStats;
+	long pairScore = matchScore > mismatchScore ? matchScore : mismatchScore;
+	long limit = context->pruningLimit;
+	// no cell drops further than the lowest score below the highest one
+	double widestDrop = 2.0 * getLargestScore(matchScore, mismatchScore, gapScore) * (double) (str1Len + str2Len);
+	double tableCells = (double) str1Len * (double) str2Len;
+	// the cells of the pruned tables of this pair so far, and at least the cells of the next one
+	double numOfCells = 0;
+	double nextCells = 0;
+	double cells;
+	size_t width;
+	size_t numOfGaps;
+	long* row;
+	long bound;
+
+	if(context->pruning == PRUNING_NONE)
+	{
+		return calculateScore(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, context, score);
+	}
+	if(str2Len > str1Len)
+	{
+		return calculatePrunedScore(str2, str2Len, str1, str1Len, matchScore, mismatchScore, gapScore, context,
+		                            score);
+	}
+
+	stats->numOfPairs++;
+	stats->numOfTableCells += tableCells;
+	row = reserveBuffer(context, sizeof(long) * (str2Len + 1));
+	if(!row)
+	{
+		return -ENOMEM;
+	}
+	while(2 * gapScore < pairScore && context->pruning == PRUNING_BAND && (size_t) limit < str2Len)
+	{
+		// a row holds at most a cell of every diagonal of the band
+		width = 2 * (size_t) limit + 1 + (str1Len - str2Len);
+		nextCells = (double) (width < str2Len ? width : str2Len) * (double) str1Len;
+		if(numOfCells + nextCells > tableCells)
+		{
+			// widening again would calculate more cells than the whole table does
+			break;
+		}
+		cells = calculateBandScore(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore,
+		                           -(long) (str1Len - str2Len) - limit, limit, row, score);
+		numOfCells += cells;
+		stats->numOfCells += cells;
+		numOfGaps = 2 * (limit + 1) + (str1Len - str2Len);
+		if(2 * *score >= pairScore * (long) (str1Len + str2Len - numOfGaps) + 2 * gapScore * (long) numOfGaps)
+		{
+			return 0;
+		}
+		stats->numOfWidenings++;
+		limit = 2 * limit + 1;
+	}
+	while(2 * gapScore < pairScore && context->pruning == PRUNING_X_DROP && (double) limit < widestDrop)
+	{
+		// a wider drop keeps at least the cells of the last one
+		if(numOfCells + nextCells > tableCells)
+		{
+			break;
+		}
+		nextCells = calculateXDropScore(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, limit,
+		                                row, score, &bound);
+		numOfCells += nextCells;
+		stats->numOfCells += nextCells;
+		if(*score != PRUNED_SCORE && *score >= bound)
+		{
+			return 0;
+		}
+		stats->numOfWidenings++;
+		limit = 2 * limit + 1;
+	}
+
+	stats->numOfFallbacks++;
+	stats->numOfCells += (double) str1Len * (double) str2Len;
+	return calculateScore(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, context, score);
+}
+
+void printPruningStats(const struct ScoreContext* context, FILE* output)
+{
+	const struct PruningStats* stats = &context->pruningStats;
+
+	fprintf(output, "Pruning %s: %ld pairs, %.0f of %.0f cells (%.2f%%), %ld widened, %ld on the whole table\n",
+	        PRUNING_NAMES[context->pruning], stats->numOfPairs, stats->numOfCells, stats->numOfTableCells,
+	        stats->numOfTableCells > 0 ? 100 * stats->numOfCells / stats->numOfTableCells : 0.0,
+	        stats->numOfWidenings, stats->numOfFallbacks);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file pruning.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the comparison score on a pruned table, a band of diagonals
+ * or the cells that don't drop too low.
+ */
+
+#ifndef PRUNING_H
+#define PRUNING_H
+
+
+/* --- Includes --- */
+
+#include <stdio.h>
+#include <limits.h>
+#include "CompareSequences.h"
+
+
+/* --- Constants --- */
+
+/** How much of the table is calculated, all of it, a band of diagonals or the cells that don't drop too low. */
+#define PRUNING_NONE 0
+#define PRUNING_BAND 1
+#define PRUNING_X_DROP 2
+
+/** The score of a cell outside the pruned table, low enough to never win and to never wrap around. */
+#define PRUNED_SCORE (LONG_MIN / 2)
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the comparision score of two sequences on a pruned table, see
+ * the pruning of the context, or on the whole table, see calculateScore.
+ * The pruned score is only kept when it is proven to be the best score:
+ * With a band of k diagonals around the diagonals of the corners, an
+ * alignment that leaves the band has at least 2(k + 1) more gaps than the
+ * difference of the lengths, which bounds its score. With the X-drop, an
+ * alignment through a dropped cell scores at most the bound of the cell.
+ * Otherwise the band or the drop is doubled, until it's as wide as the whole
+ * table or the next pruned table would take the cells of the pair past the
+ * cells of the whole table, and the whole table is calculated instead. When a pair of letters
+ * scores at most two gaps nothing can be proven, so the whole table is calculated at once.
+ *
+ * @param str1 The first sequence.
+ * @param str1Len The length of the first sequence.
+ * @param str2 The second sequence.
+ * @param str2Len The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param context How to calculate, receives the pruning stats.
+ * @param score The output score.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int calculatePrunedScore(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                         long matchScore, long mismatchScore, long gapScore, struct ScoreContext* context,
+                         long* score);
+
+/**
+ * Prints how many cells the pruned tables of a context calculated, out of the cells of the whole tables.
+ *
+ * @param context The context.
+ * @param output The stream to print to.
+ */
+void printPruningStats(const struct ScoreContext* context, FILE* output);
+
+#endif
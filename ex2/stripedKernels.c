@@ -0,0 +1,347 @@
+/**
+ * @file stripedKernels.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the striped kernels of the comparison score.
+ */
+
+
+/* --- Includes --- */
+
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include "stripedKernels.h"
+#include "CompareSequences.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+
+/* --- Constants --- */
+
+/** The range of the lanes of every width. The 32 bit lanes use half the range, so a gap never wraps around. */
+#define STRIPED_MINIMUM_8 INT8_MIN
+#define STRIPED_MAXIMUM_8 INT8_MAX
+#define STRIPED_MINIMUM_16 INT16_MIN
+#define STRIPED_MAXIMUM_16 INT16_MAX
+#define STRIPED_MINIMUM_32 (INT32_MIN / 2)
+#define STRIPED_MAXIMUM_32 (INT32_MAX / 2)
+
+/** The largest value of the lanes of every width. */
+static const long STRIPED_LIMITS[NUM_OF_STRIPED_WIDTHS] = {STRIPED_MAXIMUM_8, STRIPED_MAXIMUM_16, STRIPED_MAXIMUM_32};
+
+/** The most lanes a vector of every width has, the 512 bits of AVX-512. */
+static const size_t STRIPED_MOST_LANES[NUM_OF_STRIPED_WIDTHS] = {64, 32, 16};
+
+
+/* --- Functions --- */
+
+#ifdef HAS_X86_KERNELS
+
+/*
+ * The vector operations of every instruction set, on lanes of the given bits.
+ * SHIFT_IN moves every lane one lane up, and puts a value in the first lane.
+ * The 8 and 16 bit additions saturate, the 32 bit ones never overflow since
+ * the scores are checked before, see fitsLanes.
+ */
+
+#define SSE41_VECTOR __m128i
+#define SSE41_LOAD(pointer) _mm_loadu_si128((const __m128i*) (pointer))
+#define SSE41_STORE(pointer, a) _mm_storeu_si128((__m128i*) (pointer), a)
+#define SSE41_SET(bits, value) _mm_set1_epi##bits(value)
+#define SSE41_ADD(bits, a, b) SSE41_ADD_##bits(a, b)
+#define SSE41_ADD_8 _mm_adds_epi8
+#define SSE41_ADD_16 _mm_adds_epi16
+#define SSE41_ADD_32 _mm_add_epi32
+#define SSE41_MAX(bits, a, b) _mm_max_epi##bits(a, b)
+#define SSE41_MIN(bits, a, b) _mm_min_epi##bits(a, b)
+#define SSE41_SHIFT_IN(bits, a, value) _mm_insert_epi##bits(_mm_slli_si128(a, (bits) / 8), value, 0)
+#define SSE41_ANY_GREATER(bits, a, b) (_mm_movemask_epi8(_mm_cmpgt_epi##bits(a, b)) != 0)
+
+#define AVX2_VECTOR __m256i
+#define AVX2_LOAD(pointer) _mm256_loadu_si256((const __m256i*) (pointer))
+#define AVX2_STORE(pointer, a) _mm256_storeu_si256((__m256i*) (pointer), a)
+#define AVX2_SET(bits, value) _mm256_set1_epi##bits(value)
+#define AVX2_ADD(bits, a, b) AVX2_ADD_##bits(a, b)
+#define AVX2_ADD_8 _mm256_adds_epi8
+#define AVX2_ADD_16 _mm256_adds_epi16
+#define AVX2_ADD_32 _mm256_add_epi32
+#define AVX2_MAX(bits, a, b) _mm256_max_epi##bits(a, b)
+#define AVX2_MIN(bits, a, b) _mm256_min_epi##bits(a, b)
+// the lower half is moved into the upper one, since the byte shifts stay within halves
+#define AVX2_SHIFT_IN(bits, a, value) \
+	_mm256_insert_epi##bits(_mm256_alignr_epi8(a, _mm256_permute2x128_si256(a, a, 0x08), 16 - (bits) / 8), \
+	                        value, 0)
+#define AVX2_ANY_GREATER(bits, a, b) (_mm256_movemask_epi8(_mm256_cmpgt_epi##bits(a, b)) != 0)
+
+#define AVX512_VECTOR __m512i
+#define AVX512_LOAD(pointer) _mm512_loadu_si512(pointer)
+#define AVX512_STORE(pointer, a) _mm512_storeu_si512(pointer, a)
+#define AVX512_SET(bits, value) _mm512_set1_epi##bits(value)
+#define AVX512_ADD(bits, a, b) AVX512_ADD_##bits(a, b)
+#define AVX512_ADD_8 _mm512_adds_epi8
+#define AVX512_ADD_16 _mm512_adds_epi16
+#define AVX512_ADD_32 _mm512_add_epi32
+#define AVX512_MAX(bits, a, b) _mm512_max_epi##bits(a, b)
+#define AVX512_MIN(bits, a, b) _mm512_min_epi##bits(a, b)
+// every 128 bit quarter is shifted with the top of the quarter below it
+#define AVX512_SHIFT_IN(bits, a, value) \
+	_mm512_mask_set1_epi##bits(_mm512_alignr_epi8(a, _mm512_alignr_epi64(a, _mm512_setzero_si512(), 6), \
+	                                              16 - (bits) / 8), 1, value)
+#define AVX512_ANY_GREATER(bits, a, b) (_mm512_cmpgt_epi##bits##_mask(a, b) != 0)
+
+/**
+ * Defines a striped kernel, that calculates the comparision score of two
+ * sequences with the vectors of an instruction set, see Farrar, "Striped
+ * Smith-Waterman speeds database searches six times over other SIMD
+ * implementations" (2007).
+ * The query is cut into as many segments as there are lanes, and lane l of
+ * vector k holds letter l * segmentLength + k of it. That way the vectors of
+ * a column depend on each other only through the gap along the query, which
+ * is added in a first pass as if it never crossed segments, and then carried
+ * across them until it improves no cell.
+ * The scores of matching every letter of the database against the query are
+ * laid out like that once, the profile, so a column only adds vectors.
+ * The lanes past the end of the query never affect the lanes before it,
+ * but they are checked for overflow like the others, see fitsLanes.
+ *
+ * The defined function gets:
+ * query The inner sequence, usually the shorter one, must not be empty.
+ * queryLen The length of the query.
+ * database The outer sequence, must not be empty.
+ * databaseLen The length of the database.
+ * matchScore, mismatchScore, gapScore The scores, must pass fitsLanes.
+ * edges The edges of the table, NULL if it's the whole table. They must fit the lanes too.
+ * context The context, its buffer is used.
+ * score The output score.
+ * and returns 0 on success, STRIPED_OVERFLOW if a score didn't fit the lanes,
+ * or -ENOMEM.
+ */
+#define DEFINE_STRIPED_KERNEL(name, isa, isaName, bits) \
+__attribute__((target(isaName))) \
+static int name(const char* query, size_t queryLen, const char* database, size_t databaseLen, \
+                long matchScore, long mismatchScore, long gapScore, const struct TableEdges* edges, \
+                struct ScoreContext* context, long* score) \
+{ \
+	int##bits##_t lanes[sizeof(isa##_VECTOR) * 8 / (bits)]; \
+	size_t numOfLanes = sizeof(lanes) / sizeof(lanes[0]); \
+	size_t segmentLength = (queryLen + numOfLanes - 1) / numOfLanes; \
+	unsigned char letters[UCHAR_MAX + 1]; \
+	int numOfLetters; \
+	int letter; \
+	isa##_VECTOR* profile; \
+	const isa##_VECTOR* columnProfile; \
+	isa##_VECTOR* loadRow; \
+	isa##_VECTOR* storeRow; \
+	isa##_VECTOR* swapRow; \
+	isa##_VECTOR value; \
+	isa##_VECTOR gapValue; \
+	isa##_VECTOR queryGap; \
+	isa##_VECTOR gap; \
+	isa##_VECTOR minimum; \
+	isa##_VECTOR maximum; \
+	isa##_VECTOR lowLimit; \
+	isa##_VECTOR highLimit; \
+	long diagonal; \
+	long left; \
+	size_t lastSegment = (queryLen - 1) % segmentLength; \
+	size_t lastLane = (queryLen - 1) / segmentLength; \
+	size_t i; \
+	size_t j; \
+	size_t k; \
+	size_t lane; \
+\
+	numOfLetters = mapLetters(query, queryLen, letters); \
+	profile = reserveBuffer(context, sizeof(isa##_VECTOR) * segmentLength * (numOfLetters + 2)); \
+	if(!profile) \
+	{ \
+		return -ENOMEM; \
+	} \
+	loadRow = profile + segmentLength * numOfLetters; \
+	storeRow = loadRow + segmentLength; \
+	for(letter = 0; letter < numOfLetters; letter++) \
+	{ \
+		for(k = 0; k < segmentLength; k++) \
+		{ \
+			for(lane = 0; lane < numOfLanes; lane++) \
+			{ \
+				i = lane * segmentLength + k; \
+				lanes[lane] = (int##bits##_t) (i >= queryLen ? 0 : \
+				                               letters[(unsigned char) query[i]] == letter ? matchScore : \
+				                               mismatchScore); \
+			} \
+			profile[segmentLength * letter + k] = isa##_LOAD(lanes); \
+		} \
+	} \
+	for(k = 0; k < segmentLength; k++) \
+	{ \
+		for(lane = 0; lane < numOfLanes; lane++) \
+		{ \
+			i = lane * segmentLength + k; \
+			lanes[lane] = (int##bits##_t) (i >= queryLen ? 0 : edges ? edges->top[i + 1] : gapScore * (long) (i + 1)); \
+		} \
+		loadRow[k] = isa##_LOAD(lanes); \
+	} \
+\
+	gap = isa##_SET(bits, gapScore); \
+	minimum = isa##_SET(bits, 0); \
+	maximum = minimum; \
+	lowLimit = isa##_SET(bits, STRIPED_MINIMUM_##bits + 1); \
+	highLimit = isa##_SET(bits, STRIPED_MAXIMUM_##bits - 1); \
+	left = edges ? edges->top[0] : 0; \
+	for(j = 0; j < databaseLen; j++) \
+	{ \
+		columnProfile = profile + segmentLength * letters[(unsigned char) database[j]]; \
+		diagonal = left; \
+		left = edges ? edges->left[j] : gapScore * (long) (j + 1); \
+		queryGap = isa##_SHIFT_IN(bits, isa##_SET(bits, STRIPED_MINIMUM_##bits), left + gapScore); \
+		value = isa##_SHIFT_IN(bits, loadRow[segmentLength - 1], diagonal); \
+		for(k = 0; k < segmentLength; k++) \
+		{ \
+			value = isa##_ADD(bits, value, columnProfile[k]); \
+			gapValue = isa##_ADD(bits, loadRow[k], gap); \
+			value = isa##_MAX(bits, value, gapValue); \
+			value = isa##_MAX(bits, value, queryGap); \
+			minimum = isa##_MIN(bits, minimum, value); \
+			maximum = isa##_MAX(bits, maximum, value); \
+			storeRow[k] = value; \
+			queryGap = isa##_ADD(bits, value, gap); \
+			value = loadRow[k]; \
+		} \
+\
+		queryGap = isa##_SHIFT_IN(bits, queryGap, STRIPED_MINIMUM_##bits); \
+		k = 0; \
+		while(isa##_ANY_GREATER(bits, queryGap, storeRow[k])) \
+		{ \
+			value = isa##_MAX(bits, storeRow[k], queryGap); \
+			maximum = isa##_MAX(bits, maximum, value); \
+			storeRow[k] = value; \
+			queryGap = isa##_ADD(bits, queryGap, gap); \
+			if(++k == segmentLength) \
+			{ \
+				queryGap = isa##_SHIFT_IN(bits, queryGap, STRIPED_MINIMUM_##bits); \
+				k = 0; \
+			} \
+		} \
+\
+		if(isa##_ANY_GREATER(bits, lowLimit, minimum) || isa##_ANY_GREATER(bits, maximum, highLimit)) \
+		{ \
+			return STRIPED_OVERFLOW; \
+		} \
+		if(edges) \
+		{ \
+			isa##_STORE(lanes, storeRow[lastSegment]); \
+			edges->right[j] = lanes[lastLane]; \
+		} \
+		swapRow = loadRow; \
+		loadRow = storeRow; \
+		storeRow = swapRow; \
+	} \
+	for(k = 0; edges && k < segmentLength; k++) \
+	{ \
+		isa##_STORE(lanes, loadRow[k]); \
+		for(lane = 0; lane < numOfLanes && lane * segmentLength + k < queryLen; lane++) \
+		{ \
+			edges->bottom[lane * segmentLength + k] = lanes[lane]; \
+		} \
+	} \
+	isa##_STORE(lanes, loadRow[lastSegment]); \
+	*score = lanes[lastLane]; \
+	return 0; \
+}
+
+DEFINE_STRIPED_KERNEL(calculateStripedSse41Byte, SSE41, "sse4.1", 8)
+DEFINE_STRIPED_KERNEL(calculateStripedSse41Short, SSE41, "sse4.1", 16)
+DEFINE_STRIPED_KERNEL(calculateStripedSse41Int, SSE41, "sse4.1", 32)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx2Byte, AVX2, "avx2", 8)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx2Short, AVX2, "avx2", 16)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx2Int, AVX2, "avx2", 32)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx512Byte, AVX512, "avx512f,avx512bw", 8)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx512Short, AVX512, "avx512f,avx512bw", 16)
+DEFINE_STRIPED_KERNEL(calculateStripedAvx512Int, AVX512, "avx512f,avx512bw", 32)
+
+/** The SSE4.1 kernels. */
+static const struct StripedEngine SSE41_ENGINE = {
+	ENGINE_SSE41, {calculateStripedSse41Byte, calculateStripedSse41Short, calculateStripedSse41Int}
+};
+
+/** The AVX2 kernels. */
+static const struct StripedEngine AVX2_ENGINE = {
+	ENGINE_AVX2, {calculateStripedAvx2Byte, calculateStripedAvx2Short, calculateStripedAvx2Int}
+};
+
+/** The AVX-512 kernels. */
+static const struct StripedEngine AVX512_ENGINE = {
+	ENGINE_AVX512, {calculateStripedAvx512Byte, calculateStripedAvx512Short, calculateStripedAvx512Int}
+};
+
+#endif
+
+/** The scalar kernels only. */
+static const struct StripedEngine SCALAR_ENGINE = {ENGINE_SCALAR, {NULL, NULL, NULL}};
+
+const struct StripedEngine* selectEngine(void)
+{
+#ifdef HAS_X86_KERNELS
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+	{
+		return &AVX512_ENGINE;
+	}
+	if(__builtin_cpu_supports("avx2"))
+	{
+		return &AVX2_ENGINE;
+	}
+	if(__builtin_cpu_supports("sse4.1"))
+	{
+		return &SSE41_ENGINE;
+	}
+#endif
+	return &SCALAR_ENGINE;
+}
+
+const struct StripedEngine* findEngine(const char* name)
+{
+	if(strcmp(name, ENGINE_SCALAR) == 0)
+	{
+		return &SCALAR_ENGINE;
+	}
+#ifdef HAS_X86_KERNELS
+	__builtin_cpu_init();
+	if(strcmp(name, ENGINE_SSE41) == 0 && __builtin_cpu_supports("sse4.1"))
+	{
+		return &SSE41_ENGINE;
+	}
+	if(strcmp(name, ENGINE_AVX2) == 0 && __builtin_cpu_supports("avx2"))
+	{
+		return &AVX2_ENGINE;
+	}
+	if(strcmp(name, ENGINE_AVX512) == 0 && __builtin_cpu_supports("avx512f") &&
+	   __builtin_cpu_supports("avx512bw"))
+	{
+		return &AVX512_ENGINE;
+	}
+#endif
+	return NULL;
+}
+
+int fitsLanes(int width, size_t queryLen, size_t databaseLen, unsigned long largestScore)
+{
+	size_t numOfScores;
+
+	if(width == STRIPED_WIDTH_32)
+	{
+		// the query is padded to a whole number of vectors, with fewer letters than there are lanes
+		numOfScores = queryLen + STRIPED_MOST_LANES[width] + databaseLen;
+	}
+	else
+	{
+		numOfScores = (queryLen > databaseLen ? queryLen : databaseLen) + 2;
+	}
+	return largestScore == 0 ||
+	       numOfScores <= (unsigned long) (STRIPED_LIMITS[width] - 1) / largestScore;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file stripedKernels.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the striped kernels of the comparison score, on the vectors
+ * of every instruction set.
+ */
+
+#ifndef STRIPED_KERNELS_H
+#define STRIPED_KERNELS_H
+
+
+/* --- Includes --- */
+
+#include <stddef.h>
+
+
+/* --- Constants --- */
+
+/** The names of the engines, see --engine. */
+#define ENGINE_SCALAR "scalar"
+#define ENGINE_SSE41 "sse4.1"
+#define ENGINE_AVX2 "avx2"
+#define ENGINE_AVX512 "avx512"
+
+/** The lane widths of the striped kernels, from the narrowest. */
+#define STRIPED_WIDTH_8 0
+#define STRIPED_WIDTH_16 1
+#define STRIPED_WIDTH_32 2
+
+/** How many lane widths there are. */
+#define NUM_OF_STRIPED_WIDTHS 3
+
+/** A striped kernel returns this if a score didn't fit its lanes. */
+#define STRIPED_OVERFLOW 1
+
+
+/* --- Structs --- */
+
+struct TableEdges;
+struct ScoreContext;
+
+/** The striped kernels of an instruction set, see DEFINE_STRIPED_KERNEL. */
+struct StripedEngine
+{
+	const char* name;
+	// by lane width, NULL if there are none
+	int (*kernels[NUM_OF_STRIPED_WIDTHS])(const char* query, size_t queryLen, const char* database,
+	                                      size_t databaseLen, long matchScore, long mismatchScore, long gapScore,
+	                                      const struct TableEdges* edges, struct ScoreContext* context,
+	                                      long* score);
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Selects the widest engine the processor supports.
+ *
+ * @return The engine.
+ */
+const struct StripedEngine* selectEngine(void);
+
+/**
+ * Finds an engine by its name.
+ *
+ * @param name The name of the engine.
+ * @return The engine, or NULL if it's unknown or the processor doesn't support it.
+ */
+const struct StripedEngine* findEngine(const char* name);
+
+/**
+ * Checks if the striped kernels of a lane width may calculate the score of two sequences.
+ * The scores and the first row and column must fit the lanes. The 8 and 16
+ * bit lanes find out by themselves if any other cell doesn't, but the 32 bit
+ * lanes don't saturate, so every cell must provably fit them. That includes
+ * the cells of the letters the query is padded with, which score 0.
+ *
+ * @param width The lane width, a STRIPED_WIDTH constant.
+ * @param queryLen The length of the query.
+ * @param databaseLen The length of the database.
+ * @param largestScore The largest magnitude of the scores.
+ * @return 1 if they may, 0 otherwise.
+ */
+int fitsLanes(int width, size_t queryLen, size_t databaseLen, unsigned long largestScore);
+
+#endif
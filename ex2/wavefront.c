@@ -0,0 +1,389 @@
+/**
+ * @file wavefront.c
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Implementation of the comparison score of two sequences in tiles, on several threads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+
+/* --- Includes --- */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "wavefront.h"
+#include "editDistance.h"
+
+
+/* --- Structs --- */
+
+/** A table calculated in tiles on several threads, see calculateWavefront. */
+struct Wavefront
+{
+	// along the rows
+	const char* outer;
+	size_t outerLen;
+	// along the columns
+	const char* inner;
+	size_t innerLen;
+	long matchScore;
+	long mismatchScore;
+	long gapScore;
+	// the striped kernel of the tiles, NULL for the scalar kernel of scoreSize
+	int (*kernel)(const char* query, size_t queryLen, const char* database, size_t databaseLen, long matchScore,
+	              long mismatchScore, long gapScore, const struct TableEdges* edges, struct ScoreContext* context,
+	              long* score);
+	size_t scoreSize;
+	// the edit distance of the tiles instead of the kernels, NULL if the scores don't rank like it, see isEditDistanceScore
+	struct EditDistance* editDistance;
+	// the edit distance, the tiles of the last row add their changes to it
+	long distance;
+	size_t numOfRows;
+	size_t numOfColumns;
+	// the last row of the last tile done in every column of tiles, and the cell above and left of the next tile
+	long* bottoms;
+	long* corners;
+	// the last column of the last tile done in every row of tiles
+	long* rights;
+	// the score of the last tile, the whole score
+	long score;
+	// by worker
+	struct ScoreContext* contexts;
+	// the fields below are guarded by the lock
+	pthread_mutex_t lock;
+	pthread_cond_t tileDone;
+	// how many tiles of every row are done
+	size_t* progress;
+	size_t nextRow;
+	// the first error, 0 if there's none
+	int ret;
+};
+
+/** A wavefront worker thread. */
+struct WavefrontWorker
+{
+	struct Wavefront* wavefront;
+	int index;
+};
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates one tile of a wavefront, from the edges its neighbors left.
+ * The tile leaves its own last row and last column in their place.
+ * If the tile overflows the lanes it is calculated again with the scalar kernel.
+ * A tile of the edit distance is a block of words, it leaves its carries and
+ * the words it moved instead.
+ *
+ * @param wavefront The wavefront.
+ * @param row The row of the tile.
+ * @param column The column of the tile.
+ * @param top A buffer of at least WAVEFRONT_TILE_SIZE + 1 longs.
+ * @param left A buffer of at least WAVEFRONT_TILE_SIZE longs.
+ * @param context The context of the worker.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+static int calculateTile(struct Wavefront* wavefront, size_t row, size_t column, long* top, long* left,
+                         struct ScoreContext* context)
+{
+	struct TableEdges edges;
+	size_t firstRow = row * WAVEFRONT_TILE_SIZE;
+	size_t firstColumn = column * WAVEFRONT_TILE_SIZE;
+	size_t numOfRows = wavefront->outerLen - firstRow;
+	size_t numOfColumns = wavefront->innerLen - firstColumn;
+	long corner;
+	long score;
+	void* buffer;
+	int ret = 0;
+
+	if(numOfRows > WAVEFRONT_TILE_SIZE)
+	{
+		numOfRows = WAVEFRONT_TILE_SIZE;
+	}
+	if(numOfColumns > WAVEFRONT_TILE_SIZE)
+	{
+		numOfColumns = WAVEFRONT_TILE_SIZE;
+	}
+	if(wavefront->editDistance)
+	{
+		// the last row of tiles is done by a single worker, so it alone changes the distance
+		wavefront->distance += advanceEditDistance(wavefront->editDistance, firstRow, firstRow + numOfRows,
+		                                           firstColumn, firstColumn + numOfColumns);
+		return 0;
+	}
+	top[0] = wavefront->corners[column];
+	memcpy(top + 1, wavefront->bottoms + firstColumn, sizeof(long) * numOfColumns);
+	// the cell above and to the left of the tile below, before the last column overwrites it
+	corner = wavefront->rights[firstRow + numOfRows - 1];
+	edges.top = top;
+	edges.left = wavefront->rights + firstRow;
+	edges.bottom = wavefront->bottoms + firstColumn;
+	edges.right = wavefront->rights + firstRow;
+
+	if(wavefront->kernel)
+	{
+		// the kernel writes the last column over the left edge, which is needed again if it overflows
+		memcpy(left, edges.left, sizeof(long) * numOfRows);
+		edges.left = left;
+		ret = wavefront->kernel(wavefront->inner + firstColumn, numOfColumns, wavefront->outer + firstRow,
+		                        numOfRows, wavefront->matchScore, wavefront->mismatchScore, wavefront->gapScore,
+		                        &edges, context, &score);
+		if(ret < 0)
+		{
+			return ret;
+		}
+	}
+	if(!wavefront->kernel || ret == STRIPED_OVERFLOW)
+	{
+		buffer = reserveBuffer(context, sizeof(long) * (numOfColumns + 1));
+		if(!buffer)
+		{
+			return -ENOMEM;
+		}
+		score = calculateScalarScore(wavefront->scoreSize, wavefront->outer + firstRow, numOfRows,
+		                             wavefront->inner + firstColumn, numOfColumns, wavefront->matchScore,
+		                             wavefront->mismatchScore, wavefront->gapScore, &edges, buffer);
+	}
+	wavefront->corners[column] = corner;
+	if(row == wavefront->numOfRows - 1 && column == wavefront->numOfColumns - 1)
+	{
+		wavefront->score = score;
+	}
+	return 0;
+}
+
+/**
+ * Calculates rows of tiles of a wavefront until every row was taken.
+ * A tile waits only for the tile above it, the tile to its left was done
+ * by the same worker just before.
+ *
+ * @param wavefront The wavefront.
+ * @param worker The index of the worker.
+ */
+static void runWavefrontWorker(struct Wavefront* wavefront, int worker)
+{
+	long* top = malloc(sizeof(long) * (WAVEFRONT_TILE_SIZE + 1));
+	long* left = malloc(sizeof(long) * WAVEFRONT_TILE_SIZE);
+	size_t row;
+	size_t column;
+	int ret;
+
+	pthread_mutex_lock(&wavefront->lock);
+	if(!top || !left)
+	{
+		wavefront->ret = -ENOMEM;
+	}
+	while(wavefront->ret == 0 && wavefront->nextRow < wavefront->numOfRows)
+	{
+		row = wavefront->nextRow++;
+		for(column = 0; column < wavefront->numOfColumns; column++)
+		{
+			while(wavefront->ret == 0 && row > 0 && wavefront->progress[row - 1] <= column)
+			{
+				pthread_cond_wait(&wavefront->tileDone, &wavefront->lock);
+			}
+			if(wavefront->ret != 0)
+			{
+				break;
+			}
+			pthread_mutex_unlock(&wavefront->lock);
+			ret = calculateTile(wavefront, row, column, top, left, &wavefront->contexts[worker]);
+			pthread_mutex_lock(&wavefront->lock);
+			if(ret != 0)
+			{
+				wavefront->ret = ret;
+			}
+			wavefront->progress[row]++;
+			pthread_cond_broadcast(&wavefront->tileDone);
+		}
+	}
+	pthread_mutex_unlock(&wavefront->lock);
+	free(top);
+	free(left);
+}
+
+/**
+ * The main function of a wavefront worker thread.
+ *
+ * @param arg The worker.
+ * @return Always NULL.
+ */
+static void* wavefrontWorkerMain(void* arg)
+{
+	struct WavefrontWorker* worker = arg;
+
+	runWavefrontWorker(worker->wavefront, worker->index);
+	return NULL;
+}
+
+int calculateWavefront(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                       long matchScore, long mismatchScore, long gapScore, int numOfThreads,
+                       struct ScoreContext* context, long* score)
+{
+	struct Wavefront wavefront;
+	struct EditDistance editDistance;
+	struct WavefrontWorker* workers;
+	pthread_t* threads;
+	struct PathStats* path;
+	double start = 0;
+	long editScore;
+	size_t i;
+	int worker;
+	int numOfWorkers;
+	int isEditDistance;
+	int isAllocated;
+
+	if(str2Len > str1Len)
+	{
+		return calculateWavefront(str2, str2Len, str1, str1Len, matchScore, mismatchScore, gapScore, numOfThreads,
+		                          context, score);
+	}
+	isEditDistance = isEditDistanceScore(str1Len + str2Len, matchScore, mismatchScore, gapScore, &editScore);
+	if(str2Len <= WAVEFRONT_TILE_SIZE || (isEditDistance && editScore == 0))
+	{
+		// a single column of tiles would be calculated in order anyway, and without a cost for edits there's no table
+		return calculateScore(str1, str1Len, str2, str2Len, matchScore, mismatchScore, gapScore, context, score);
+	}
+
+	memset(&wavefront, 0, sizeof(wavefront));
+	wavefront.matchScore = matchScore;
+	wavefront.mismatchScore = mismatchScore;
+	wavefront.gapScore = gapScore;
+	if(isEditDistance)
+	{
+		// the shorter sequence is the pattern, its words are cut into the rows of tiles like calculateScore keeps them
+		wavefront.outer = str2;
+		wavefront.outerLen = str2Len;
+		wavefront.inner = str1;
+		wavefront.innerLen = str1Len;
+		wavefront.ret = initEditDistance(&editDistance, str2, str2Len, str1, context);
+		editDistance.carries = malloc(str1Len);
+		wavefront.editDistance = &editDistance;
+		wavefront.distance = (long) str2Len;
+	}
+	else
+	{
+		wavefront.outer = str1;
+		wavefront.outerLen = str1Len;
+		wavefront.inner = str2;
+		wavefront.innerLen = str2Len;
+		wavefront.kernel = context->engine->kernels[STRIPED_WIDTH_32];
+		if(!fitsLanes(STRIPED_WIDTH_32, str2Len, str1Len, getLargestScore(matchScore, mismatchScore, gapScore)))
+		{
+			wavefront.kernel = NULL;
+		}
+		wavefront.scoreSize = selectScoreSize(str1Len + str2Len, matchScore, mismatchScore, gapScore);
+		wavefront.bottoms = malloc(sizeof(long) * str2Len);
+		wavefront.corners = malloc(sizeof(long) * ((str2Len + WAVEFRONT_TILE_SIZE - 1) / WAVEFRONT_TILE_SIZE));
+		wavefront.rights = malloc(sizeof(long) * str1Len);
+	}
+	wavefront.numOfRows = (wavefront.outerLen + WAVEFRONT_TILE_SIZE - 1) / WAVEFRONT_TILE_SIZE;
+	wavefront.numOfColumns = (wavefront.innerLen + WAVEFRONT_TILE_SIZE - 1) / WAVEFRONT_TILE_SIZE;
+	numOfWorkers = (size_t) numOfThreads < wavefront.numOfRows ? numOfThreads : (int) wavefront.numOfRows;
+
+	wavefront.progress = calloc(wavefront.numOfRows, sizeof(size_t));
+	wavefront.contexts = malloc(sizeof(struct ScoreContext) * numOfWorkers);
+	workers = malloc(sizeof(struct WavefrontWorker) * numOfWorkers);
+	threads = malloc(sizeof(pthread_t) * numOfWorkers);
+	if(isEditDistance)
+	{
+		isAllocated = wavefront.ret == 0 && editDistance.carries;
+	}
+	else
+	{
+		isAllocated = wavefront.bottoms && wavefront.corners && wavefront.rights;
+	}
+	if(isAllocated && wavefront.progress && wavefront.contexts && workers && threads)
+	{
+		if(!isEditDistance)
+		{
+			for(i = 0; i < str2Len; i++)
+			{
+				wavefront.bottoms[i] = gapScore * (long) (i + 1);
+			}
+			for(i = 0; i < wavefront.numOfColumns; i++)
+			{
+				wavefront.corners[i] = gapScore * (long) (i * WAVEFRONT_TILE_SIZE);
+			}
+			for(i = 0; i < str1Len; i++)
+			{
+				wavefront.rights[i] = gapScore * (long) (i + 1);
+			}
+		}
+		pthread_mutex_init(&wavefront.lock, NULL);
+		pthread_cond_init(&wavefront.tileDone, NULL);
+		if(context->measure)
+		{
+			start = getSeconds();
+		}
+
+		for(worker = 0; worker < numOfWorkers; worker++)
+		{
+			initScoreContext(&wavefront.contexts[worker], context->engine, 0);
+			workers[worker].wavefront = &wavefront;
+			workers[worker].index = worker;
+		}
+		for(numOfThreads = 1; numOfThreads < numOfWorkers; numOfThreads++)
+		{
+			if(pthread_create(&threads[numOfThreads], NULL, wavefrontWorkerMain, &workers[numOfThreads]) != 0)
+			{
+				// the started workers and this thread still take every row
+				break;
+			}
+		}
+		runWavefrontWorker(&wavefront, 0);
+		for(worker = 1; worker < numOfThreads; worker++)
+		{
+			pthread_join(threads[worker], NULL);
+		}
+
+		if(isEditDistance)
+		{
+			path = &context->paths[PATH_BIT_PARALLEL];
+		}
+		else
+		{
+			path = &context->paths[wavefront.kernel ? STRIPED_WIDTH_32 : PATH_SCALAR];
+		}
+		if(context->measure)
+		{
+			path->seconds += getSeconds() - start;
+		}
+		path->numOfPairs++;
+		path->numOfCells += (double) str1Len * (double) str2Len;
+		for(worker = 0; worker < numOfWorkers; worker++)
+		{
+			cleanupScoreContext(&wavefront.contexts[worker]);
+		}
+		pthread_cond_destroy(&wavefront.tileDone);
+		pthread_mutex_destroy(&wavefront.lock);
+		if(isEditDistance)
+		{
+			*score = (editScore + gapScore) * (long) (str1Len + str2Len) - editScore * wavefront.distance;
+		}
+		else
+		{
+			*score = wavefront.score;
+		}
+	}
+	else
+	{
+		wavefront.ret = -ENOMEM;
+	}
+	if(isEditDistance)
+	{
+		free(editDistance.carries);
+	}
+	free(wavefront.bottoms);
+	free(wavefront.corners);
+	free(wavefront.rights);
+	free(wavefront.progress);
+	free(wavefront.contexts);
+	free(workers);
+	free(threads);
+	return wavefront.ret;
+}
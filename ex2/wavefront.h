@@ -0,0 +1,52 @@
+/**
+ * @file wavefront.h
+ * @author Aviad Nissel <aviad.nissel@mail.huji.ac.il>
+ *
+ * Header for the comparison score of two sequences in tiles, on several threads.
+ */
+
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+
+/* --- Includes --- */
+
+#include "CompareSequences.h"
+
+
+/* --- Constants --- */
+
+/** The number of rows and columns of a tile of a wavefront. */
+#define WAVEFRONT_TILE_SIZE 4096
+
+
+/* --- Functions --- */
+
+/**
+ * Calculates the comparision score of two sequences on several threads.
+ * The table is cut into square tiles. The tiles of a row are calculated in
+ * order by one worker, and the workers take the rows in order, so the tiles
+ * on an anti-diagonal are calculated together. Only the last row and the
+ * last column of every tile are kept, for the tiles below it and to its right.
+ * The tiles are calculated with the 32 bit striped kernel when it holds
+ * every cell, and with the scalar kernels otherwise. Scores like the edit
+ * distance are calculated with the bit-parallel edit distance instead, a
+ * row of tiles is a block of 64 of its words, see isEditDistanceScore.
+ *
+ * @param str1 The first sequence.
+ * @param str1Len The length of the first sequence.
+ * @param str2 The second sequence.
+ * @param str2Len The length of the second sequence.
+ * @param matchScore The match score.
+ * @param mismatchScore The mismatch score.
+ * @param gapScore The gap score.
+ * @param numOfThreads How many threads to calculate on.
+ * @param context How to calculate, receives the path. The time is the time of all the threads together.
+ * @param score The output score.
+ * @return 0 on success, -ENOMEM if there's not enough memory.
+ */
+int calculateWavefront(const char* str1, size_t str1Len, const char* str2, size_t str2Len,
+                       long matchScore, long mismatchScore, long gapScore, int numOfThreads,
+                       struct ScoreContext* context, long* score);
+
+#endif